@@ -1,6 +1,20 @@
-#include "file_reader.hpp"
-#include "entropy_calculator.hpp"
-#include "block_entropy_scanner.hpp"
+#include "file_analyzer.hpp"
+#include "scan_daemon.hpp"
+#include "file_watcher.hpp"
+#include "delta_scanner.hpp"
+#include "summary_aggregate.hpp"
+#include "io_scheduler.hpp"
+#include "partial_report.hpp"
+#include "buffer_pool.hpp"
+#include "result_spool.hpp"
+#include "scan_checkpoint.hpp"
+#include "archive_scanner.hpp"
+#include <algorithm>
+#include <csignal>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <iostream>
 #include <string>
 #include <iomanip>
@@ -14,10 +28,281 @@
 namespace fs = std::filesystem;
 using json = nlohmann::json;
 
+static ScanDaemon* g_daemon = nullptr;
+
+static void handle_daemon_signal(int) {
+    if (g_daemon) g_daemon->stop();
+}
+
+// entropix_cli --daemon <socket> [--workers N] [--max-requests N] [--max-connections N] [--cache-size N]
+static int run_daemon(int argc, char* argv[]) {
+    DaemonOptions options;
+    options.workers = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Error: " << arg << " requires a value.\n";
+            return 1;
+        }
+        if (arg == "--daemon") {
+            options.socket_path = argv[++i];
+        } else if (arg == "--workers") {
+            options.workers = std::stoul(argv[++i]);
+        } else if (arg == "--max-requests") {
+            options.max_requests = std::stoul(argv[++i]);
+        } else if (arg == "--max-connections") {
+            options.max_connections = std::stoul(argv[++i]);
+        } else if (arg == "--cache-size") {
+            options.cache_entries = std::stoul(argv[++i]);
+        } else {
+            std::cerr << "Unknown daemon option: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    ScanDaemon daemon(options);
+    if (!daemon.start()) {
+        std::cerr << "Error: " << daemon.get_error_message() << "\n";
+        return 1;
+    }
+    g_daemon = &daemon;
+    std::signal(SIGINT, handle_daemon_signal);
+    std::signal(SIGTERM, handle_daemon_signal);
+    std::cout << "Listening on " << options.socket_path << "\n" << std::flush;
+    daemon.run();
+    g_daemon = nullptr;
+    return 0;
+}
+
+static volatile std::sig_atomic_t g_watch_stop = 0;
+
+static void handle_watch_signal(int) {
+    g_watch_stop = 1;
+}
+
+// Emits one JSON line when a file starts or stops meeting the threshold.
+static void emit_watch_event(std::ostream& out, const std::string& event,
+                             const std::string& path, bool initial, const json* entry) {
+    json line;
+    line["event"] = event;
+    line["path"] = path;
+    line["initial"] = initial;
+    line["time_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    if (entry) line["entry"] = *entry;
+    out << line.dump() << std::endl;
+}
+
+// Initial scan, then re-analyze only files reported by the watcher until interrupted.
+static int run_watch(const fs::path& input_path, bool recursive, const std::string& extension,
+                     const ScanOptions& options, int debounce_ms, std::ostream& out) {
+    FileWatcher watcher(input_path, recursive, std::chrono::milliseconds(debounce_ms));
+    if (!watcher.start()) {
+        std::cerr << "Error: " << watcher.get_error_message() << "\n";
+        return 1;
+    }
+    if (watcher.get_unwatched_count() > 0) {
+        std::cerr << "Warning: " << watcher.get_unwatched_count()
+                  << " directories could not be watched: " << watcher.get_error_message() << "\n";
+    }
+    std::signal(SIGINT, handle_watch_signal);
+    std::signal(SIGTERM, handle_watch_signal);
+
+    FileAnalyzer analyzer;
+    std::unordered_map<std::string, bool> above;  // last known state per file
+
+    auto analyze = [&](const fs::path& path, bool initial) {
+        std::string key = path.string();
+        auto it = above.find(key);
+        bool was_above = it != above.end() && it->second;
+        if (!analyzer.analyze(key, options)) {
+            // unreadable (or deleted meanwhile); it no longer meets the threshold as far as we know
+            if (was_above) {
+                emit_watch_event(out, "below", key, initial, nullptr);
+            }
+            above.erase(key);
+            return;
+        }
+        bool now_above = analyzer.has_entry();
+        if (now_above && !was_above) {
+            emit_watch_event(out, "above", key, initial, &analyzer.get_entry());
+        } else if (!now_above && was_above) {
+            emit_watch_event(out, "below", key, initial, nullptr);
+        }
+        above[key] = now_above;
+    };
+    // forgets @p path, or everything under it for a directory, reporting files that were above
+    auto remove = [&](const fs::path& path) {
+        std::string dir = path.string() + "/";
+        for (auto it = above.begin(); it != above.end();) {
+            if (it->first != path.string() && it->first.compare(0, dir.size(), dir) != 0) {
+                ++it;
+                continue;
+            }
+            if (it->second) {
+                emit_watch_event(out, "removed", it->first, false, nullptr);
+            }
+            it = above.erase(it);
+        }
+    };
+    auto full_scan = [&](bool initial) {
+        analyzer.revalidate_directory();
+        try {
+            std::unordered_set<std::string> seen;
+            for (const fs::path& path : utils::collect_files(input_path, recursive, extension)) {
+                analyze(path, initial);
+                seen.insert(path.string());
+            }
+            // deletions may have been among the events lost to an overflow
+            std::vector<std::string> gone;
+            for (const auto& [key, state] : above) {
+                if (!seen.count(key)) gone.push_back(key);
+            }
+            for (const std::string& key : gone) {
+                remove(key);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    };
+
+    full_scan(true);
+    while (!g_watch_stop) {
+        std::vector<fs::path> ready = watcher.poll(1000);
+        analyzer.revalidate_directory();  // directories may have been renamed since the last batch
+        for (const fs::path& path : watcher.take_removed()) {
+            remove(path);
+        }
+        for (const fs::path& path : ready) {
+            if (!extension.empty() && path.extension() != extension) continue;
+            analyze(path, false);
+        }
+        if (watcher.take_overflow()) {
+            std::cerr << "Warning: event queue overflowed; rescanning\n";
+            full_scan(false);
+        }
+    }
+    return 0;
+}
+
+static volatile std::sig_atomic_t g_scan_stop = 0;
+
+// First signal stops the scan at the next chunk so a checkpoint can be written;
+// a second one terminates as usual.
+static void handle_scan_signal(int signal) {
+    g_scan_stop = 1;
+    std::signal(signal, SIG_DFL);
+}
+
+// entropix_cli merge <out> <part>...
+static int run_merge(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " merge <out> <part>...\n";
+        return 1;
+    }
+    PartialReportMerger merger;
+    for (int i = 3; i < argc; ++i) {
+        std::ifstream in(argv[i]);
+        json part = json::parse(in, nullptr, false);
+        if (!in.is_open() || part.is_discarded()) {
+            std::cerr << "Error: cannot read partial report " << argv[i] << "\n";
+            return 1;
+        }
+        if (!merger.add(part)) {
+            std::cerr << "Error: " << argv[i] << ": " << merger.get_error_message() << "\n";
+            return 1;
+        }
+    }
+    json merged;
+    if (!merger.finish(merged)) {
+        std::cerr << "Error: " << merger.get_error_message() << "\n";
+        return 1;
+    }
+    for (const std::string& error : merger.get_file_errors()) {
+        std::cerr << "Error reading file: " << error << "\n";
+    }
+    std::ofstream report(argv[2]);
+    if (!report) {
+        std::cerr << "Error: cannot open " << argv[2] << "\n";
+        return 1;
+    }
+    utils::write_json_output(report, merged);
+    std::cout << "Report written to " << argv[2] << "\n";
+    return 0;
+}
+
+// Scans this shard's files and ranges and writes its partial report.
+static void run_shard(const fs::path& input_path, const std::vector<fs::path>& files,
+                      const ScanOptions& options, const ShardSpec& spec, uint64_t split_bytes,
+                      IoScheduler& scheduler, std::ostream& out) {
+    ShardPlanner planner(spec, split_bytes, options.block_size);
+
+    // collect_files() sorts the list, so positions in it agree across shards and hosts
+    std::vector<size_t> owned;
+    std::vector<fs::path> owned_paths;
+    std::vector<std::string> keys;
+    std::vector<uint64_t> sizes;
+    std::vector<std::vector<ShardRange>> ranges;
+    const bool scanning_directory = fs::is_directory(input_path);
+    for (size_t i = 0; i < files.size(); ++i) {
+        std::string key = scanning_directory
+            ? files[i].lexically_relative(input_path).generic_string()
+            : files[i].filename().string();
+        std::error_code ec;
+        uint64_t size = fs::file_size(files[i], ec);
+        // an unreadable file is owned like a small one, so exactly one shard reports it
+        std::vector<ShardRange> assigned = planner.assign(key, ec ? 1 : size);
+        if (assigned.empty()) continue;
+        owned.push_back(i);
+        owned_paths.push_back(files[i]);
+        keys.push_back(std::move(key));
+        sizes.push_back(ec ? 0 : size);
+        ranges.push_back(std::move(assigned));
+    }
+
+    std::vector<PartialScanner> scanners(scheduler.get_jobs());
+    std::vector<json> results(owned.size());
+    std::vector<std::string> errors(owned.size());
+    scheduler.run(owned_paths, [&](size_t worker, size_t index) {
+        PartialScanner& scanner = scanners[worker];
+        if (!scanner.scan(owned_paths[index].native(), ranges[index], options, results[index])) {
+            errors[index] = scanner.get_error_message();
+        }
+    });
+
+    PartialReport report(spec, options, planner.get_split_bytes());
+    for (size_t i = 0; i < owned.size(); ++i) {
+        const std::string path = owned_paths[i].string();
+        if (!errors[i].empty()) {
+            std::cerr << "Error reading file: " << errors[i] << "\n";
+            report.add_error(keys[i], path, owned[i], errors[i]);
+        } else {
+            report.add_file(keys[i], path, owned[i], sizes[i], std::move(results[i]));
+        }
+    }
+    // compact: a partial is read by merge, not by people, and holds 256 counts per range
+    out << report.to_json().dump() << "\n";
+}
+
+// adds a file's entry to the spool, completing it if its blocks were streamed there
+static bool spool_entry(ResultSpool& spool, size_t index, const FileAnalyzer& analyzer) {
+    if (analyzer.get_sunk_block_count() > 0) {
+        return spool.end_blocks(index, analyzer.get_entry());
+    }
+    return spool.add(index, analyzer.get_entry());
+}
+
+static bool spool_entry(ResultSpool& spool, size_t index, const DeltaScanner& scanner) {
+    return spool.add(index, scanner.get_entry());
+}
+
 int main(int argc, char* argv[]) {
     std::string help_str = R"(
     Usage:
         entropix_cli <path> [options]
+        entropix_cli --daemon <socket> [daemon options]
+        entropix_cli merge <out> <part>...
     
     Arguments:
         <path>                     File or directory to scan
@@ -30,7 +315,28 @@ int main(int argc, char* argv[]) {
         --extension, -e <.ext>     Only include files with the given extension (e.g. .bin)
         --output, -o <file>        Write JSON report to file
         --verbose, -v              Print per-file entropy to stdout
+        --watch, -w                Scan once, then stream threshold-crossing events as files change
+        --debounce <ms>            Quiet time before a changed file is re-analyzed (default: 500)
+        --delta-cache <file>       Keep per-block fingerprints in <file> and only re-read changed blocks
+        --summary, -s              Write fixed-size aggregates instead of one entry per file
+        --top-k <n>                Highest-entropy files kept in the summary (default: 100)
+        --jobs, -j <n>             Files analyzed in parallel (default: 1)
+        --io-order <order>         File visiting order: dir, inode or extent (default: inode)
+        --shard <i/N>              Scan only shard i (0-based) of N and write a partial report
+        --shard-split <bytes>      Files this large are split into ranges across shards (default: 268435456)
+        --max-memory <size>        Cap read buffers and buffered results (e.g. 512M); results spill to $TMPDIR
+        --checkpoint <file>        Periodically record scan progress in <file> (entries stream to <file>.journal)
+        --checkpoint-interval <s>  Seconds between checkpoint writes (default: 60)
+        --resume                   Continue the scan recorded in the --checkpoint file
+        --archives                 Scan the members of tar archives (also nested) as <archive>!<member>
         --help                     Show this message
+
+    Daemon options:
+        --daemon <socket>          Serve JSON-line scan requests on a Unix domain socket
+        --workers <n>              Analysis threads (default: hardware concurrency)
+        --max-requests <n>         Requests processed concurrently (default: 8)
+        --max-connections <n>      Clients connected at once; more are refused (default: 64)
+        --cache-size <n>           Cached file results (default: 65536, 0 disables)
     )";  
     if (argc < 2 || std::string(argv[1]) == "--help") {
         if (argc < 2) {
@@ -40,6 +346,12 @@ int main(int argc, char* argv[]) {
         std::cout << help_str << std::endl; 
         return 0;
     }
+    if (std::string(argv[1]) == "--daemon") {
+        return run_daemon(argc, argv);
+    }
+    if (std::string(argv[1]) == "merge") {
+        return run_merge(argc, argv);
+    }
     fs::path input_path = argv[1];
     std::vector<fs::path> files;
     double entropy_threshold = -1.0;
@@ -48,6 +360,22 @@ int main(int argc, char* argv[]) {
     std::string extension;
     bool recursive = false;
     std::string out_path = utils::make_report_filename();
+    bool out_path_given = false;
+    bool watch = false;
+    std::string delta_cache_path;
+    bool summary_mode = false;
+    int top_k = 100;
+    int debounce_ms = 500;
+    int jobs = 1;
+    IoOrder io_order = IoOrder::Inode;
+    bool sharded = false;
+    ShardSpec shard;
+    uint64_t shard_split = ShardPlanner::kDefaultSplitBytes;
+    uint64_t max_memory = 0;
+    std::string checkpoint_path;
+    double checkpoint_interval = 60.0;
+    bool resume = false;
+    bool archives = false;
 
     for (int i = 2; i < argc; ++i) {
         std::string arg = argv[i];
@@ -76,6 +404,7 @@ int main(int argc, char* argv[]) {
         } else if (arg == "--output" || arg == "-o") {
             if (i + 1 < argc) { 
                 out_path = argv[++i];
+                out_path_given = true;
             }
             else { 
                 std::cerr << "Error: --output requires a value.\n"; 
@@ -85,6 +414,93 @@ int main(int argc, char* argv[]) {
             if (i + 1 < argc) {
                 extension = argv[++i];
             }
+        } else if (arg == "--watch" || arg == "-w") {
+            watch = true;
+        } else if (arg == "--debounce") {
+            if (i + 1 < argc) {
+                debounce_ms = std::stoi(argv[++i]);
+            }
+            else {
+                std::cerr << "Error: --debounce requires a value.\n";
+                exit(1);
+            }
+        } else if (arg == "--delta-cache") {
+            if (i + 1 < argc) {
+                delta_cache_path = argv[++i];
+            }
+            else {
+                std::cerr << "Error: --delta-cache requires a value.\n";
+                exit(1);
+            }
+        } else if (arg == "--summary" || arg == "-s") {
+            summary_mode = true;
+        } else if (arg == "--top-k") {
+            if (i + 1 < argc) {
+                top_k = std::stoi(argv[++i]);
+            }
+            else {
+                std::cerr << "Error: --top-k requires a value.\n";
+                exit(1);
+            }
+        } else if (arg == "--jobs" || arg == "-j") {
+            if (i + 1 < argc) {
+                jobs = std::stoi(argv[++i]);
+            }
+            else {
+                std::cerr << "Error: --jobs requires a value.\n";
+                exit(1);
+            }
+        } else if (arg == "--io-order") {
+            std::string order = i + 1 < argc ? argv[++i] : "";
+            if (order == "dir") {
+                io_order = IoOrder::Directory;
+            } else if (order == "inode") {
+                io_order = IoOrder::Inode;
+            } else if (order == "extent") {
+                io_order = IoOrder::Extent;
+            } else {
+                std::cerr << "Error: --io-order must be dir, inode or extent.\n";
+                exit(1);
+            }
+        } else if (arg == "--shard") {
+            if (i + 1 >= argc || !ShardSpec::parse(argv[++i], shard)) {
+                std::cerr << "Error: --shard requires i/N with 0 <= i < N.\n";
+                exit(1);
+            }
+            sharded = true;
+        } else if (arg == "--shard-split") {
+            if (i + 1 < argc) {
+                shard_split = std::stoull(argv[++i]);
+            }
+            else {
+                std::cerr << "Error: --shard-split requires a value.\n";
+                exit(1);
+            }
+        } else if (arg == "--max-memory") {
+            if (i + 1 >= argc || !utils::parse_size(argv[++i], max_memory) || max_memory == 0) {
+                std::cerr << "Error: --max-memory requires a size such as 512M.\n";
+                exit(1);
+            }
+        } else if (arg == "--checkpoint") {
+            if (i + 1 < argc) {
+                checkpoint_path = argv[++i];
+            }
+            else {
+                std::cerr << "Error: --checkpoint requires a value.\n";
+                exit(1);
+            }
+        } else if (arg == "--checkpoint-interval") {
+            if (i + 1 < argc) {
+                checkpoint_interval = std::stod(argv[++i]);
+            }
+            else {
+                std::cerr << "Error: --checkpoint-interval requires a value.\n";
+                exit(1);
+            }
+        } else if (arg == "--resume") {
+            resume = true;
+        } else if (arg == "--archives") {
+            archives = true;
         } else if (arg == "--help") { 
             std::cout << help_str << std::endl;
             return 0;
@@ -103,22 +519,74 @@ int main(int argc, char* argv[]) {
         std::cerr << "Error: --block-scan must be >= 0.\n";
         return 1;
     }
+    if (top_k < 0) {
+        std::cerr << "Error: --top-k must be >= 0.\n";
+        return 1;
+    }
+    if (debounce_ms < 0) {
+        std::cerr << "Error: --debounce must be >= 0.\n";
+        return 1;
+    }
+    if (jobs < 1) {
+        std::cerr << "Error: --jobs must be >= 1.\n";
+        return 1;
+    }
+    if (sharded && (watch || summary_mode || !delta_cache_path.empty())) {
+        std::cerr << "Error: --shard cannot be combined with --watch, --summary or --delta-cache.\n";
+        return 1;
+    }
+    if (resume && checkpoint_path.empty()) {
+        std::cerr << "Error: --resume requires --checkpoint <file>.\n";
+        return 1;
+    }
+    if (!checkpoint_path.empty() && (watch || sharded || !delta_cache_path.empty())) {
+        std::cerr << "Error: --checkpoint cannot be combined with --watch, --shard or --delta-cache.\n";
+        return 1;
+    }
+    if (archives && (watch || sharded || !delta_cache_path.empty())) {
+        std::cerr << "Error: --archives cannot be combined with --watch, --shard or --delta-cache.\n";
+        return 1;
+    }
+    if (checkpoint_interval < 0.0) {
+        std::cerr << "Error: --checkpoint-interval must be >= 0.\n";
+        return 1;
+    }
     if (!extension.empty() && extension[0] != '.')
         extension = "." + extension;
 
-    
+    ScanOptions options;
+    options.entropy_threshold = entropy_threshold;
+    options.block_size = static_cast<size_t>(block_size);
+
+    if (watch) {
+        if (!fs::exists(input_path)) {
+            std::cerr << "Error: File or directory does not exist.\n";
+            return 1;
+        }
+        // events stream to stdout unless an output file was requested
+        if (!out_path_given) {
+            return run_watch(input_path, recursive, extension, options, debounce_ms, std::cout);
+        }
+        std::ofstream events(out_path);
+        if (!events) {
+            std::cerr << "Error: cannot open " << out_path << "\n";
+            return 1;
+        }
+        return run_watch(input_path, recursive, extension, options, debounce_ms, events);
+    }
+
     std::ofstream report(out_path);
     if (!report) {
         std::cerr << "Error: cannot open " << out_path << "\n";
         return 1;
     }
 
-    // collect files (honoring --recursive)
+    // collect files (honoring --recursive); summary mode streams them instead
     try {
         if (!fs::exists(input_path)) {
             throw std::invalid_argument("File or directory does not exist.");
         }
-        else {
+        else if (!summary_mode) {
             files = utils::collect_files(input_path, recursive, extension);
         }
     } catch (const std::exception& e) {
@@ -126,52 +594,288 @@ int main(int argc, char* argv[]) {
         exit(1);
     }
 
-    json jresults = json::array();
+    IoSchedulerOptions io_options;
+    io_options.jobs = static_cast<size_t>(jobs);
+    io_options.order = io_order;
+    if (!delta_cache_path.empty() && jobs > 1) {
+        std::cerr << "Warning: --delta-cache scans with a single job\n";
+        io_options.jobs = 1;
+    }
+    // orders files for locality and limits concurrent reads per device
+    IoScheduler scheduler(io_options);
+    const size_t workers = scheduler.get_jobs();
+
+    if (sharded) {
+        run_shard(input_path, files, options, shard, shard_split, scheduler, report);
+        std::cout << "Partial report written to " << out_path << "\n";
+        return 0;
+    }
+
+    // --max-memory: read buffers stall or shrink, and buffered results spill, within one budget
+    BufferPool pool(max_memory);
+    ResultSpool spool(max_memory ? &pool : nullptr, max_memory / 4);
+    std::vector<SummaryAggregate> summaries(workers, SummaryAggregate(input_path, top_k));
+    // one analyzer per worker, reused across files, keeps block scans allocation-free
+    std::vector<FileAnalyzer> analyzers(workers);
+    for (FileAnalyzer& analyzer : analyzers) {
+        if (max_memory) analyzer.set_buffer_pool(&pool);
+    }
+    // with --archives, tar members are streamed out of their archive through the same analyzers
+    std::vector<ArchiveScanner> archive_scanners(archives ? workers : 0);
+    // with --delta-cache, unchanged blocks from the previous run are reused
+    DeltaCache delta_cache;
+    DeltaScanner delta_scanner(delta_cache);
+    if (!delta_cache_path.empty() && !delta_cache.load(delta_cache_path)) {
+        std::cerr << "Warning: " << delta_cache.get_error_message() << "; starting fresh\n";
+    }
+    std::mutex error_mutex;
+
+    // with --checkpoint, completed files and large-file progress survive an interruption
+    const bool checkpointing = !checkpoint_path.empty();
+    ScanCheckpoint checkpoint(checkpoint_path, std::chrono::milliseconds(
+        static_cast<int64_t>(checkpoint_interval * 1000)));
+    std::vector<size_t> current(workers);  // file each worker is analyzing
+    if (checkpointing) {
+        json scan;
+        scan["root"] = fs::absolute(input_path).lexically_normal().string();
+        scan["recursive"] = recursive;
+        scan["extension"] = extension;
+        scan["threshold"] = entropy_threshold;
+        scan["block_size"] = block_size;
+        scan["archives"] = archives;
+        bool found = true;
+        bool ok = resume ? checkpoint.resume(scan, files, spool, found)
+                         : checkpoint.begin(scan, files);
+        if (!ok) {
+            std::cerr << "Error: " << checkpoint.get_error_message() << "\n";
+            return 1;
+        }
+        if (!found) {
+            std::cerr << "Warning: no checkpoint at " << checkpoint_path << "; starting fresh\n";
+        } else if (resume) {
+            std::cout << "Resuming: " << checkpoint.get_completed_count();
+            if (!summary_mode) std::cout << " of " << files.size();
+            std::cout << " files already done\n";
+        }
+        for (size_t w = 0; w < workers; ++w) {
+            analyzers[w].set_progress_callback([&, w](const FileProgress& progress) {
+                if (g_scan_stop) return false;
+                if (summary_mode) return true;  // an interrupted batch is scanned again as a whole
+                if (!checkpoint.update_progress(current[w], files[current[w]], progress)) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    std::cerr << "Warning: " << checkpoint.get_error_message() << "\n";
+                }
+                return true;
+            });
+        }
+        for (ArchiveScanner& archive_scanner : archive_scanners) {
+            archive_scanner.set_stop_callback([] { return g_scan_stop != 0; });
+        }
+        std::signal(SIGINT, handle_scan_signal);
+        std::signal(SIGTERM, handle_scan_signal);
+    }
+    // with --max-memory, the blocks of large files go to the spool (or, in summary
+    // mode, nowhere) as they are found; --checkpoint journals whole entries, so
+    // there they stay with the file until it completes
+    if (max_memory && !checkpointing) {
+        for (size_t w = 0; w < workers; ++w) {
+            analyzers[w].set_block_sink([&, w](const std::vector<std::pair<size_t, double>>& blocks, bool first) {
+                if (summary_mode) return;
+                if (!spool.add_blocks(current[w], blocks, first)) {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    std::cerr << "Error: " << spool.get_error_message() << "\n";
+                }
+            });
+        }
+    }
+
+    // records one analyzed file in the spool (by position) or the worker's summary
+    auto record = [&](size_t worker, size_t index, const fs::path& path, auto& scanner, bool analyzed) {
+        if (!analyzed) {
+            if (g_scan_stop) return;  // stopped, not failed; scanned again on resume
+            std::lock_guard<std::mutex> lock(error_mutex);
+            std::cerr << "Error reading file: " << scanner.get_error_message() << "\n";
+            if (summary_mode) summaries[worker].add_error();
+            return;
+        }
+        if (summary_mode) {
+            summaries[worker].add(path, scanner.get_file_size(), scanner.get_file_entropy(),
+                                  scanner.has_entry());
+            return;
+        }
+        if (scanner.has_entry() && !spool_entry(spool, index, scanner)) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            std::cerr << "Error: " << spool.get_error_message() << "\n";
+        }
+        if (checkpointing
+            && !checkpoint.complete(index, scanner.has_entry() ? &scanner.get_entry() : nullptr)) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            std::cerr << "Warning: " << checkpoint.get_error_message() << "\n";
+        }
+    };
+    // scans a tar archive member by member, or any other file as a whole
+    // members already journaled by an interrupted run are passed over
+    auto record_archive = [&](size_t worker, size_t index, const fs::path& path, uint64_t members) {
+        ArchiveScanner& archive_scanner = archive_scanners[worker];
+        auto on_member = [&](const std::string& member, FileAnalyzer& analyzer) {
+            if (summary_mode) {
+                summaries[worker].add(member, analyzer.get_file_size(), analyzer.get_file_entropy(),
+                                      analyzer.has_entry());
+                return;
+            }
+            if (analyzer.has_entry() && !spool_entry(spool, index, analyzer)) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                std::cerr << "Error: " << spool.get_error_message() << "\n";
+            }
+            if (checkpointing
+                && !checkpoint.complete_member(index, path, analyzer.has_entry() ? &analyzer.get_entry() : nullptr)) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                std::cerr << "Warning: " << checkpoint.get_error_message() << "\n";
+            }
+        };
+        bool is_archive = true;
+        bool ok = members > 0
+            ? archive_scanner.resume(path.native(), options, analyzers[worker], members, on_member, is_archive)
+            : archive_scanner.scan(path.native(), options, analyzers[worker], on_member, is_archive);
+        for (const std::string& error : archive_scanner.get_member_errors()) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            std::cerr << "Error reading file: " << error << "\n";
+            if (summary_mode) summaries[worker].add_error();
+        }
+        if (!is_archive) {
+            record(worker, index, path, analyzers[worker], ok);
+        } else if (!ok) {
+            if (g_scan_stop) return;  // stopped, not failed; continued on resume
+            std::lock_guard<std::mutex> lock(error_mutex);
+            std::cerr << "Error reading file: " << archive_scanner.get_error_message() << "\n";
+            if (summary_mode) summaries[worker].add_error();
+        } else if (checkpointing && !summary_mode && !checkpoint.complete(index, nullptr)) {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            std::cerr << "Warning: " << checkpoint.get_error_message() << "\n";
+        }
+    };
     // for each file, either block scan or global scan 
-    for (const fs::path& path : files) {
-        FileReader reader(path.string());
-        if (!reader.read_file()) {
-            std::cerr << "Error reading file: " << reader.get_error_message() << "\n";
-            continue;
+    auto scan_batch = [&](const std::vector<fs::path>& batch) {
+        scheduler.run(batch, [&](size_t worker, size_t index) {
+            const fs::path& path = batch[index];
+            if (!delta_cache_path.empty()) {
+                record(worker, index, path, delta_scanner, delta_scanner.analyze(path.native(), options));
+                return;
+            }
+            if (checkpointing && (g_scan_stop || (!summary_mode && checkpoint.is_complete(index)))) {
+                return;  // stopped, or completed before the interruption
+            }
+            FileAnalyzer& analyzer = analyzers[worker];
+            current[worker] = index;
+            FileProgress progress;
+            if (checkpointing && !summary_mode && checkpoint.get_progress(index, path, progress)) {
+                record(worker, index, path, analyzer, analyzer.resume(path.native(), options, progress));
+            } else if (archives) {
+                record_archive(worker, index, path,
+                               checkpointing && !summary_mode ? checkpoint.get_member_count(index) : 0);
+            } else {
+                record(worker, index, path, analyzer, analyzer.analyze(path.native(), options));
+            }
+        });
+    };
+
+    if (summary_mode) {
+        // bounded batches keep memory flat while still giving the scheduler room to reorder
+        constexpr size_t kSummaryBatch = 4096;
+        // with --checkpoint, the worker aggregates are recorded after every batch;
+        // on resume the files of completed batches are enumerated but not read
+        uint64_t done = 0;  // files in completed batches
+        uint64_t done_hash = ScanCheckpoint::hash_files({});
+        uint64_t skip = 0;
+        uint64_t skip_hash = 0;
+        json saved;
+        if (checkpointing && checkpoint.get_prefix(skip, skip_hash, saved)) {
+            try {
+                for (size_t w = 0; w < saved.size(); ++w) {
+                    SummaryAggregate aggregate(input_path, top_k);
+                    aggregate.load_state(saved.at(w));
+                    if (w < workers) {
+                        summaries[w] = std::move(aggregate);
+                    } else {
+                        summaries[0].merge(aggregate);  // resumed with fewer --jobs
+                    }
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Corrupt checkpoint file " << checkpoint_path << ": " << e.what() << "\n";
+                return 1;
+            }
         }
-    
-        const std::vector<uint8_t>& data = reader.get_data();
-
-        json entry; 
-        entry["path"] = path.string();
-        entry["threshold"] = entropy_threshold;
-        
-        // block scan mode 
-        if (block_size > 0) {
-            std::vector<std::pair<size_t, double>> results = BlockEntropyScanner::scan(
-                data, 
-                block_size, 
-                entropy_threshold
-            );
-            if (results.empty()) continue;
-            
-            json blocks = json::array();
-            for (const auto& [offset, entropy] : results) {
-                json block;
-                block["offset"] = offset;
-                block["entropy"] = entropy;
-                blocks.push_back(block);
-            }
-            entry["type"] = "block";
-            entry["blocks"] = std::move(blocks);
-            EntropyCalculator calc(data);
-            entry["file_entropy"] = calc.get_entropy();        
+        bool changed = false;
+        std::vector<fs::path> batch;
+        auto complete_batch = [&]() {
+            scan_batch(batch);
+            if (checkpointing && !g_scan_stop) {
+                done += batch.size();
+                done_hash = ScanCheckpoint::hash_files(batch, done_hash);
+                json states = json::array();
+                for (const SummaryAggregate& summary : summaries) {
+                    states.push_back(summary.to_state());
+                }
+                if (!checkpoint.complete_prefix(done, done_hash, std::move(states))) {
+                    std::cerr << "Warning: " << checkpoint.get_error_message() << "\n";
+                }
+            }
+            batch.clear();
+        };
+        utils::for_each_file(input_path, recursive, extension, [&](const fs::path& path) {
+            if (g_scan_stop || changed) return;
+            batch.push_back(path);
+            if (done < skip) {
+                // summarized before the interruption; only check it is the same file
+                if (batch.size() == kSummaryBatch || done + batch.size() == skip) {
+                    done += batch.size();
+                    done_hash = ScanCheckpoint::hash_files(batch, done_hash);
+                    batch.clear();
+                    changed = done == skip && done_hash != skip_hash;
+                }
+            } else if (batch.size() == kSummaryBatch) {
+                complete_batch();
+            }
+        });
+        if (!g_scan_stop && (changed || done < skip)) {
+            std::cerr << "Error: Files under the scan root changed since checkpoint " << checkpoint_path << "\n";
+            return 1;
         }
-        else {
-            // global scan mode
-            double entropy = EntropyCalculator(data).get_entropy();
-            if (entropy < entropy_threshold) continue;
-            entry["type"] = "global";
-            entry["entropy"] = entropy;
+        complete_batch();
+        for (size_t w = 1; w < workers; ++w) {
+            summaries[0].merge(summaries[w]);
+        }
+    } else {
+        scan_batch(files);
+    }
+    if (g_scan_stop) {
+        // nothing is reported; the checkpoint holds everything done so far
+        report.close();
+        fs::remove(out_path);
+        if (!checkpoint.write()) {
+            std::cerr << "Error: " << checkpoint.get_error_message() << "\n";
+            return 1;
         }
-        jresults.push_back(entry);
+        std::cerr << "Interrupted after " << checkpoint.get_completed_count();
+        if (!summary_mode) std::cerr << " of " << files.size();
+        std::cerr << " files; rerun with --checkpoint " << checkpoint_path << " --resume to continue\n";
+        return 130;
+    }
+    if (!delta_cache_path.empty()) {
+        delta_cache.evict_missing();
+    }
+    if (!delta_cache_path.empty() && !delta_cache.save(delta_cache_path)) {
+        std::cerr << "Error: " << delta_cache.get_error_message() << "\n";
+    }
+    if (summary_mode) {
+        utils::write_json_output(report, summaries[0].to_json(entropy_threshold));
+    } else if (!spool.write_array(report)) {
+        std::cerr << "Error: " << spool.get_error_message() << "\n";
+        return 1;
+    }
+    if (checkpointing) {
+        checkpoint.remove();  // the report now holds everything
     }
-    utils::write_json_output(report, jresults);
     std::cout << "Report written to " << out_path << "\n";
 
     return 0;
@@ -0,0 +1,209 @@
+#include "archive_scanner.hpp"
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+    // read size while passing over the zero blocks after an end-of-archive marker
+    constexpr size_t kTrailingChunk = 64 * 1024;
+
+    // the length of an archive that runs to the end of its file
+    constexpr uint64_t kToEnd = std::numeric_limits<uint64_t>::max();
+
+} // namespace
+
+void ArchiveScanner::set_stop_callback(StopCallback should_stop) {
+    should_stop_ = std::move(should_stop);
+}
+
+bool ArchiveScanner::stop_requested() {
+    if (!stopped_ && should_stop_ && should_stop_()) {
+        stopped_ = true;
+    }
+    return stopped_;
+}
+
+bool ArchiveScanner::scan(const std::string& path, const ScanOptions& options, FileAnalyzer& analyzer,
+                          const MemberCallback& on_member, bool& is_archive) {
+    auto is_tar = [](const unsigned char* data, size_t size) {
+        return size >= TarReader::kBlockSize && TarReader::is_header(data);
+    };
+    if (!analyzer.analyze(path, options, is_tar, is_archive)) {
+        error_message_ = analyzer.get_error_message();
+        return false;
+    }
+    error_message_.clear();
+    member_errors_.clear();
+    if (!is_archive) {
+        return true;
+    }
+    return scan_archive(path, options, analyzer, 0, on_member, is_archive);
+}
+
+bool ArchiveScanner::resume(const std::string& path, const ScanOptions& options, FileAnalyzer& analyzer,
+                            uint64_t members, const MemberCallback& on_member, bool& is_archive) {
+    error_message_.clear();
+    member_errors_.clear();
+    is_archive = true;
+    return scan_archive(path, options, analyzer, members, on_member, is_archive);
+}
+
+bool ArchiveScanner::scan_archive(const std::string& path, const ScanOptions& options, FileAnalyzer& analyzer,
+                                  uint64_t skip, const MemberCallback& on_member, bool& is_archive) {
+    stopped_ = false;
+    skip_ = skip;
+    archive_path_ = path;
+    FileSource file(path);
+    if (!scan_tar(path, file, 0, kToEnd, options, analyzer, on_member, 1)) {
+        if (stopped_) {
+            return false;
+        }
+        // damaged, or it only looks like an archive: the file is analyzed as it is
+        member_errors_.push_back(error_message_ + "; scanned as plain data");
+        is_archive = false;
+        if (!analyzer.analyze(path, options)) {
+            error_message_ = analyzer.get_error_message();
+            return false;
+        }
+        error_message_.clear();
+        return true;
+    }
+    if (skip_ > 0) {
+        error_message_ = path + ": fewer members than already scanned";
+        return false;
+    }
+    return true;
+}
+
+bool ArchiveScanner::scan_tar(const std::string& prefix, ByteSource& source, uint64_t offset, uint64_t length,
+                              const ScanOptions& options, FileAnalyzer& analyzer, const MemberCallback& on_member,
+                              int depth) {
+    TarReader tar(source);
+    TarMember member;
+    // where each file's data is, for the hard links that may follow it
+    std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> files;
+    while (!stop_requested() && tar.next(member)) {
+        const std::string path = prefix + "!" + member.path;
+        if (member.kind == TarMember::Kind::Sparse) {
+            member_errors_.push_back(path + ": GNU sparse member not supported; skipped");
+            continue;
+        }
+        if (member.kind == TarMember::Kind::HardLink) {
+            // reported under its own name, with the data of its target read again
+            auto target = files.find(member.link_target);
+            if (target == files.end()) {
+                member_errors_.push_back(path + ": hard link to " + member.link_target
+                                         + ", which is not in the archive");
+                continue;
+            }
+            auto [target_offset, target_length] = target->second;
+            FileSource again(archive_path_, target_offset, target_length);
+            if (!scan_member(path, again, target_offset, target_length, options, analyzer, on_member, depth)
+                && !stopped_) {
+                member_errors_.push_back(path + ": " + again.get_error_message());
+            }
+            continue;
+        }
+        files[member.path] = {offset + tar.get_offset(), member.size};
+        if (!scan_member(path, tar, offset + tar.get_offset(), member.size,
+                         options, analyzer, on_member, depth)) {
+            break;
+        }
+    }
+    if (stopped_) {
+        error_message_ = "Analysis stopped: " + prefix;
+        return false;
+    }
+    if (!tar.get_error_message().empty()) {
+        error_message_ = prefix + ": " + tar.get_error_message();
+        return false;
+    }
+    return scan_trailing(prefix, source, offset + tar.get_offset(), length - tar.get_offset(),
+                         options, analyzer, on_member, depth);
+}
+
+bool ArchiveScanner::scan_member(const std::string& path, ByteSource& source, uint64_t offset, uint64_t length,
+                                 const ScanOptions& options, FileAnalyzer& analyzer, const MemberCallback& on_member,
+                                 int depth) {
+    // the first block tells a nested archive from data; it is replayed either way
+    unsigned char header[TarReader::kBlockSize];
+    size_t got = 0;
+    if (!source.read(header, sizeof(header), got)) {
+        return false;
+    }
+    PrefixedSource data(header, got, source);
+    if (depth < kMaxDepth && got == sizeof(header) && TarReader::is_header(header)) {
+        if (scan_tar(path, data, offset, length, options, analyzer, on_member, depth + 1)) {
+            return true;  // the outer reader skips whatever the nested scan left
+        }
+        if (stopped_ || !source.get_error_message().empty()) {
+            return false;  // the damage is in this archive, not only in the nested one
+        }
+        // damaged, or it only looks like an archive: its bytes are read again
+        // from the file and analyzed as they are
+        member_errors_.push_back(error_message_ + "; scanned as plain data");
+        FileSource again(archive_path_, offset, length);
+        return analyze_member(path, again, options, analyzer, on_member);
+    }
+    return analyze_member(path, data, options, analyzer, on_member);
+}
+
+bool ArchiveScanner::analyze_member(const std::string& path, ByteSource& data, const ScanOptions& options,
+                                    FileAnalyzer& analyzer, const MemberCallback& on_member) {
+    if (skip_ > 0) {
+        --skip_;  // reported before the scan was interrupted
+        return true;
+    }
+    if (!analyzer.analyze_source(path, data, options,
+                                 [this](const FileProgress&) { return !stop_requested(); })) {
+        return false;
+    }
+    on_member(path, analyzer);
+    return true;
+}
+
+bool ArchiveScanner::scan_trailing(const std::string& prefix, ByteSource& source, uint64_t offset, uint64_t length,
+                                   const ScanOptions& options, FileAnalyzer& analyzer, const MemberCallback& on_member,
+                                   int depth) {
+    // the rest of the end marker and the record padding are zero blocks;
+    // the first block that is not starts the trailing data
+    trailing_.resize(kTrailingChunk);
+    size_t got = 0;
+    size_t start = 0;
+    uint64_t passed = 0;  // zero bytes before the chunk in trailing_
+    while (true) {
+        if (!source.read(trailing_.data(), trailing_.size(), got)) {
+            error_message_ = prefix + ": " + source.get_error_message();
+            return false;
+        }
+        for (start = 0; start < got; start += TarReader::kBlockSize) {
+            auto block = trailing_.begin() + static_cast<std::ptrdiff_t>(start);
+            auto end = trailing_.begin() + static_cast<std::ptrdiff_t>(std::min(got, start + TarReader::kBlockSize));
+            if (std::any_of(block, end, [](unsigned char b) { return b != 0; })) break;
+        }
+        if (start < got || got < trailing_.size()) break;
+        passed += got;
+    }
+    if (start >= got) {
+        return true;
+    }
+
+    PrefixedSource rest(trailing_.data() + start, got - start, source);
+    passed += start;
+    if (!scan_member(prefix + "!<trailing>", rest, offset + passed, length - passed,
+                     options, analyzer, on_member, depth)) {
+        error_message_ = stopped_ ? "Analysis stopped: " + prefix : prefix + ": " + source.get_error_message();
+        return false;
+    }
+    return true;
+}
+
+const std::vector<std::string>& ArchiveScanner::get_member_errors() const {
+    return member_errors_;
+}
+
+const std::string& ArchiveScanner::get_error_message() const {
+    return error_message_;
+}
@@ -0,0 +1,142 @@
+#ifndef ARCHIVE_SCANNER_HPP
+#define ARCHIVE_SCANNER_HPP
+
+#include "file_analyzer.hpp"
+#include "tar_reader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @class ArchiveScanner
+ * @brief Analyzes the members of tar archives in place, without extracting them.
+ *
+ * Each regular member is streamed from the archive through the caller's
+ * FileAnalyzer and reported under the path "<archive>!<member>", with block offsets
+ * relative to the start of the member. A member that is itself a tar
+ * archive (recognized by its header, not its name) is scanned the same
+ * way, giving paths like "outer.tar!inner.tar!member", up to kMaxDepth
+ * levels; deeper archives are analyzed as plain members. A nested archive
+ * found damaged (or a member that only looks like one) is read again from
+ * the file and analyzed as a plain member, after the members it did yield;
+ * the error is recorded and the outer archive goes on. A damaged top-level
+ * archive is likewise analyzed as a whole file.
+ *
+ * A hard link is reported under its own name, as "<archive>!<link>", with
+ * the data of its target read again, so its entry matches the target's.
+ * GNU sparse members are recorded in get_member_errors() and skipped.
+ *
+ * Data after an archive's end-of-archive marker, other than zero padding,
+ * is reported as one more member "<archive>!<trailing>" (opened as an
+ * archive in turn if it starts with a tar header, as concatenated archives
+ * do). Its offsets count from the first 512-byte block after the marker
+ * that is not all zeros.
+ *
+ * Members are counted in the order on_member sees them, across nesting
+ * levels, so an interrupted scan can be continued with resume().
+ *
+ * Nothing is written to disk, and memory use is that of one stream chunk
+ * plus a header block per nesting level, 64 KiB to look past end markers,
+ * and the name, offset and size of each member to resolve hard links. Compressed archives (.tar.gz and similar) are not recognized
+ * and are analyzed as ordinary files.
+ */
+class ArchiveScanner {
+public:
+    static constexpr int kMaxDepth = 8;
+
+    /**
+     * @brief Called for every analyzed member; @p analyzer holds its results.
+     */
+    using MemberCallback = std::function<void(const std::string& path, FileAnalyzer& analyzer)>;
+
+    /**
+     * @brief Polled between members and after each chunk; return true to stop the scan.
+     */
+    using StopCallback = std::function<bool()>;
+
+    /**
+     * @brief Stops scans early when @p should_stop returns true.
+     *
+     * A stopped scan fails with an "Analysis stopped" error; the members
+     * reported until then are complete. Pass an empty callback to never stop.
+     */
+    void set_stop_callback(StopCallback should_stop);
+
+    /**
+     * @brief Analyzes @p path, member by member if it is a tar archive.
+     *
+     * The archive is recognized from the small-file probe of
+     * FileAnalyzer::analyze(), so other files are read exactly as analyze()
+     * would read them.
+     *
+     * @param path The file to scan.
+     * @param options The threshold and block size applied to the file or every member.
+     * @param analyzer Analyzes the file or, in turn, each member.
+     * @param on_member Called for each member, in archive order.
+     * @param is_archive Set to whether @p path was scanned as a tar archive;
+     *                   false if it does not start with a tar header, or
+     *                   turned out damaged (see get_member_errors()), and
+     *                   then @p analyzer holds the results for the whole
+     *                   file, as after FileAnalyzer::analyze().
+     *
+     * @return false if the file could not be read or the scan was stopped
+     *         (see get_error_message()); members before the problem have
+     *         been reported. Damaged archives do not fail the scan.
+     */
+    bool scan(const std::string& path, const ScanOptions& options, FileAnalyzer& analyzer,
+              const MemberCallback& on_member, bool& is_archive);
+
+    /**
+     * @brief Continues scanning the tar archive @p path after its first @p members members.
+     *
+     * The skipped members are passed over without being read, and
+     * on_member is called for the rest exactly as scan() would.
+     *
+     * @param is_archive As for scan().
+     *
+     * @return false as for scan(); also if @p path has fewer members than
+     *         were already scanned.
+     */
+    bool resume(const std::string& path, const ScanOptions& options, FileAnalyzer& analyzer,
+                uint64_t members, const MemberCallback& on_member, bool& is_archive);
+
+    /**
+     * @brief Returns the errors of archives found damaged, and of members passed over, during the last scan().
+     *
+     * The data of damaged archives was then analyzed as plain data. Members
+     * passed over are GNU sparse files and hard links to missing targets.
+     */
+    const std::vector<std::string>& get_member_errors() const;
+
+    /**
+     * @brief Returns the error message of the last failed scan().
+     */
+    const std::string& get_error_message() const;
+
+private:
+    // offset and length place the archive or member in the file, so it can be read again
+    bool scan_archive(const std::string& path, const ScanOptions& options, FileAnalyzer& analyzer,
+                      uint64_t skip, const MemberCallback& on_member, bool& is_archive);
+    bool scan_tar(const std::string& prefix, ByteSource& source, uint64_t offset, uint64_t length,
+                  const ScanOptions& options, FileAnalyzer& analyzer, const MemberCallback& on_member, int depth);
+    bool scan_member(const std::string& path, ByteSource& source, uint64_t offset, uint64_t length,
+                     const ScanOptions& options, FileAnalyzer& analyzer, const MemberCallback& on_member, int depth);
+    bool analyze_member(const std::string& path, ByteSource& data, const ScanOptions& options,
+                        FileAnalyzer& analyzer, const MemberCallback& on_member);
+    bool scan_trailing(const std::string& prefix, ByteSource& source, uint64_t offset, uint64_t length,
+                       const ScanOptions& options, FileAnalyzer& analyzer, const MemberCallback& on_member, int depth);
+    bool stop_requested();
+
+    StopCallback should_stop_;
+    bool stopped_ = false;
+    uint64_t skip_ = 0;  // members still to pass over when resuming
+    std::string archive_path_;  // the file being scanned
+    std::vector<unsigned char> trailing_;  // reads past an end-of-archive marker
+
+    std::vector<std::string> member_errors_;
+    std::string error_message_;
+};
+
+#endif // ARCHIVE_SCANNER_HPP
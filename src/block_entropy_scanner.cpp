@@ -1,5 +1,7 @@
 #include "block_entropy_scanner.hpp"
 #include "entropy_calculator.hpp"
+#include "scan_context.hpp"
+#include "fixed_block_scanner.hpp"
 #include <algorithm>
 #include <stdexcept>
 
@@ -8,7 +10,18 @@ std::vector<std::pair<size_t, double>> BlockEntropyScanner::scan(
     size_t block_size,
     double min_entropy
 ) {
-    if (data.empty()) {
+    ScanContext ctx;
+    return scan(data.data(), data.size(), block_size, min_entropy, ctx);
+}
+
+const std::vector<std::pair<size_t, double>>& BlockEntropyScanner::scan(
+    const unsigned char* data,
+    size_t size,
+    size_t block_size,
+    double min_entropy,
+    ScanContext& ctx
+) {
+    if (data == nullptr || size == 0) {
         throw std::invalid_argument("Data must not be empty");
     }    
     if (block_size <= 0) {
@@ -17,15 +30,29 @@ std::vector<std::pair<size_t, double>> BlockEntropyScanner::scan(
     if (min_entropy < 0.0 || min_entropy > 8.0) {
         throw std::invalid_argument("Entropy threshold must be in range [0.0, 8.0].");
     }    
-    std::vector<std::pair<size_t, double>> results;
+    // common sector and page sizes get compile-time specialized scanners
+    switch (block_size) {
+        case 512:
+            return FixedBlockEntropyScanner<512>::scan_blocks(data, size, min_entropy, ctx);
+        case 4096:
+            return FixedBlockEntropyScanner<4096>::scan_blocks(data, size, min_entropy, ctx);
+        case 65536:
+            return FixedBlockEntropyScanner<65536>::scan_blocks(data, size, min_entropy, ctx);
+        default:
+            break;
+    }
+
+    ctx.reset_results();
+    std::vector<std::pair<size_t, double>>& results = ctx.results();
+    std::array<size_t, 256>& histogram = ctx.histogram();
     size_t offset = 0;
 
-    while (offset < data.size()) {
-        size_t end = std::min(offset + block_size, data.size());
-        std::vector<unsigned char> block(data.begin() + offset, data.begin() + end);
+    while (offset < size) {
+        size_t len = std::min(block_size, size - offset);
 
-        EntropyCalculator calc(block);
-        double entropy = calc.get_entropy();
+        ctx.clear_histogram();
+        EntropyCalculator::accumulate_histogram(data + offset, len, histogram);
+        double entropy = EntropyCalculator::entropy_from_histogram(histogram, len);
 
         if (entropy >= min_entropy) {
             results.emplace_back(offset, entropy);
@@ -5,6 +5,8 @@
 #include <cstddef>
 #include <utility>
 
+class ScanContext;
+
 /**
  * @class BlockEntropyScanner
  * @brief Provides functionality to compute entropy on fixed-size blocks of input data.
@@ -40,6 +42,32 @@ public:
         size_t block_size,
         double min_entropy = 0.0
     );
+
+    /**
+     * @brief Scans a raw byte range in fixed-size blocks using reusable buffers.
+     *
+     * Behaves like the vector overload, but reads blocks in place and writes
+     * results into @p ctx instead of allocating. Once @p ctx has grown to fit
+     * the largest input, repeated scans perform no heap allocations.
+     *
+     * Block sizes of 512, 4096 and 65536 bytes are dispatched to
+     * FixedBlockEntropyScanner specializations; other sizes use the generic path.
+     *
+     * @param data Pointer to the bytes to scan.
+     * @param size Number of bytes to scan.
+     * @param block_size The size (in bytes) of each block to analyze.
+     * @param min_entropy The minimum entropy threshold for a block to be included in the result.
+     * @param ctx The scan context providing histogram and result storage.
+     *
+     * @return A reference to ctx.results(), valid until the next scan through @p ctx.
+     */
+    static const std::vector<std::pair<size_t, double>>& scan(
+        const unsigned char* data,
+        size_t size,
+        size_t block_size,
+        double min_entropy,
+        ScanContext& ctx
+    );
 };
 
 #endif // BLOCK_ENTROPY_SCANNER_HPP
@@ -0,0 +1,136 @@
+#include "buffer_pool.hpp"
+#include <algorithm>
+
+BufferPool::Buffer::Buffer(BufferPool* pool, std::unique_ptr<unsigned char[]> data,
+                           size_t capacity, size_t size)
+    : pool_(pool), data_(std::move(data)), capacity_(capacity), size_(size) {}
+
+BufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : pool_(other.pool_), data_(std::move(other.data_)),
+      capacity_(other.capacity_), size_(other.size_) {
+    other.pool_ = nullptr;
+    other.capacity_ = 0;
+    other.size_ = 0;
+}
+
+BufferPool::Buffer& BufferPool::Buffer::operator=(Buffer&& other) noexcept {
+    if (this != &other) {
+        reset();
+        pool_ = other.pool_;
+        data_ = std::move(other.data_);
+        capacity_ = other.capacity_;
+        size_ = other.size_;
+        other.pool_ = nullptr;
+        other.capacity_ = 0;
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+BufferPool::Buffer::~Buffer() {
+    reset();
+}
+
+void BufferPool::Buffer::reset() {
+    if (pool_ && data_) {
+        pool_->give_back(std::move(data_), capacity_);
+    }
+    pool_ = nullptr;
+    capacity_ = 0;
+    size_ = 0;
+}
+
+BufferPool::BufferPool(size_t budget)
+    : budget_(budget) {}
+
+BufferPool::Buffer BufferPool::acquire(size_t preferred, size_t minimum, size_t granularity) {
+    granularity = std::max<size_t>(granularity, 1);
+    preferred = std::max(preferred / granularity * granularity, granularity);
+    minimum = std::min(std::max(minimum, granularity), preferred);
+    if (budget_ > 0) {
+        // a minimum above the whole budget could never be granted
+        size_t cap = std::max(budget_ / granularity * granularity, granularity);
+        minimum = std::min(minimum, cap);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t size = preferred;
+    if (budget_ > 0) {
+        returned_.wait(lock, [&] { return in_use_ + minimum <= budget_; });
+        size_t available = budget_ > in_use_ ? budget_ - in_use_ : 0;
+        size = std::clamp(available / granularity * granularity, minimum, preferred);
+    }
+
+    // smallest cached buffer that fits, else a new one
+    auto best = free_.end();
+    for (auto it = free_.begin(); it != free_.end(); ++it) {
+        if (it->second >= size && (best == free_.end() || it->second < best->second)) {
+            best = it;
+        }
+    }
+    std::unique_ptr<unsigned char[]> data;
+    size_t capacity = size;
+    if (best != free_.end()) {
+        data = std::move(best->first);
+        capacity = best->second;
+        cached_ -= capacity;
+        free_.erase(best);
+    } else {
+        drop_cache_locked(size);
+        data.reset(new unsigned char[size]);  // not zeroed; it is read into
+    }
+    // a reused buffer may be larger than granted; the whole capacity is charged
+    in_use_ += capacity;
+    peak_ = std::max(peak_, in_use_);
+    return Buffer(this, std::move(data), capacity, size);
+}
+
+bool BufferPool::try_reserve(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (budget_ > 0 && in_use_ + bytes > budget_) {
+        return false;
+    }
+    drop_cache_locked(bytes);
+    in_use_ += bytes;
+    peak_ = std::max(peak_, in_use_);
+    return true;
+}
+
+void BufferPool::release(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_use_ -= std::min(bytes, in_use_);
+    }
+    returned_.notify_all();
+}
+
+size_t BufferPool::get_budget() const {
+    return budget_;
+}
+
+size_t BufferPool::get_peak() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_;
+}
+
+void BufferPool::give_back(std::unique_ptr<unsigned char[]> data, size_t capacity) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_use_ -= std::min(capacity, in_use_);
+        free_.emplace_back(std::move(data), capacity);
+        cached_ += capacity;
+        drop_cache_locked(0);
+    }
+    returned_.notify_all();
+}
+
+void BufferPool::drop_cache_locked(size_t needed) {
+    if (budget_ == 0) {
+        return;
+    }
+    // oldest entries go first; cached memory never pushes the total over budget
+    while (!free_.empty() && in_use_ + cached_ + needed > budget_) {
+        cached_ -= free_.front().second;
+        free_.erase(free_.begin());
+    }
+}
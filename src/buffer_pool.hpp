@@ -0,0 +1,104 @@
+#ifndef BUFFER_POOL_HPP
+#define BUFFER_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @class BufferPool
+ * @brief Hands out read buffers and reservations under one shared memory budget.
+ *
+ * Workers acquire a buffer before reading; when the budget is nearly used up
+ * the buffer is shrunk towards the requested minimum, and when even the
+ * minimum does not fit the call blocks until another worker returns memory.
+ * Other consumers (such as a ResultSpool) can reserve bytes without
+ * blocking via try_reserve() and react to a refusal themselves.
+ *
+ * Returned buffers are cached for reuse; cached memory counts against the
+ * budget but is freed whenever an acquisition needs the room.
+ *
+ * A budget of 0 means unlimited: buffers always get the preferred size.
+ */
+class BufferPool {
+public:
+    /**
+     * @class Buffer
+     * @brief A leased buffer; returns itself to the pool on destruction.
+     */
+    class Buffer {
+    public:
+        Buffer() = default;
+        Buffer(Buffer&& other) noexcept;
+        Buffer& operator=(Buffer&& other) noexcept;
+        ~Buffer();
+
+        unsigned char* data() const { return data_.get(); }
+        size_t size() const { return size_; }
+
+    private:
+        friend class BufferPool;
+        Buffer(BufferPool* pool, std::unique_ptr<unsigned char[]> data, size_t capacity, size_t size);
+        void reset();
+
+        BufferPool* pool_ = nullptr;
+        std::unique_ptr<unsigned char[]> data_;
+        size_t capacity_ = 0;
+        size_t size_ = 0;
+    };
+
+    /**
+     * @brief Constructs a pool limited to @p budget bytes (0 for unlimited).
+     */
+    explicit BufferPool(size_t budget);
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief Leases a buffer of between @p minimum and @p preferred bytes.
+     *
+     * The size is a multiple of @p granularity (at least one granule) and as
+     * large as the remaining budget allows. Blocks while not even @p minimum
+     * bytes are available; a minimum above the whole budget is clamped to it.
+     */
+    Buffer acquire(size_t preferred, size_t minimum, size_t granularity = 1);
+
+    /**
+     * @brief Reserves @p bytes without blocking.
+     *
+     * @return false if the reservation would exceed the budget.
+     */
+    bool try_reserve(size_t bytes);
+
+    /**
+     * @brief Returns bytes previously reserved with try_reserve().
+     */
+    void release(size_t bytes);
+
+    /**
+     * @brief Returns the budget in bytes (0 for unlimited).
+     */
+    size_t get_budget() const;
+
+    /**
+     * @brief Returns the highest number of leased plus reserved bytes seen.
+     */
+    size_t get_peak() const;
+
+private:
+    void give_back(std::unique_ptr<unsigned char[]> data, size_t capacity);
+    void drop_cache_locked(size_t needed);  // frees cached buffers until needed bytes fit
+
+    size_t budget_;
+    size_t in_use_ = 0;   // leased buffers plus reservations
+    size_t cached_ = 0;   // bytes held in free_
+    size_t peak_ = 0;
+    std::vector<std::pair<std::unique_ptr<unsigned char[]>, size_t>> free_;
+    mutable std::mutex mutex_;
+    std::condition_variable returned_;
+};
+
+#endif // BUFFER_POOL_HPP
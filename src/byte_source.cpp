@@ -0,0 +1,85 @@
+#include "byte_source.hpp"
+#include <algorithm>
+#include <cstring>
+
+bool ByteSource::skip(uint64_t length) {
+    unsigned char discard[4096];
+    while (length > 0) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(length, sizeof(discard)));
+        size_t got = 0;
+        if (!read(discard, want, got) || got < want) {
+            return false;
+        }
+        length -= got;
+    }
+    return true;
+}
+
+FileSource::FileSource(const std::string& path)
+    : reader_(path) {}
+
+FileSource::FileSource(const std::string& path, uint64_t offset, uint64_t length)
+    : reader_(path), offset_(offset),
+      end_(length > std::numeric_limits<uint64_t>::max() - offset ? std::numeric_limits<uint64_t>::max()
+                                                                  : offset + length) {}
+
+bool FileSource::read(unsigned char* buffer, size_t length, size_t& bytes_read) {
+    length = static_cast<size_t>(std::min<uint64_t>(length, end_ - std::min(offset_, end_)));
+    if (!reader_.read_into(offset_, buffer, length, bytes_read)) {
+        error_message_ = reader_.get_error_message();
+        return false;
+    }
+    offset_ += bytes_read;
+    return true;
+}
+
+bool FileSource::skip(uint64_t length) {
+    if (length == 0) {
+        return true;
+    }
+    // moving the offset costs no I/O; one byte at the new position shows
+    // the data is there, so a skip past the end is not taken for a clean end
+    if (length > end_ - std::min(offset_, end_)) {
+        offset_ = end_;
+        return false;
+    }
+    unsigned char last;
+    size_t got = 0;
+    if (!reader_.read_into(offset_ + length - 1, &last, 1, got)) {
+        error_message_ = reader_.get_error_message();
+        return false;
+    }
+    offset_ += length;
+    return got == 1;
+}
+
+const std::string& FileSource::get_error_message() const {
+    return error_message_;
+}
+
+PrefixedSource::PrefixedSource(const unsigned char* prefix, size_t length, ByteSource& rest)
+    : prefix_(prefix, prefix + length), rest_(rest) {}
+
+bool PrefixedSource::read(unsigned char* buffer, size_t length, size_t& bytes_read) {
+    size_t from_prefix = std::min(length, prefix_.size() - position_);
+    std::memcpy(buffer, prefix_.data() + position_, from_prefix);
+    position_ += from_prefix;
+    bytes_read = from_prefix;
+    if (from_prefix == length) {
+        return true;
+    }
+    size_t from_rest = 0;
+    bool ok = rest_.read(buffer + from_prefix, length - from_prefix, from_rest);
+    bytes_read += from_rest;
+    return ok;
+}
+
+bool PrefixedSource::skip(uint64_t length) {
+    size_t from_prefix = static_cast<size_t>(std::min<uint64_t>(length, prefix_.size() - position_));
+    position_ += from_prefix;
+    return rest_.skip(length - from_prefix);
+}
+
+const std::string& PrefixedSource::get_error_message() const {
+    return rest_.get_error_message();
+}
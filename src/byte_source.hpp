@@ -0,0 +1,97 @@
+#ifndef BYTE_SOURCE_HPP
+#define BYTE_SOURCE_HPP
+
+#include "file_reader.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * @class ByteSource
+ * @brief A forward-only stream of bytes: a file, an archive member, ...
+ *
+ * Lets analysis and archive parsing run over data that has no path of its
+ * own, such as a member of a tar archive, without copying it anywhere.
+ */
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+
+    /**
+     * @brief Reads the next bytes into @p buffer.
+     *
+     * @param buffer Destination of at least @p length bytes.
+     * @param length The maximum number of bytes to read.
+     * @param bytes_read Receives the number of bytes read; fewer than
+     *                   @p length only at the end of the stream.
+     * @return false on a read error (see get_error_message()).
+     */
+    virtual bool read(unsigned char* buffer, size_t length, size_t& bytes_read) = 0;
+
+    /**
+     * @brief Skips @p length bytes.
+     *
+     * The default reads and discards them; seekable sources override it.
+     *
+     * @return false on a read error or if the stream ends first. Sources
+     *         that cannot tell report the end on the next read instead.
+     */
+    virtual bool skip(uint64_t length);
+
+    /**
+     * @brief Returns the error message of the last failed call.
+     */
+    virtual const std::string& get_error_message() const = 0;
+};
+
+/**
+ * @class FileSource
+ * @brief Reads a file front to back through FileReader.
+ *
+ * Skipping moves the read offset and reads just the last skipped byte, to
+ * tell whether the file ends first.
+ */
+class FileSource : public ByteSource {
+public:
+    explicit FileSource(const std::string& path);
+
+    /**
+     * @brief Reads the @p length bytes of @p path from @p offset on, as if they were the whole file.
+     */
+    FileSource(const std::string& path, uint64_t offset, uint64_t length);
+
+    bool read(unsigned char* buffer, size_t length, size_t& bytes_read) override;
+    bool skip(uint64_t length) override;
+    const std::string& get_error_message() const override;
+
+private:
+    FileReader reader_;
+    uint64_t offset_ = 0;
+    uint64_t end_ = std::numeric_limits<uint64_t>::max();  // the reads stop here
+    std::string error_message_;
+};
+
+/**
+ * @class PrefixedSource
+ * @brief Replays bytes already taken from a source, then continues with the source.
+ *
+ * Used to look at the start of a stream (for example to recognize a nested
+ * archive) without losing those bytes for whoever reads the stream next.
+ */
+class PrefixedSource : public ByteSource {
+public:
+    PrefixedSource(const unsigned char* prefix, size_t length, ByteSource& rest);
+
+    bool read(unsigned char* buffer, size_t length, size_t& bytes_read) override;
+    bool skip(uint64_t length) override;
+    const std::string& get_error_message() const override;
+
+private:
+    std::vector<unsigned char> prefix_;
+    size_t position_ = 0;
+    ByteSource& rest_;
+};
+
+#endif // BYTE_SOURCE_HPP
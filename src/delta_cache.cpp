@@ -0,0 +1,431 @@
+#include "delta_cache.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr char kMagic[4] = {'E', 'P', 'X', 'D'};
+    constexpr uint32_t kVersion = 2;
+
+    // magic, version, then the committed length of the file
+    constexpr uint64_t kHeaderSize = 16;
+    constexpr uint64_t kCommittedOffset = 8;
+
+    // record fields after the path: size, mtime, block size, segment blocks,
+    // block count and segment count
+    constexpr uint64_t kRecordFixed = 6 * sizeof(uint64_t);
+    constexpr uint64_t kBlockBytes = sizeof(uint64_t) + sizeof(double);
+    constexpr uint64_t kSegmentHistogramBytes = sizeof(SegmentHistogram);
+
+    // longest path accepted from a cache file before it is considered corrupt
+    constexpr uint32_t kMaxPathLength = 1 << 16;
+
+    // bytes read at a time while indexing the record headers
+    constexpr size_t kIndexChunk = 1 << 20;
+
+    constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+
+    inline uint64_t rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    template <typename T>
+    void put_pod(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    T get_pod(const char* data) {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    bool pread_all(int fd, char* buffer, size_t length, uint64_t offset) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t n = ::pread(fd, buffer + done, length - done, static_cast<off_t>(offset + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool pwrite_all(int fd, const char* data, size_t length, uint64_t offset) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t n = ::pwrite(fd, data + done, length - done, static_cast<off_t>(offset + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            done += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    std::string encode_header(uint64_t committed) {
+        std::string out(kMagic, sizeof(kMagic));
+        put_pod(out, kVersion);
+        put_pod(out, committed);
+        return out;
+    }
+
+    // a record with block_size 0 is a tombstone: the file was evicted
+    std::string encode_record(const std::string& path, const FileRecord* record) {
+        std::string out;
+        put_pod(out, static_cast<uint32_t>(path.size()));
+        out += path;
+        FileRecord empty;
+        empty.block_size = 0;
+        const FileRecord& r = record ? *record : empty;
+        put_pod(out, r.size);
+        put_pod(out, r.mtime_ns);
+        put_pod(out, r.block_size);
+        put_pod(out, r.segment_blocks);
+        put_pod(out, static_cast<uint64_t>(r.blocks.size()));
+        put_pod(out, static_cast<uint64_t>(r.segments.size()));
+        out.reserve(out.size() + r.blocks.size() * kBlockBytes + r.segments.size() * kSegmentHistogramBytes);
+        for (const BlockRecord& block : r.blocks) {
+            put_pod(out, block.fingerprint);
+            put_pod(out, block.entropy);
+        }
+        for (const SegmentHistogram& histogram : r.segments) {
+            put_pod(out, histogram);
+        }
+        return out;
+    }
+
+    // Reads the fixed fields of a record; the block and segment counts must
+    // match the size so a corrupt count is caught before anything is allocated.
+    bool decode_fixed(const char* data, FileRecord& record, uint64_t& blocks, uint64_t& segments) {
+        record.size = get_pod<uint64_t>(data);
+        record.mtime_ns = get_pod<int64_t>(data + 8);
+        record.block_size = get_pod<uint64_t>(data + 16);
+        record.segment_blocks = get_pod<uint64_t>(data + 24);
+        blocks = get_pod<uint64_t>(data + 32);
+        segments = get_pod<uint64_t>(data + 40);
+        if (record.block_size == 0) {
+            return blocks == 0 && segments == 0;
+        }
+        return record.segment_blocks > 0
+            && blocks == record.size / record.block_size + (record.size % record.block_size != 0)
+            && segments == blocks / record.segment_blocks + (blocks % record.segment_blocks != 0);
+    }
+
+    // Buffered forward reads over the record headers, which are small and
+    // separated by bodies that are skipped.
+    class IndexReader {
+    public:
+        IndexReader(int fd, uint64_t end) : fd_(fd), end_(end) {}
+
+        const char* read(uint64_t offset, size_t length) {
+            if (offset + length > end_ || offset + length < offset) {
+                return nullptr;
+            }
+            if (offset < start_ || offset + length > start_ + buffer_.size()) {
+                size_t want = static_cast<size_t>(std::min<uint64_t>(
+                    std::max(length, kIndexChunk), end_ - offset));
+                buffer_.resize(want);
+                if (!pread_all(fd_, buffer_.data(), want, offset)) {
+                    buffer_.clear();
+                    return nullptr;
+                }
+                start_ = offset;
+            }
+            return buffer_.data() + (offset - start_);
+        }
+
+    private:
+        int fd_;
+        uint64_t end_;
+        uint64_t start_ = 0;
+        std::string buffer_;
+    };
+
+} // namespace
+
+DeltaCache::~DeltaCache() {
+    close_file();
+}
+
+uint64_t DeltaCache::fingerprint(const unsigned char* data, size_t size) {
+    uint64_t h = kPrime1 ^ (static_cast<uint64_t>(size) * kPrime2);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        h ^= rotl(word * kPrime2, 31) * kPrime1;
+        h = rotl(h, 27) * kPrime1 + kPrime2;
+    }
+    for (; i < size; ++i) {
+        h ^= data[i] * kPrime1;
+        h = rotl(h, 11) * kPrime2;
+    }
+    // final avalanche so nearby inputs spread across all bits
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime1;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t DeltaCache::segment_blocks(uint64_t block_size) {
+    return std::max<uint64_t>(1, kSegmentBytes / std::max<uint64_t>(block_size, 1));
+}
+
+void DeltaCache::close_file() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+    fd_ = -1;
+    path_.clear();
+    end_ = 0;
+    live_bytes_ = 0;
+    must_rewrite_ = false;
+}
+
+bool DeltaCache::load(const std::string& path) {
+    close_file();
+    index_.clear();
+    pending_.clear();
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT) return true;  // no previous run
+        error_message_ = "Cannot open delta cache: " + path;
+        return false;
+    }
+
+    struct stat st;
+    char header[kHeaderSize];
+    uint64_t committed = 0;
+    if (::fstat(fd, &st) != 0 || !pread_all(fd, header, sizeof(header), 0)
+        || std::memcmp(header, kMagic, sizeof(kMagic)) != 0
+        || get_pod<uint32_t>(header + 4) != kVersion) {
+        ::close(fd);
+        error_message_ = "Not a delta cache file: " + path;
+        return false;
+    }
+    committed = get_pod<uint64_t>(header + kCommittedOffset);
+
+    bool ok = committed >= kHeaderSize && committed <= static_cast<uint64_t>(st.st_size);
+    IndexReader reader(fd, committed);
+    uint64_t offset = kHeaderSize;
+    while (ok && offset < committed) {
+        const char* data = reader.read(offset, sizeof(uint32_t));
+        uint32_t path_len = data ? get_pod<uint32_t>(data) : 0;
+        ok = data && path_len <= kMaxPathLength;
+        if (ok) {
+            data = reader.read(offset + sizeof(uint32_t), path_len + kRecordFixed);
+            ok = data != nullptr;
+        }
+        FileRecord record;
+        uint64_t blocks = 0;
+        uint64_t segments = 0;
+        ok = ok && decode_fixed(data + path_len, record, blocks, segments);
+        // counts are checked against the remaining length before multiplying
+        uint64_t head = sizeof(uint32_t) + path_len + kRecordFixed;
+        uint64_t left = committed - offset - std::min(head, committed - offset);
+        ok = ok && blocks <= left / kBlockBytes && segments <= left / kSegmentHistogramBytes
+            && blocks * kBlockBytes + segments * kSegmentHistogramBytes <= left;
+        if (!ok) break;
+
+        Location where{offset, head + blocks * kBlockBytes + segments * kSegmentHistogramBytes};
+        std::string file_path(data, path_len);
+        auto it = index_.find(file_path);
+        if (it != index_.end()) {
+            live_bytes_ -= it->second.length;
+            index_.erase(it);
+        }
+        if (record.block_size > 0) {
+            index_.emplace(std::move(file_path), where);
+            live_bytes_ += where.length;
+        }
+        offset += where.length;
+    }
+    if (!ok) {
+        ::close(fd);
+        index_.clear();
+        live_bytes_ = 0;
+        error_message_ = "Corrupt delta cache file: " + path;
+        return false;
+    }
+    fd_ = fd;
+    path_ = path;
+    end_ = committed;
+    return true;
+}
+
+bool DeltaCache::append(const std::string& data, Location& where) {
+    if (fd_ < 0 || must_rewrite_ || !pwrite_all(fd_, data.data(), data.size(), end_)) {
+        must_rewrite_ = fd_ >= 0;
+        return false;
+    }
+    where.offset = end_;
+    where.length = data.size();
+    end_ += data.size();
+    return true;
+}
+
+const FileRecord* DeltaCache::find(const std::string& path) {
+    auto pending = pending_.find(path);
+    if (pending != pending_.end()) {
+        return &pending->second;
+    }
+    auto it = index_.find(path);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+
+    // the record was validated by load(); a failed read just means no reuse
+    std::string data(static_cast<size_t>(it->second.length), '\0');
+    if (!pread_all(fd_, data.data(), data.size(), it->second.offset)) {
+        return nullptr;
+    }
+    const char* p = data.data() + sizeof(uint32_t) + path.size();
+    uint64_t blocks = 0;
+    uint64_t segments = 0;
+    found_ = FileRecord();
+    decode_fixed(p, found_, blocks, segments);
+    p += kRecordFixed;
+    found_.blocks.resize(blocks);
+    for (BlockRecord& block : found_.blocks) {
+        block.fingerprint = get_pod<uint64_t>(p);
+        block.entropy = get_pod<double>(p + sizeof(uint64_t));
+        p += kBlockBytes;
+    }
+    found_.segments.resize(segments);
+    for (SegmentHistogram& histogram : found_.segments) {
+        std::memcpy(histogram.data(), p, kSegmentHistogramBytes);
+        p += kSegmentHistogramBytes;
+    }
+    return &found_;
+}
+
+void DeltaCache::put(const std::string& path, FileRecord record) {
+    auto it = index_.find(path);
+    if (it != index_.end()) {
+        live_bytes_ -= it->second.length;
+        index_.erase(it);
+    }
+    // once a file is loaded records go straight to it, so a rescan of many
+    // files never holds more than one record in memory
+    Location where;
+    if (append(encode_record(path, &record), where)) {
+        pending_.erase(path);
+        index_[path] = where;
+        live_bytes_ += where.length;
+    } else {
+        pending_[path] = std::move(record);
+    }
+}
+
+size_t DeltaCache::evict_missing() {
+    auto missing = [](const std::string& path) {
+        struct stat st;
+        return ::lstat(path.c_str(), &st) != 0 && (errno == ENOENT || errno == ENOTDIR);
+    };
+    size_t evicted = 0;
+    for (auto it = index_.begin(); it != index_.end();) {
+        if (missing(it->first)) {
+            Location where;
+            append(encode_record(it->first, nullptr), where);
+            live_bytes_ -= it->second.length;
+            it = index_.erase(it);
+            ++evicted;
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (missing(it->first)) {
+            it = pending_.erase(it);
+            ++evicted;
+        } else {
+            ++it;
+        }
+    }
+    return evicted;
+}
+
+bool DeltaCache::save(const std::string& path) {
+    bool mostly_superseded = end_ - kHeaderSize > 2 * live_bytes_ + (1 << 20);
+    if (fd_ < 0 || path != path_ || must_rewrite_ || !pending_.empty() || mostly_superseded) {
+        return rewrite(path);
+    }
+    // the header is updated last, so a crash leaves the previous commit intact
+    std::string header = encode_header(end_);
+    if (::fdatasync(fd_) != 0 || !pwrite_all(fd_, header.data(), header.size(), 0)
+        || ::ftruncate(fd_, static_cast<off_t>(end_)) != 0) {
+        error_message_ = "Cannot write delta cache: " + path;
+        return false;
+    }
+    return true;
+}
+
+bool DeltaCache::rewrite(const std::string& path) {
+    std::string tmp_path = path + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        error_message_ = "Cannot write delta cache: " + tmp_path;
+        return false;
+    }
+
+    std::unordered_map<std::string, Location> index;
+    uint64_t offset = kHeaderSize;
+    bool ok = true;
+    std::string data;
+    for (const auto& [file_path, where] : index_) {
+        data.resize(static_cast<size_t>(where.length));
+        ok = pread_all(fd_, data.data(), data.size(), where.offset)
+            && pwrite_all(fd, data.data(), data.size(), offset);
+        if (!ok) break;
+        index.emplace(file_path, Location{offset, where.length});
+        offset += where.length;
+    }
+    for (auto it = pending_.begin(); ok && it != pending_.end(); ++it) {
+        data = encode_record(it->first, &it->second);
+        ok = pwrite_all(fd, data.data(), data.size(), offset);
+        index.emplace(it->first, Location{offset, data.size()});
+        offset += data.size();
+    }
+    std::string header = encode_header(offset);
+    ok = ok && pwrite_all(fd, header.data(), header.size(), 0) && ::fdatasync(fd) == 0;
+    if (!ok) {
+        error_message_ = "Cannot write delta cache: " + tmp_path;
+        ::close(fd);
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        error_message_ = "Cannot replace delta cache: " + path;
+        ::close(fd);
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+
+    // later puts and saves go to the new file
+    close_file();
+    pending_.clear();
+    index_ = std::move(index);
+    fd_ = fd;
+    path_ = path;
+    end_ = offset;
+    live_bytes_ = offset - kHeaderSize;
+    return true;
+}
+
+size_t DeltaCache::size() const {
+    return index_.size() + pending_.size();
+}
+
+const std::string& DeltaCache::get_error_message() const {
+    return error_message_;
+}
@@ -0,0 +1,164 @@
+#ifndef DELTA_CACHE_HPP
+#define DELTA_CACHE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct BlockRecord
+ * @brief What a previous scan learned about one block of a file.
+ */
+struct BlockRecord {
+    uint64_t fingerprint = 0;  // DeltaCache::fingerprint() of the block bytes
+    double entropy = 0.0;      // Shannon entropy of the block
+};
+
+/**
+ * @brief Byte frequencies of one segment of a file.
+ */
+using SegmentHistogram = std::array<uint32_t, 256>;
+
+/**
+ * @struct FileRecord
+ * @brief Per-block state of one file as of a previous scan.
+ *
+ * Histograms are kept per segment of segment_blocks consecutive blocks
+ * rather than per block, which keeps the cache a small fraction of the data.
+ */
+struct FileRecord {
+    uint64_t size = 0;            // file size in bytes when scanned
+    int64_t mtime_ns = 0;         // modification time when scanned
+    uint64_t block_size = 0;      // granularity of the blocks below
+    uint64_t segment_blocks = 1;  // blocks covered by each histogram
+    std::vector<BlockRecord> blocks;
+    std::vector<SegmentHistogram> segments;
+};
+
+/**
+ * @class DeltaCache
+ * @brief Persistent per-block fingerprints and per-segment histograms from earlier scans.
+ *
+ * Lets a rescan reuse the results of blocks that have not changed, and
+ * rebuild the file-level histogram by summing segment histograms instead of
+ * re-reading the whole file.
+ *
+ * The cache file is an append-only log of records behind a header that
+ * holds the committed length. load() reads only the record headers; a
+ * record's blocks are read when find() asks for them. Once a file has been
+ * loaded, put() appends to it straight away and save() commits the new
+ * records by updating the header, so a rescan writes only what changed.
+ * The file is rewritten only when superseded records outweigh live ones.
+ *
+ * The on-disk format is a private binary format in host byte order; it is not
+ * meant to be moved between machines of different endianness.
+ */
+class DeltaCache {
+public:
+    static constexpr size_t kSegmentBytes = 65536;
+
+    DeltaCache() = default;
+
+    /**
+     * @brief Closes the cache file. Records not yet saved are discarded.
+     */
+    ~DeltaCache();
+
+    DeltaCache(const DeltaCache&) = delete;
+    DeltaCache& operator=(const DeltaCache&) = delete;
+
+    /**
+     * @brief Computes a fast, non-cryptographic 64-bit fingerprint of a byte range.
+     *
+     * The length is mixed in, so ranges that differ only in length differ.
+     * Fingerprints detect accidental change, not deliberate collisions.
+     *
+     * @param data Pointer to the bytes.
+     * @param size Number of bytes.
+     * @return The fingerprint.
+     */
+    static uint64_t fingerprint(const unsigned char* data, size_t size);
+
+    /**
+     * @brief Returns how many blocks of @p block_size bytes share one histogram.
+     *
+     * Segments span kSegmentBytes, or a single block when blocks are larger.
+     */
+    static uint64_t segment_blocks(uint64_t block_size);
+
+    /**
+     * @brief Indexes the records in @p path, replacing any held in memory.
+     *
+     * A missing file is not an error and leaves the cache empty. Data after
+     * the committed length (from a run that never saved) is ignored.
+     *
+     * @return true on success, false if the file exists but is unreadable or
+     *         malformed (see get_error_message()).
+     */
+    bool load(const std::string& path);
+
+    /**
+     * @brief Makes all records durable in @p path.
+     *
+     * Commits the records appended to the loaded file, or writes a new file
+     * atomically (temporary file and rename) when @p path is another file,
+     * nothing was loaded, or most of the loaded file is superseded.
+     *
+     * @return true on success, false otherwise (see get_error_message()).
+     */
+    bool save(const std::string& path);
+
+    /**
+     * @brief Returns the record for @p path, or nullptr if there is none.
+     *
+     * The record stays valid until the next find() or load().
+     */
+    const FileRecord* find(const std::string& path);
+
+    /**
+     * @brief Stores or replaces the record for @p path.
+     */
+    void put(const std::string& path, FileRecord record);
+
+    /**
+     * @brief Drops the records of files that no longer exist.
+     *
+     * @return The number of records dropped.
+     */
+    size_t evict_missing();
+
+    /**
+     * @brief Returns the number of files with records.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Returns the error message of the last failed load() or save().
+     */
+    const std::string& get_error_message() const;
+
+private:
+    struct Location {
+        uint64_t offset = 0;  // start of the record in the file
+        uint64_t length = 0;  // bytes of the whole record
+    };
+
+    void close_file();
+    bool append(const std::string& data, Location& where);
+    bool rewrite(const std::string& path);
+
+    std::unordered_map<std::string, Location> index_;       // records in the file
+    std::unordered_map<std::string, FileRecord> pending_;  // records not in the file yet
+    std::string path_;      // the loaded file, if any
+    int fd_ = -1;
+    uint64_t end_ = 0;      // end of the records written so far
+    uint64_t live_bytes_ = 0;
+    bool must_rewrite_ = false;  // an append failed, so the file misses changes
+    FileRecord found_;
+    std::string error_message_;
+};
+
+#endif // DELTA_CACHE_HPP
@@ -0,0 +1,223 @@
+#include "delta_scanner.hpp"
+#include "block_entropy_scanner.hpp"
+#include "entropy_calculator.hpp"
+#include "file_reader.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <utility>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // bytes requested per read; rounded down to a whole number of blocks
+    constexpr size_t kReadChunk = 1 << 20;
+
+} // namespace
+
+DeltaScanner::DeltaScanner(DeltaCache& cache)
+    : cache_(cache) {}
+
+bool DeltaScanner::analyze(const std::string& path, const ScanOptions& options) {
+    has_entry_ = false;
+    file_entropy_ = 0.0;
+    file_size_ = 0;
+    bytes_read_ = 0;
+    blocks_reused_ = 0;
+
+    std::error_code size_ec, time_ec;
+    uint64_t size = fs::file_size(path, size_ec);
+    auto mtime = fs::last_write_time(path, time_ec);
+    if (size_ec || time_ec) {
+        error_message_ = "Failed to open file: " + path;
+        return false;
+    }
+
+    FileRecord record;
+    record.size = size;
+    record.mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        mtime.time_since_epoch()).count();
+    record.block_size = options.block_size > 0 ? options.block_size : kDefaultBlockSize;
+    record.segment_blocks = DeltaCache::segment_blocks(record.block_size);
+
+    const FileRecord* old = cache_.find(path);
+    if (old && (old->block_size != record.block_size || old->segment_blocks != record.segment_blocks)) {
+        old = nullptr;
+    }
+
+    const bool unchanged = old && old->size == record.size && old->mtime_ns == record.mtime_ns;
+    if (unchanged) {
+        record.blocks = old->blocks;
+        record.segments = old->segments;
+        blocks_reused_ = record.blocks.size();
+    } else {
+        FileReader reader(path);
+        Resume resume;
+        if (old && size > old->size && is_append(reader, *old, size)) {
+            // keep every previously complete block; the old partial tail is
+            // re-read, but its bytes are already in the last segment histogram
+            size_t keep = old->size / old->block_size;
+            size_t segment = keep / record.segment_blocks;
+            record.blocks.assign(old->blocks.begin(), old->blocks.begin() + keep);
+            record.segments.assign(old->segments.begin(), old->segments.begin() + segment);
+            if (segment < old->segments.size()) {
+                resume.histogram = old->segments[segment];
+            }
+            blocks_reused_ = keep;
+            resume.start = keep * record.block_size;
+            resume.counted = old->size;
+        }
+        if (!read_blocks(reader, resume, old, record)) {
+            error_message_ = reader.get_error_message();
+            return false;
+        }
+    }
+    error_message_.clear();
+
+    // merge segment histograms into the file histogram
+    std::array<size_t, 256>& histogram = ctx_.histogram();
+    ctx_.clear_histogram();
+    for (const SegmentHistogram& segment : record.segments) {
+        for (size_t b = 0; b < 256; ++b) {
+            histogram[b] += segment[b];
+        }
+    }
+
+    file_size_ = record.size;
+    if (record.size > 0) {
+        double file_entropy = EntropyCalculator::entropy_from_histogram(histogram, record.size);
+        file_entropy_ = file_entropy;
+        ctx_.reset_results();
+        std::vector<std::pair<size_t, double>>& blocks = ctx_.results();
+        if (options.block_size > 0) {
+            for (size_t i = 0; i < record.blocks.size(); ++i) {
+                if (record.blocks[i].entropy >= options.entropy_threshold) {
+                    blocks.emplace_back(i * record.block_size, record.blocks[i].entropy);
+                }
+            }
+        }
+        has_entry_ = FileAnalyzer::make_entry(path, options, file_entropy, blocks, entry_);
+    }
+
+    if (!unchanged) {
+        cache_.put(path, std::move(record));  // an unchanged record is already stored
+    }
+    return true;
+}
+
+bool DeltaScanner::is_append(FileReader& reader, const FileRecord& old, uint64_t size) {
+    size_t full_blocks = old.size / old.block_size;
+    if (full_blocks == 0 || size < old.size) {
+        return false;
+    }
+    // a rewrite that keeps the head and the old end intact is indistinguishable
+    // from an append here; both endpoints are checked to catch the common cases
+    for (size_t index : {size_t{0}, full_blocks - 1}) {
+        if (!reader.read_range(index * old.block_size, old.block_size)) {
+            return false;
+        }
+        const std::vector<uint8_t>& data = reader.get_data();
+        bytes_read_ += data.size();
+        if (data.size() != old.block_size
+            || DeltaCache::fingerprint(data.data(), data.size()) != old.blocks[index].fingerprint) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DeltaScanner::read_blocks(
+    FileReader& reader,
+    const Resume& resume,
+    const FileRecord* old,
+    FileRecord& record
+) {
+    const size_t block_size = record.block_size;
+    const uint64_t segment_bytes = block_size * record.segment_blocks;
+    const size_t chunk = std::max(block_size, kReadChunk / block_size * block_size);
+    uint64_t offset = resume.start;
+    SegmentHistogram histogram = resume.histogram;
+
+    while (offset < record.size) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(chunk, record.size - offset));
+        if (!reader.read_range(offset, want)) {
+            return false;
+        }
+        const std::vector<uint8_t>& data = reader.get_data();
+        bytes_read_ += data.size();
+        if (data.empty()) {
+            break;  // file shrank while we were reading
+        }
+
+        for (size_t pos = 0; pos < data.size(); pos += block_size) {
+            size_t len = std::min(block_size, data.size() - pos);
+            size_t index = static_cast<size_t>((offset + pos) / block_size);
+            uint64_t fingerprint = DeltaCache::fingerprint(data.data() + pos, len);
+
+            // bytes before resume.counted are already in the resumed histogram
+            uint64_t end = offset + pos + len;
+            size_t from = pos + static_cast<size_t>(
+                std::min<uint64_t>(len, resume.counted - std::min(resume.counted, offset + pos)));
+            for (size_t i = from; i < pos + len; ++i) {
+                histogram[data[i]]++;
+            }
+            if (end % segment_bytes == 0) {
+                record.segments.push_back(histogram);
+                histogram.fill(0);
+            }
+
+            if (old && index < old->blocks.size() && old->blocks[index].fingerprint == fingerprint) {
+                record.blocks.push_back(old->blocks[index]);
+                ++blocks_reused_;
+                continue;
+            }
+
+            BlockRecord block;
+            block.fingerprint = fingerprint;
+            // same entropy path as a full scan so thresholds behave identically
+            block.entropy = BlockEntropyScanner::scan(
+                data.data() + pos, len, block_size, 0.0, ctx_).front().second;
+            record.blocks.push_back(block);
+        }
+        offset += data.size();
+    }
+    // the last segment may be partial
+    if (record.segments.size() * record.segment_blocks < record.blocks.size()) {
+        record.segments.push_back(histogram);
+    }
+    record.size = offset;
+    return true;
+}
+
+const nlohmann::json& DeltaScanner::get_entry() const {
+    return entry_;
+}
+
+nlohmann::json DeltaScanner::take_entry() {
+    return std::move(entry_);
+}
+
+bool DeltaScanner::has_entry() const {
+    return has_entry_;
+}
+
+double DeltaScanner::get_file_entropy() const {
+    return file_entropy_;
+}
+
+uint64_t DeltaScanner::get_file_size() const {
+    return file_size_;
+}
+
+const std::string& DeltaScanner::get_error_message() const {
+    return error_message_;
+}
+
+uint64_t DeltaScanner::get_bytes_read() const {
+    return bytes_read_;
+}
+
+size_t DeltaScanner::get_blocks_reused() const {
+    return blocks_reused_;
+}
@@ -0,0 +1,110 @@
+#ifndef DELTA_SCANNER_HPP
+#define DELTA_SCANNER_HPP
+
+#include "delta_cache.hpp"
+#include "file_analyzer.hpp"
+#include "scan_context.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+class FileReader;
+
+/**
+ * @class DeltaScanner
+ * @brief Re-analyzes files incrementally using per-block state from a DeltaCache.
+ *
+ * Produces the same report entries as FileAnalyzer, while reading as little
+ * of each file as possible:
+ *
+ * - Unchanged size and mtime: nothing is read; cached blocks are reused.
+ * - Grown file whose first and last previously complete blocks still match
+ *   their fingerprints: treated as an append, only the tail is read.
+ * - Anything else: the file is read once, and blocks whose fingerprint still
+ *   matches reuse their cached entropy.
+ *
+ * The file-level entropy is always recomputed by summing segment histograms.
+ * In global mode blocks of kDefaultBlockSize bytes are tracked internally.
+ */
+class DeltaScanner {
+public:
+    static constexpr size_t kDefaultBlockSize = 65536;
+
+    /**
+     * @brief Constructs a scanner that reads and updates @p cache.
+     */
+    explicit DeltaScanner(DeltaCache& cache);
+
+    /**
+     * @brief Analyzes the file at @p path and records its blocks in the cache.
+     *
+     * @return true if the file was analyzed, false on error (see get_error_message()).
+     */
+    bool analyze(const std::string& path, const ScanOptions& options);
+
+    /**
+     * @brief Returns whether the last analysis produced a report entry.
+     */
+    bool has_entry() const;
+
+    /**
+     * @brief Returns the report entry of the last analysis.
+     */
+    const nlohmann::json& get_entry() const;
+
+    /**
+     * @brief Moves the report entry of the last analysis out of the scanner.
+     */
+    nlohmann::json take_entry();
+
+    /**
+     * @brief Returns the whole-file entropy of the last analysis.
+     *
+     * Set whether or not an entry was produced; 0.0 for empty files.
+     */
+    double get_file_entropy() const;
+
+    /**
+     * @brief Returns the size in bytes of the last analyzed file.
+     */
+    uint64_t get_file_size() const;
+
+    /**
+     * @brief Returns the error message of the last failed analyze() call.
+     */
+    const std::string& get_error_message() const;
+
+    /**
+     * @brief Returns the number of bytes read from disk by the last analyze() call.
+     */
+    uint64_t get_bytes_read() const;
+
+    /**
+     * @brief Returns the number of blocks reused from the cache by the last analyze() call.
+     */
+    size_t get_blocks_reused() const;
+
+private:
+    // where read_blocks() starts, and what an append already knows
+    struct Resume {
+        uint64_t start = 0;            // first byte to read; a block boundary
+        uint64_t counted = 0;          // bytes already in histogram
+        SegmentHistogram histogram{};  // the segment holding start, up to counted
+    };
+
+    bool is_append(FileReader& reader, const FileRecord& old, uint64_t size);
+    bool read_blocks(FileReader& reader, const Resume& resume, const FileRecord* old, FileRecord& record);
+
+    DeltaCache& cache_;
+    ScanContext ctx_;
+    nlohmann::json entry_;
+    bool has_entry_ = false;
+    double file_entropy_ = 0.0;
+    uint64_t file_size_ = 0;
+    std::string error_message_;
+    uint64_t bytes_read_ = 0;
+    size_t blocks_reused_ = 0;
+};
+
+#endif // DELTA_SCANNER_HPP
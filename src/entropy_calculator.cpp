@@ -1,30 +1,48 @@
 #include "entropy_calculator.hpp"
 #include <cmath>
 #include <iostream> 
+#include <stdexcept>
 
 EntropyCalculator::EntropyCalculator(const std::vector<unsigned char>& data)
-    : data_(data), total_bytes_(data.size()) {
+    : total_bytes_(data.size()) {
     
     if (data.empty()) {
         throw std::invalid_argument("Data cannot be empty.");
     }        
 
     byte_freq_.fill(0);  // zero initialize just in case
+    accumulate_histogram(data.data(), data.size(), byte_freq_);
+}
+
+void EntropyCalculator::calculate_entropy() {
+    entropy_ = entropy_from_histogram(byte_freq_, total_bytes_);
+}
 
-    for (unsigned char byte : data_) {
-        byte_freq_[byte]++;
+void EntropyCalculator::accumulate_histogram(
+    const unsigned char* data,
+    size_t size,
+    std::array<size_t, 256>& histogram
+) {
+    for (size_t i = 0; i < size; ++i) {
+        histogram[data[i]]++;
     }
 }
 
-void EntropyCalculator::calculate_entropy() {
+double EntropyCalculator::entropy_from_histogram(
+    const std::array<size_t, 256>& histogram,
+    size_t total_bytes
+) {
+    if (total_bytes == 0) {
+        return 0.0;
+    }
     double entropy = 0.0;
-    for (const size_t& freq : byte_freq_) {
+    for (const size_t& freq : histogram) {
         if (freq > 0) {
-            double probability = static_cast<double>(freq) / total_bytes_;
+            double probability = static_cast<double>(freq) / total_bytes;
             entropy -= probability * log2(probability);
         }
     }
-    entropy_ = entropy;
+    return entropy;
 }
 
 size_t EntropyCalculator::get_total_bytes() const {
@@ -26,7 +26,7 @@ public:
      * @brief Constructs an EntropyCalculator with the provided data.
      *
      * Initializes the entropy calculator using a vector of raw byte values.
-     * The data is stored internally for entropy analysis.
+     * The byte histogram is built immediately; the data itself is not retained.
      *
      * @param data A vector of unsigned bytes representing the input data to analyze.
      */
@@ -90,10 +90,38 @@ public:
      */
     size_t get_total_bytes() const;
 
+    /**
+     * @brief Adds the byte frequencies of a buffer to an existing histogram.
+     *
+     * The histogram is not cleared first, so repeated calls accumulate counts
+     * across buffers. No memory is allocated.
+     *
+     * @param data Pointer to the bytes to count.
+     * @param size Number of bytes to count.
+     * @param histogram The 256-element histogram to add into.
+     */
+    static void accumulate_histogram(
+        const unsigned char* data,
+        size_t size,
+        std::array<size_t, 256>& histogram
+    );
+
+    /**
+     * @brief Computes the Shannon entropy of a byte frequency histogram.
+     *
+     * @param histogram A 256-element byte frequency array.
+     * @param total_bytes The sum of all counts in @p histogram.
+     *
+     * @return The entropy in bits per byte, or 0.0 if @p total_bytes is zero.
+     */
+    static double entropy_from_histogram(
+        const std::array<size_t, 256>& histogram,
+        size_t total_bytes
+    );
+
 private:
     std::array<size_t, 256> byte_freq_;  // Byte frequencies
     size_t total_bytes_;                 // Total number of bytes
-    std::vector<unsigned char> data_; 
     mutable double entropy_ = -1.0;
     std::size_t compute_total_bytes() const;
 };
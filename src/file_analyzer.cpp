@@ -0,0 +1,431 @@
+#include "file_analyzer.hpp"
+#include "byte_source.hpp"
+#include "entropy_calculator.hpp"
+#include "block_entropy_scanner.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+using json = nlohmann::json;
+
+namespace {
+
+    // the reporting rule shared by make_entry() and the lazy entry in analyze_buffer()
+    bool meets_threshold(
+        const ScanOptions& options,
+        double file_entropy,
+        const std::vector<std::pair<size_t, double>>& blocks
+    ) {
+        if (options.block_size > 0) {
+            return !blocks.empty();
+        }
+        return file_entropy >= options.entropy_threshold;
+    }
+
+    // the entry layout shared by make_entry() and get_entry()
+    void build_entry(
+        const std::string& path,
+        const ScanOptions& options,
+        double file_entropy,
+        const std::vector<std::pair<size_t, double>>& blocks,
+        json& entry
+    ) {
+        // block scan mode
+        if (options.block_size > 0) {
+
+            json jblocks = json::array();
+            for (const auto& [offset, entropy] : blocks) {
+                json block;
+                block["offset"] = offset;
+                block["entropy"] = entropy;
+                jblocks.push_back(block);
+            }
+            entry = json::object();
+            entry["path"] = path;
+            entry["threshold"] = options.entropy_threshold;
+            entry["type"] = "block";
+            entry["blocks"] = std::move(jblocks);
+            entry["file_entropy"] = file_entropy;
+        }
+        else {
+            // global scan mode
+            entry = json::object();
+            entry["path"] = path;
+            entry["threshold"] = options.entropy_threshold;
+            entry["type"] = "global";
+            entry["entropy"] = file_entropy;
+        }
+    }
+
+    // a pool reservation returned when the stream ends, however it ends
+    class Reservation {
+    public:
+        Reservation(BufferPool* pool, size_t bytes) : pool_(pool), bytes_(bytes) {}
+        ~Reservation() {
+            if (pool_ && bytes_ > 0) pool_->release(bytes_);
+        }
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+
+    private:
+        BufferPool* pool_;
+        size_t bytes_;
+    };
+
+} // namespace
+
+FileAnalyzer::FileAnalyzer(FileAnalyzer&& other) noexcept
+    : ctx_(std::move(other.ctx_)),
+      entry_(std::move(other.entry_)),
+      entry_built_(other.entry_built_),
+      entry_path_(std::move(other.entry_path_)),
+      entry_options_(other.entry_options_),
+      has_entry_(other.has_entry_),
+      file_entropy_(other.file_entropy_),
+      file_size_(other.file_size_),
+      error_message_(std::move(other.error_message_)),
+      dir_fd_(std::exchange(other.dir_fd_, -1)),
+      dir_path_(std::move(other.dir_path_)),
+      dir_verified_(other.dir_verified_),
+      pool_(other.pool_),
+      progress_(std::move(other.progress_)),
+      on_progress_(std::move(other.on_progress_)),
+      block_sink_(std::move(other.block_sink_)),
+      sunk_blocks_(other.sunk_blocks_) {}
+
+FileAnalyzer& FileAnalyzer::operator=(FileAnalyzer&& other) noexcept {
+    if (this != &other) {
+        if (dir_fd_ >= 0) ::close(dir_fd_);
+        ctx_ = std::move(other.ctx_);
+        entry_ = std::move(other.entry_);
+        entry_built_ = other.entry_built_;
+        entry_path_ = std::move(other.entry_path_);
+        entry_options_ = other.entry_options_;
+        has_entry_ = other.has_entry_;
+        file_entropy_ = other.file_entropy_;
+        file_size_ = other.file_size_;
+        error_message_ = std::move(other.error_message_);
+        dir_fd_ = std::exchange(other.dir_fd_, -1);
+        dir_path_ = std::move(other.dir_path_);
+        dir_verified_ = other.dir_verified_;
+        pool_ = other.pool_;
+        progress_ = std::move(other.progress_);
+        on_progress_ = std::move(other.on_progress_);
+        block_sink_ = std::move(other.block_sink_);
+        sunk_blocks_ = other.sunk_blocks_;
+    }
+    return *this;
+}
+
+FileAnalyzer::~FileAnalyzer() {
+    if (dir_fd_ >= 0) {
+        ::close(dir_fd_);
+    }
+}
+
+bool FileAnalyzer::analyze(const std::string& path, const ScanOptions& options) {
+    bool claimed = false;
+    return analyze(path, options, nullptr, claimed);
+}
+
+bool FileAnalyzer::analyze(const std::string& path, const ScanOptions& options, const ProbeFilter& claim,
+                           bool& claimed) {
+    has_entry_ = false;
+    sunk_blocks_ = 0;
+    claimed = false;
+    bool is_small = false;
+    if (!read_small(path, is_small)) {
+        return false;
+    }
+    // file_size_ holds the bytes of the probe here
+    if (claim && claim(ctx_.scratch(0).data(), static_cast<size_t>(file_size_))) {
+        claimed = true;
+        error_message_.clear();
+        return true;
+    }
+    if (is_small) {
+        error_message_.clear();
+        analyze_buffer(path, ctx_.scratch(0).data(), static_cast<size_t>(file_size_), options);
+        return true;
+    }
+
+    // the probe read is served again from the page cache; only large files get here
+    progress_.offset = 0;
+    progress_.histogram.fill(0);
+    progress_.blocks.clear();
+    FileSource source(path);
+    return analyze_stream(path, source, options, on_progress_);
+}
+
+bool FileAnalyzer::resume(const std::string& path, const ScanOptions& options, const FileProgress& from) {
+    has_entry_ = false;
+    progress_ = from;
+    FileSource source(path);
+    source.skip(from.offset);
+    return analyze_stream(path, source, options, on_progress_);
+}
+
+bool FileAnalyzer::analyze_source(const std::string& path, ByteSource& source, const ScanOptions& options,
+                                  const ProgressCallback& on_progress) {
+    has_entry_ = false;
+    progress_.offset = 0;
+    progress_.histogram.fill(0);
+    progress_.blocks.clear();
+    return analyze_stream(path, source, options, on_progress);
+}
+
+void FileAnalyzer::set_buffer_pool(BufferPool* pool) {
+    pool_ = pool;
+}
+
+void FileAnalyzer::set_progress_callback(ProgressCallback callback) {
+    on_progress_ = std::move(callback);
+}
+
+void FileAnalyzer::set_block_sink(BlockSink sink) {
+    block_sink_ = std::move(sink);
+}
+
+bool FileAnalyzer::analyze_stream(const std::string& path, ByteSource& source, const ScanOptions& options,
+                                  const ProgressCallback& on_progress) {
+    entry_built_ = false;
+    file_entropy_ = 0.0;
+    sunk_blocks_ = 0;
+
+    // chunks hold whole blocks, so per-chunk block scans match a whole-file scan
+    const size_t granule = options.block_size > 0 ? options.block_size : 1;
+    BufferPool::Buffer lease;
+    unsigned char* buffer;
+    size_t chunk;
+    if (pool_) {
+        size_t minimum = std::max(granule, kSmallFileLimit / granule * granule);
+        lease = pool_->acquire(kStreamChunk, minimum, granule);
+        buffer = lease.data();
+        chunk = lease.size();
+    } else {
+        chunk = std::max(granule, kStreamChunk / granule * granule);
+        buffer = ctx_.scratch(chunk).data();
+    }
+
+    // with a sink, blocks leave in runs instead of piling up for the whole
+    // file; the most a run can hold is charged to the pool while streaming
+    size_t run_limit = 0;  // 0: blocks are held until the end
+    size_t reserved = 0;
+    if (block_sink_ && options.block_size > 0) {
+        run_limit = kBlockRun;
+        reserved = (kBlockRun + chunk / options.block_size) * sizeof(progress_.blocks[0]);
+        if (pool_ && !pool_->try_reserve(reserved)) {
+            run_limit = 1;  // refused: each chunk's blocks go out straight away
+            reserved = 0;
+        }
+    }
+    Reservation reservation(pool_, reserved);
+    auto sink_blocks = [&]() {
+        block_sink_(progress_.blocks, sunk_blocks_ == 0);
+        sunk_blocks_ += progress_.blocks.size();
+        progress_.blocks.clear();
+    };
+
+    uint64_t& offset = progress_.offset;
+    while (true) {
+        size_t got = 0;
+        if (!source.read(buffer, chunk, got)) {
+            error_message_ = source.get_error_message();
+            return false;
+        }
+        if (got == 0) break;
+        EntropyCalculator::accumulate_histogram(buffer, got, progress_.histogram);
+        if (options.block_size > 0) {
+            for (const auto& [block, entropy] : BlockEntropyScanner::scan(
+                    buffer, got, options.block_size, options.entropy_threshold, ctx_)) {
+                progress_.blocks.emplace_back(offset + block, entropy);
+            }
+            if (run_limit > 0 && progress_.blocks.size() >= run_limit) {
+                sink_blocks();
+            }
+        }
+        offset += got;
+        if (got < chunk) break;
+        if (on_progress && !on_progress(progress_)) {
+            error_message_ = "Analysis stopped: " + path;
+            return false;
+        }
+    }
+    error_message_.clear();
+
+    file_size_ = offset;
+    if (offset == 0) {
+        return true;
+    }
+    file_entropy_ = EntropyCalculator::entropy_from_histogram(progress_.histogram, offset);
+    if (sunk_blocks_ > 0 && !progress_.blocks.empty()) {
+        sink_blocks();  // the rest follows the runs already delivered
+    }
+    // hand the gathered blocks to the context, where get_entry() reads them
+    ctx_.results().swap(progress_.blocks);
+    has_entry_ = sunk_blocks_ > 0 || meets_threshold(options, file_entropy_, ctx_.results());
+    if (has_entry_) {
+        entry_path_ = path;
+        entry_options_ = options;
+    }
+    return true;
+}
+
+bool FileAnalyzer::read_small(const std::string& path, bool& is_small) {
+    is_small = false;
+    int fd = open_in_directory(path);
+    if (fd < 0) {
+        error_message_ = "Failed to open file: " + path;
+        return false;
+    }
+
+    // one byte past the limit tells a small file from a large one without
+    // fstat(); a short read of a regular file means end of file, so one
+    // read() is enough
+    std::vector<unsigned char>& buffer = ctx_.scratch(kSmallFileLimit + 1);
+    ssize_t n;
+    do {
+        n = ::read(fd, buffer.data(), kSmallFileLimit + 1);
+    } while (n < 0 && errno == EINTR);
+    ::close(fd);
+    if (n < 0) {
+        error_message_ = "Failed to read file: " + path;
+        return false;
+    }
+    is_small = static_cast<size_t>(n) <= kSmallFileLimit;
+    file_size_ = static_cast<uint64_t>(n);
+    return true;
+}
+
+void FileAnalyzer::revalidate_directory() {
+    dir_verified_ = false;
+}
+
+bool FileAnalyzer::directory_matches() const {
+    struct stat cached;
+    struct stat current;
+    return ::fstat(dir_fd_, &cached) == 0 && ::stat(dir_path_.c_str(), &current) == 0
+        && cached.st_dev == current.st_dev && cached.st_ino == current.st_ino;
+}
+
+int FileAnalyzer::open_in_directory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    if (slash == std::string::npos) {
+        return ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    const char* name = path.c_str() + slash + 1;
+    // files of one directory usually arrive together; reuse its descriptor.
+    // The directory may have been renamed or re-created since it was opened
+    // (between watch events or daemon requests), so the descriptor is checked
+    // against its path once after revalidate_directory(), and when openat() fails.
+    size_t dir_len = slash == 0 ? 1 : slash;
+    bool reuse = dir_fd_ >= 0 && dir_path_.size() == dir_len && path.compare(0, dir_len, dir_path_) == 0
+        && (dir_verified_ || directory_matches());
+    if (reuse) {
+        dir_verified_ = true;
+        int fd = ::openat(dir_fd_, name, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0 || directory_matches()) {
+            return fd;
+        }
+    }
+    if (dir_fd_ >= 0) ::close(dir_fd_);
+    dir_path_.assign(path, 0, dir_len);
+    dir_fd_ = ::open(dir_path_.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+    dir_verified_ = true;
+    if (dir_fd_ < 0) {
+        dir_path_.clear();
+        return ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    }
+    return ::openat(dir_fd_, name, O_RDONLY | O_CLOEXEC);
+}
+
+void FileAnalyzer::analyze_buffer(
+    const std::string& path,
+    const unsigned char* data,
+    size_t size,
+    const ScanOptions& options
+) {
+    has_entry_ = false;
+    entry_built_ = false;
+    file_entropy_ = 0.0;
+    file_size_ = size;
+    sunk_blocks_ = 0;
+    if (size == 0) {
+        return;
+    }
+
+    // file-level histogram is needed in both modes (block mode reports it too)
+    std::array<size_t, 256>& histogram = ctx_.histogram();
+    ctx_.clear_histogram();
+    EntropyCalculator::accumulate_histogram(data, size, histogram);
+    double file_entropy = EntropyCalculator::entropy_from_histogram(histogram, size);
+    file_entropy_ = file_entropy;
+
+    ctx_.reset_results();
+    if (options.block_size > 0) {
+        BlockEntropyScanner::scan(
+            data,
+            size,
+            options.block_size,
+            options.entropy_threshold,
+            ctx_
+        );
+    }
+    has_entry_ = meets_threshold(options, file_entropy, ctx_.results());
+    if (has_entry_) {
+        entry_path_ = path;
+        entry_options_ = options;
+    }
+}
+
+bool FileAnalyzer::make_entry(
+    const std::string& path,
+    const ScanOptions& options,
+    double file_entropy,
+    const std::vector<std::pair<size_t, double>>& blocks,
+    json& entry
+) {
+    if (!meets_threshold(options, file_entropy, blocks)) {
+        return false;
+    }
+    build_entry(path, options, file_entropy, blocks, entry);
+    return true;
+}
+
+bool FileAnalyzer::has_entry() const {
+    return has_entry_;
+}
+
+const json& FileAnalyzer::get_entry() const {
+    if (has_entry_ && !entry_built_) {
+        // a file whose blocks went to the sink has its entry without them
+        build_entry(entry_path_, entry_options_, file_entropy_, ctx_.results(), entry_);
+        entry_built_ = true;
+    }
+    return entry_;
+}
+
+json FileAnalyzer::take_entry() {
+    get_entry();
+    entry_built_ = false;
+    return std::move(entry_);
+}
+
+double FileAnalyzer::get_file_entropy() const {
+    return file_entropy_;
+}
+
+size_t FileAnalyzer::get_sunk_block_count() const {
+    return sunk_blocks_;
+}
+
+uint64_t FileAnalyzer::get_file_size() const {
+    return file_size_;
+}
+
+const std::string& FileAnalyzer::get_error_message() const {
+    return error_message_;
+}
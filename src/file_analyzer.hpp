@@ -0,0 +1,289 @@
+#ifndef FILE_ANALYZER_HPP
+#define FILE_ANALYZER_HPP
+
+#include "buffer_pool.hpp"
+#include "scan_context.hpp"
+#include <array>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+class ByteSource;
+
+/**
+ * @struct ScanOptions
+ * @brief Per-scan settings shared by the CLI and the daemon.
+ */
+struct ScanOptions {
+    double entropy_threshold = 0.0;  // report files/blocks at or above this entropy
+    size_t block_size = 0;           // 0 for whole-file entropy, else block scan size
+};
+
+/**
+ * @struct FileProgress
+ * @brief How far the streamed analysis of a large file has got.
+ *
+ * Everything needed to continue from @c offset without re-reading the
+ * bytes before it.
+ */
+struct FileProgress {
+    uint64_t offset = 0;                            // bytes analyzed; a whole number of blocks
+    std::array<size_t, 256> histogram{};            // byte counts of [0, offset)
+    std::vector<std::pair<size_t, double>> blocks;  // qualifying blocks before offset
+};
+
+/**
+ * @class FileAnalyzer
+ * @brief Reads a file and produces its JSON report entry.
+ *
+ * Wraps FileReader, EntropyCalculator and BlockEntropyScanner behind a single
+ * call. Each analyzer owns a ScanContext, so one analyzer per worker thread
+ * can be reused across files without per-block allocations.
+ *
+ * An entry is only produced when something meets the threshold: the file
+ * entropy in global mode, or at least one block in block mode. Empty files
+ * never produce an entry. The JSON entry itself is built on the first
+ * get_entry() call, so callers that only need has_entry() (summaries,
+ * unreported files) never pay for it.
+ *
+ * Files of at most kSmallFileLimit bytes take a fast path: they are opened
+ * relative to a cached descriptor of their directory (see
+ * revalidate_directory()) and read with a single read() into the context's
+ * scratch buffer, without a FileReader or any per-file allocation. Larger
+ * files are streamed through FileReader in chunks of whole blocks, so memory
+ * use does not depend on file size.
+ * Stream buffers come from a shared BufferPool when one is set, and a
+ * progress callback can observe (and stop) a stream after every chunk.
+ */
+class FileAnalyzer {
+public:
+    static constexpr size_t kSmallFileLimit = 64 * 1024;
+    static constexpr size_t kStreamChunk = 8 << 20;  // preferred read size for large files
+
+    /**
+     * @brief Called after each streamed chunk that is not the last; return false to stop.
+     */
+    using ProgressCallback = std::function<bool(const FileProgress& progress)>;
+
+    /**
+     * @brief Looks at the first bytes of a file; return true to claim it (see analyze()).
+     */
+    using ProbeFilter = std::function<bool(const unsigned char* data, size_t size)>;
+
+    /**
+     * @brief Receives the qualifying blocks of a streamed file in runs, in file order.
+     *
+     * @p first marks the first run of a file. A file that fails after some
+     * of its runs were delivered sends no further runs.
+     */
+    using BlockSink = std::function<void(const std::vector<std::pair<size_t, double>>& blocks, bool first)>;
+
+    static constexpr size_t kBlockRun = 4096;  // blocks held per streamed file before they go to a sink
+
+    FileAnalyzer() = default;
+    FileAnalyzer(FileAnalyzer&& other) noexcept;
+    FileAnalyzer& operator=(FileAnalyzer&& other) noexcept;
+    ~FileAnalyzer();
+
+    /**
+     * @brief Reads and analyzes the file at @p path.
+     *
+     * @param path The file to analyze.
+     * @param options The threshold and block size to apply.
+     *
+     * @return true if the file was read, false on a read error (see get_error_message()).
+     */
+    bool analyze(const std::string& path, const ScanOptions& options);
+
+    /**
+     * @brief Analyzes the file at @p path unless @p claim takes it, judging by its start.
+     *
+     * @p claim sees the bytes of the small-file probe read (up to
+     * kSmallFileLimit + 1, the whole file if smaller), so recognizing a file
+     * format costs no extra open or read. A claimed file is not analyzed.
+     *
+     * @param claimed Set to whether @p claim returned true.
+     *
+     * @return true if the file was read, false on a read error (see get_error_message()).
+     */
+    bool analyze(const std::string& path, const ScanOptions& options, const ProbeFilter& claim,
+                 bool& claimed);
+
+    /**
+     * @brief Takes stream buffers for large files from @p pool.
+     *
+     * With a pool, reads stall or shrink (down to one block, at least 64 KiB)
+     * while the pool's budget is exhausted. Pass nullptr to use a private
+     * buffer again. The pool must outlive the analyzer's use of it.
+     */
+    void set_buffer_pool(BufferPool* pool);
+
+    /**
+     * @brief Reports the progress of large files through @p callback.
+     *
+     * When the callback returns false, analyze() and resume() fail with an
+     * "Analysis stopped" error. Files on the small-file path are read in one
+     * call and never reported. Pass an empty callback to stop reporting.
+     */
+    void set_progress_callback(ProgressCallback callback);
+
+    /**
+     * @brief Hands the blocks of streamed files to @p sink rather than holding them all.
+     *
+     * Streamed files (large files and sources) then hold at most about
+     * kBlockRun blocks plus one chunk's worth, charged to the buffer pool
+     * if one is set; when the pool refuses, every chunk's blocks go straight
+     * to the sink. A file with more blocks than that delivers all of them to
+     * the sink, and its entry then has an empty "blocks" array (see
+     * get_sunk_block_count()). Progress reports see only the blocks not yet
+     * delivered. Pass an empty sink to hold all blocks again.
+     */
+    void set_block_sink(BlockSink sink);
+
+    /**
+     * @brief Checks the cached directory descriptor against its path before next using it.
+     *
+     * A directory renamed or re-created since its descriptor was cached is
+     * otherwise only noticed when a file cannot be opened through it.
+     * Long-running callers call this once per batch of events or request,
+     * so the check is not paid for every file.
+     */
+    void revalidate_directory();
+
+    /**
+     * @brief Continues analyzing @p path from a previously reported progress.
+     *
+     * Produces the same results as analyze() would for the whole file,
+     * provided the bytes before @p from.offset have not changed.
+     *
+     * @return true if the rest of the file was read, false on a read error.
+     */
+    bool resume(const std::string& path, const ScanOptions& options, const FileProgress& from);
+
+    /**
+     * @brief Analyzes bytes already in memory as if they were the file @p path.
+     *
+     * @param path The path to record in the report entry.
+     * @param data Pointer to the file contents.
+     * @param size Number of bytes at @p data.
+     * @param options The threshold and block size to apply.
+     */
+    void analyze_buffer(
+        const std::string& path,
+        const unsigned char* data,
+        size_t size,
+        const ScanOptions& options
+    );
+
+    /**
+     * @brief Streams @p source to its end and analyzes it as if it were the file @p path.
+     *
+     * Used for data without a file of its own, such as archive members.
+     * Reads go through the same chunked path as large files (and the buffer
+     * pool, if set). @p on_progress, not the callback given to
+     * set_progress_callback(), is called after each chunk.
+     *
+     * @return true if the source was read to its end, false on a read error
+     *         or when @p on_progress returned false.
+     */
+    bool analyze_source(const std::string& path, ByteSource& source, const ScanOptions& options,
+                        const ProgressCallback& on_progress = nullptr);
+
+    /**
+     * @brief Builds a report entry from already computed results.
+     *
+     * Applies the same reporting rule as analyze(): in block mode an entry is
+     * produced only if @p blocks is non-empty, in global mode only if
+     * @p file_entropy meets the threshold.
+     *
+     * @param path The path to record in the entry.
+     * @param options The threshold and block size that were applied.
+     * @param file_entropy The entropy of the whole file.
+     * @param blocks The (offset, entropy) pairs of blocks meeting the threshold.
+     * @param entry Receives the entry when one is produced.
+     *
+     * @return true if an entry was produced.
+     */
+    static bool make_entry(
+        const std::string& path,
+        const ScanOptions& options,
+        double file_entropy,
+        const std::vector<std::pair<size_t, double>>& blocks,
+        nlohmann::json& entry
+    );
+
+    /**
+     * @brief Returns whether the last analysis produced a report entry.
+     */
+    bool has_entry() const;
+
+    /**
+     * @brief Returns the report entry of the last analysis.
+     *
+     * Only meaningful when has_entry() is true.
+     */
+    const nlohmann::json& get_entry() const;
+
+    /**
+     * @brief Moves the report entry of the last analysis out of the analyzer.
+     *
+     * Only meaningful when has_entry() is true.
+     */
+    nlohmann::json take_entry();
+
+    /**
+     * @brief Returns the whole-file entropy of the last analysis.
+     *
+     * Set whether or not an entry was produced; 0.0 for empty files.
+     */
+    double get_file_entropy() const;
+
+    /**
+     * @brief Returns how many blocks of the last analysis went to the block sink.
+     *
+     * When non-zero, all blocks of the file went to the sink: get_entry()
+     * has an empty "blocks" array and is complete otherwise.
+     */
+    size_t get_sunk_block_count() const;
+
+    /**
+     * @brief Returns the size in bytes of the last analyzed file.
+     */
+    uint64_t get_file_size() const;
+
+    /**
+     * @brief Returns the error message of the last failed analyze() call.
+     */
+    const std::string& get_error_message() const;
+
+private:
+    bool read_small(const std::string& path, bool& is_small);
+    bool analyze_stream(const std::string& path, ByteSource& source, const ScanOptions& options,
+                        const ProgressCallback& on_progress);  // continues from progress_
+    int open_in_directory(const std::string& path);
+    bool directory_matches() const;  // dir_fd_ is still the directory at dir_path_
+
+    ScanContext ctx_;
+    mutable nlohmann::json entry_;
+    mutable bool entry_built_ = false;
+    std::string entry_path_;  // path and options the entry is built from
+    ScanOptions entry_options_;
+    bool has_entry_ = false;
+    double file_entropy_ = 0.0;
+    uint64_t file_size_ = 0;
+    std::string error_message_;
+    int dir_fd_ = -1;          // directory of the last small file
+    std::string dir_path_;
+    bool dir_verified_ = false;  // dir_fd_ checked since revalidate_directory()
+    BufferPool* pool_ = nullptr;
+    FileProgress progress_;  // histogram and blocks gathered across chunks
+    ProgressCallback on_progress_;
+    BlockSink block_sink_;
+    size_t sunk_blocks_ = 0;  // blocks of the last analysis given to block_sink_
+};
+
+#endif // FILE_ANALYZER_HPP
@@ -1,28 +1,133 @@
 #include "file_reader.hpp"
-#include <fstream>
-#include <iterator>
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+    // reads until @p length bytes are in or end of file; returns bytes read or -1
+    ssize_t pread_full(int fd, unsigned char* buffer, size_t length, uint64_t offset) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t n = ::pread(fd, buffer + done, length - done, static_cast<off_t>(offset + done));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            if (n == 0) break;
+            done += static_cast<size_t>(n);
+        }
+        return static_cast<ssize_t>(done);
+    }
+
+} // namespace
 
 FileReader::FileReader(const std::string& filepath)
     : filepath_(filepath), file_size_(0), valid_(false), error_message_("") {}
 
-bool FileReader::read_file() {
-    std::ifstream file(filepath_, std::ios::binary);
-    if (!file.is_open()) {
+FileReader::~FileReader() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool FileReader::open_file() {
+    if (fd_ >= 0) {
+        return true;
+    }
+    fd_ = ::open(filepath_.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd_ < 0 || ::fstat(fd_, &st) != 0 || S_ISDIR(st.st_mode)) {
+        // close a descriptor that did open, or the next call would take it as usable
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
         valid_ = false;
-        error_message_ = "Failed to open file: " + filepath_; 
+        error_message_ = "Failed to open file: " + filepath_;
+        return false;
+    }
+    file_size_ = static_cast<size_t>(st.st_size);
+    // every caller reads front to back; lets the kernel use a larger readahead window
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return true;
+}
+
+bool FileReader::read_file() {
+    if (!open_file()) {
         return valid_;
     }
 
-    data_ = std::vector<unsigned char>(
-        (std::istreambuf_iterator<char>(file)),
-        std::istreambuf_iterator<char>()
-    );
+    // st_size is a hint only: the file may grow, and pseudo-files report 0.
+    // Past it a small probe checks for more data, so a file of exactly
+    // st_size bytes never gets a larger buffer.
+    data_.resize(file_size_);
+    size_t filled = 0;
+    unsigned char probe[4096];
+    while (true) {
+        bool probing = filled == data_.size();
+        size_t want = probing ? sizeof(probe) : data_.size() - filled;
+        ssize_t n = pread_full(fd_, probing ? probe : data_.data() + filled, want, filled);
+        if (n < 0) {
+            valid_ = false;
+            error_message_ = "Failed to read file: " + filepath_;
+            return valid_;
+        }
+        if (probing && n > 0) {
+            data_.resize(std::max(data_.size() * 2, filled + static_cast<size_t>(n)));
+            std::copy(probe, probe + n, data_.data() + filled);
+        }
+        filled += static_cast<size_t>(n);
+        if (static_cast<size_t>(n) < want) break;  // end of file
+    }
+    data_.resize(filled);
+    file_size_ = data_.size();
 
     valid_ = true;
     error_message_.clear(); 
     return valid_; 
 }
 
+bool FileReader::read_range(uint64_t offset, size_t length) {
+    if (!open_file()) {
+        return valid_;
+    }
+
+    data_.resize(length);  // keeps capacity across calls
+    ssize_t n = pread_full(fd_, data_.data(), length, offset);
+    if (n < 0) {
+        data_.clear();
+        valid_ = false;
+        error_message_ = "Failed to read file: " + filepath_;
+        return valid_;
+    }
+    data_.resize(static_cast<size_t>(n));
+
+    valid_ = true;
+    error_message_.clear();
+    return valid_;
+}
+
+bool FileReader::read_into(uint64_t offset, unsigned char* buffer, size_t length, size_t& bytes_read) {
+    bytes_read = 0;
+    if (!open_file()) {
+        return valid_;
+    }
+    ssize_t n = pread_full(fd_, buffer, length, offset);
+    if (n < 0) {
+        valid_ = false;
+        error_message_ = "Failed to read file: " + filepath_;
+        return valid_;
+    }
+    bytes_read = static_cast<size_t>(n);
+
+    valid_ = true;
+    error_message_.clear();
+    return valid_;
+}
+
 const std::vector<uint8_t>& FileReader::get_data() const {
     return data_;
 }
@@ -18,16 +18,53 @@ public:
 
     explicit FileReader(const std::string& filepath);
 
+    /**
+     * @brief Closes the file if it is still open.
+     */
+    ~FileReader();
+
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
+
     /**
      * @brief Reads the file and loads its contents into memory.
      * 
      * This function reads the file specified in the constructor and stores its contents
      * in a vector of bytes. It also sets the file size and validity status.
+     * The kernel is told the file will be read sequentially, so cold reads
+     * use a larger readahead window.
      *
      * @return true if the file was read successfully, false otherwise.
      */
     bool read_file();
 
+    /**
+     * @brief Reads up to @p length bytes starting at @p offset into memory.
+     *
+     * Replaces the contents returned by get_data() with the bytes read, which
+     * may be fewer than @p length at end of file. The file stays open between
+     * calls, so reading a file piecewise does not reopen it for every range.
+     *
+     * @param offset The byte offset to start reading from.
+     * @param length The maximum number of bytes to read.
+     * @return true if the range was read (possibly short), false on error.
+     */
+    bool read_range(uint64_t offset, size_t length);
+
+    /**
+     * @brief Reads up to @p length bytes starting at @p offset into @p buffer.
+     *
+     * Like read_range(), but fills memory owned by the caller (for example a
+     * pooled buffer) and leaves get_data() untouched.
+     *
+     * @param offset The byte offset to start reading from.
+     * @param buffer Destination of at least @p length bytes.
+     * @param length The maximum number of bytes to read.
+     * @param bytes_read Receives the number of bytes read; short at end of file.
+     * @return true if the range was read (possibly short), false on error.
+     */
+    bool read_into(uint64_t offset, unsigned char* buffer, size_t length, size_t& bytes_read);
+
     /**
      * @brief Returns the contents of the file as a vector of bytes.
      *
@@ -43,7 +80,8 @@ public:
      * @brief Returns the size of the file in bytes.
      *
      * This method returns the size of the file that was read,
-     * as determined during the last successful call to read_file().
+     * as determined during the last successful call to read_file()
+     * or read_range().
      *
      * @note This function may return 0 or an invalid size if read_file()
      *       was not called or failed.
@@ -74,11 +112,14 @@ public:
     const std::string& get_error_message() const;
 
 private:
+    bool open_file();
+
     std::string filepath_;
     std::vector<uint8_t> data_;
     size_t file_size_;
     bool valid_;
     std::string error_message_;
+    int fd_ = -1;  // kept open across read_range() calls
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "file_watcher.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace {
+
+    constexpr uint32_t kWatchMask =
+        IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_DELETE | IN_MOVED_FROM;
+
+} // namespace
+
+FileWatcher::FileWatcher(const fs::path& root, bool recursive, std::chrono::milliseconds debounce)
+    : root_(root), recursive_(recursive), debounce_(debounce) {}
+
+FileWatcher::~FileWatcher() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool FileWatcher::start() {
+    fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ < 0) {
+        error_message_ = std::string("inotify_init1: ") + std::strerror(errno);
+        return false;
+    }
+
+    std::error_code ec;
+    if (fs::is_regular_file(root_, ec)) {
+        // inotify reports close-after-write on the parent directory with a name,
+        // which also survives editors that replace the file by rename
+        root_file_ = root_;
+        fs::path parent = root_.has_parent_path() ? root_.parent_path() : fs::path(".");
+        return add_watch(parent);
+    }
+    if (!fs::is_directory(root_, ec)) {
+        error_message_ = root_.string() + " is neither file nor directory";
+        return false;
+    }
+    if (!add_watch(root_)) {
+        return false;
+    }
+    if (recursive_) {
+        add_tree(root_, false);
+    }
+    return true;
+}
+
+bool FileWatcher::add_watch(const fs::path& dir) {
+    int wd = ::inotify_add_watch(fd_, dir.c_str(), kWatchMask);
+    if (wd < 0) {
+        error_message_ = "inotify_add_watch " + dir.string() + ": " + std::strerror(errno);
+        ++unwatched_;
+        return false;
+    }
+    watches_[wd] = dir;
+    return true;
+}
+
+void FileWatcher::add_tree(const fs::path& dir, bool report_existing) {
+    std::error_code ec;
+    for (auto it = fs::recursive_directory_iterator(dir,
+            fs::directory_options::skip_permission_denied, ec);
+         !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_directory(ec) && !it->is_symlink(ec)) {
+            add_watch(it->path());
+        } else if (report_existing && it->is_regular_file(ec)) {
+            mark_pending(it->path());
+        }
+    }
+}
+
+fs::path FileWatcher::reported_path(const fs::path& path) const {
+    if (root_file_.empty()) {
+        return path;
+    }
+    // single-file mode: report under the path the caller gave us
+    return path.filename() == root_file_.filename() ? root_file_ : fs::path();
+}
+
+void FileWatcher::mark_pending(const fs::path& path) {
+    fs::path reported = reported_path(path);
+    if (!reported.empty()) {
+        pending_[reported.string()] = clock::now() + debounce_;
+    }
+}
+
+void FileWatcher::mark_removed(const fs::path& path) {
+    fs::path reported = reported_path(path);
+    if (!reported.empty()) {
+        pending_.erase(reported.string());
+        removed_.push_back(std::move(reported));
+    }
+}
+
+void FileWatcher::read_events() {
+    alignas(struct inotify_event) char buffer[64 * 1024];
+    for (;;) {
+        ssize_t len = ::read(fd_, buffer, sizeof(buffer));
+        if (len <= 0) {
+            return;  // EAGAIN once drained
+        }
+        for (char* p = buffer; p < buffer + len;) {
+            const auto* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflowed_ = true;
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                watches_.erase(event->wd);
+                continue;
+            }
+            auto watch = watches_.find(event->wd);
+            if (watch == watches_.end() || event->len == 0) {
+                continue;
+            }
+            fs::path path = watch->second / event->name;
+
+            if (event->mask & IN_ISDIR) {
+                // new directories may already hold files written before the watch existed
+                if (recursive_ && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+                    if (add_watch(path)) {
+                        add_tree(path, true);
+                    }
+                } else if (root_file_.empty() && (event->mask & IN_MOVED_FROM)) {
+                    // a directory moved away takes its files without an event for each
+                    removed_.push_back(path);
+                }
+                continue;
+            }
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                mark_pending(path);
+            } else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                mark_removed(path);
+            }
+        }
+    }
+}
+
+std::vector<fs::path> FileWatcher::poll(int timeout_ms) {
+    std::vector<fs::path> ready;
+    if (fd_ < 0) {
+        return ready;
+    }
+
+    int wait_ms = timeout_ms;
+    if (!pending_.empty()) {
+        clock::time_point earliest = clock::time_point::max();
+        for (const auto& [path, deadline] : pending_) {
+            earliest = std::min(earliest, deadline);
+        }
+        auto until = std::chrono::ceil<std::chrono::milliseconds>(earliest - clock::now()).count();
+        wait_ms = static_cast<int>(std::clamp<long long>(until, 0, timeout_ms));
+    }
+
+    pollfd pfd{fd_, POLLIN, 0};
+    if (::poll(&pfd, 1, wait_ms) > 0 && (pfd.revents & POLLIN)) {
+        read_events();
+    }
+
+    clock::time_point now = clock::now();
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        if (it->second <= now) {
+            ready.emplace_back(it->first);
+            it = pending_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    std::sort(ready.begin(), ready.end());
+    return ready;
+}
+
+std::vector<fs::path> FileWatcher::take_removed() {
+    std::vector<fs::path> removed;
+    removed.swap(removed_);
+    return removed;
+}
+
+bool FileWatcher::take_overflow() {
+    bool overflowed = overflowed_;
+    overflowed_ = false;
+    return overflowed;
+}
+
+size_t FileWatcher::get_unwatched_count() const {
+    return unwatched_;
+}
+
+const std::string& FileWatcher::get_error_message() const {
+    return error_message_;
+}
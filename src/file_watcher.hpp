@@ -0,0 +1,118 @@
+#ifndef FILE_WATCHER_HPP
+#define FILE_WATCHER_HPP
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @class FileWatcher
+ * @brief Reports files that finished being written under a directory tree.
+ *
+ * Uses inotify to watch for files closed after writing or moved into the
+ * tree. Events for the same file are debounced: a file is reported once no
+ * further event for it has arrived for the debounce interval, so a burst of
+ * writes produces a single re-analysis. Directories created after start()
+ * are watched as they appear (in recursive mode), and any files already in
+ * them are reported. Files deleted or moved out of the tree are reported
+ * separately by take_removed().
+ *
+ * Work done is proportional to write activity, not to the size of the tree.
+ */
+class FileWatcher {
+public:
+
+    /**
+     * @brief Constructs a watcher; nothing is watched until start().
+     *
+     * @param root The file or directory to watch.
+     * @param recursive If true, watch subdirectories too.
+     * @param debounce How long a file must stay quiet before it is reported.
+     */
+    FileWatcher(const fs::path& root, bool recursive, std::chrono::milliseconds debounce);
+
+    /**
+     * @brief Closes the inotify instance.
+     */
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    /**
+     * @brief Creates the inotify instance and watches the tree.
+     *
+     * Subdirectories that cannot be watched (e.g. the per-user watch limit is
+     * reached) are skipped and counted in get_unwatched_count().
+     *
+     * @return true if at least the root is watched, false otherwise
+     *         (see get_error_message()).
+     */
+    bool start();
+
+    /**
+     * @brief Waits up to @p timeout_ms for events and returns files ready for analysis.
+     *
+     * Returns early when a debounced file becomes ready. May return an empty
+     * vector on timeout or when interrupted by a signal.
+     *
+     * @param timeout_ms Maximum time to wait, in milliseconds.
+     * @return Paths that were written and have been quiet for the debounce interval.
+     */
+    std::vector<fs::path> poll(int timeout_ms);
+
+    /**
+     * @brief Returns and clears the paths removed since the last call.
+     *
+     * Collected by poll() from delete and move-out events, in event order.
+     * A removed file's pending write is dropped. A directory moved out of
+     * the tree is reported as one path that stands for everything under it.
+     */
+    std::vector<fs::path> take_removed();
+
+    /**
+     * @brief Returns and clears whether the kernel event queue overflowed.
+     *
+     * After an overflow some writes may have been missed, so callers should
+     * rescan the tree.
+     */
+    bool take_overflow();
+
+    /**
+     * @brief Returns the number of directories that could not be watched.
+     */
+    size_t get_unwatched_count() const;
+
+    /**
+     * @brief Returns the error message of a failed start().
+     */
+    const std::string& get_error_message() const;
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    bool add_watch(const fs::path& dir);
+    void add_tree(const fs::path& dir, bool report_existing);
+    void read_events();
+    fs::path reported_path(const fs::path& path) const;
+    void mark_pending(const fs::path& path);
+    void mark_removed(const fs::path& path);
+
+    fs::path root_;
+    fs::path root_file_;  // set when root is a single file
+    bool recursive_;
+    std::chrono::milliseconds debounce_;
+    int fd_ = -1;
+    bool overflowed_ = false;
+    size_t unwatched_ = 0;
+    std::string error_message_;
+    std::unordered_map<int, fs::path> watches_;               // watch descriptor -> directory
+    std::unordered_map<std::string, clock::time_point> pending_;  // path -> ready time
+    std::vector<fs::path> removed_;
+};
+
+#endif // FILE_WATCHER_HPP
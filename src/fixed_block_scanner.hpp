@@ -0,0 +1,161 @@
+#ifndef FIXED_BLOCK_SCANNER_HPP
+#define FIXED_BLOCK_SCANNER_HPP
+
+#include "entropy_calculator.hpp"
+#include "scan_context.hpp"
+#include <array>
+#include <cmath>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace fixed_block_detail {
+
+    /**
+     * @brief Compile-time base-2 logarithm for positive arguments.
+     *
+     * Splits x into m * 2^e with m in [sqrt(1/2), sqrt(2)) and evaluates ln(m)
+     * through the atanh series, stopping once terms no longer affect the sum.
+     */
+    constexpr double constexpr_log2(double x) {
+        constexpr double ln2 = 0.693147180559945309417232121458;
+        constexpr double sqrt2 = 1.414213562373095048801688724210;
+        int exponent = 0;
+        while (x >= sqrt2) { x *= 0.5; ++exponent; }
+        while (x < sqrt2 * 0.5) { x *= 2.0; --exponent; }
+        double z = (x - 1.0) / (x + 1.0);
+        double z2 = z * z;
+        double term = z;
+        double sum = 0.0;
+        for (int k = 1; sum + term / k != sum; k += 2) {
+            sum += term / k;
+            term *= z2;
+        }
+        return exponent + 2.0 * sum / ln2;
+    }
+
+    /**
+     * @brief Builds a table of c * log2(c) for every count c in [0, N].
+     */
+    template <size_t N>
+    constexpr std::array<double, N + 1> make_count_log_table() {
+        std::array<double, N + 1> table{};
+        table[0] = 0.0;
+        for (size_t c = 1; c <= N; ++c) {
+            table[c] = static_cast<double>(c) * constexpr_log2(static_cast<double>(c));
+        }
+        return table;
+    }
+
+} // namespace fixed_block_detail
+
+/**
+ * @class FixedBlockEntropyScanner
+ * @brief Block entropy scanner specialized at compile time for one block size.
+ *
+ * With the block size known to the compiler, the histogram loop is unrolled
+ * into interleaved lanes, each lane uses the narrowest counter that cannot
+ * overflow, and normalization is folded into a constexpr table of c*log2(c):
+ *
+ *     H = log2(N) - (1/N) * sum(c * log2(c))
+ *
+ * The table covers counts up to kTableCounts; larger counts (only possible
+ * in blocks bigger than that, and rare outside low-entropy data) are computed
+ * with std::log2. A trailing partial block falls back to the generic path.
+ *
+ * @tparam BlockSize The block size in bytes; must be a multiple of the lane count.
+ */
+template <size_t BlockSize>
+class FixedBlockEntropyScanner {
+public:
+    static constexpr size_t kLanes = 4;
+    static constexpr size_t kTableCounts = BlockSize < 4096 ? BlockSize : 4096;
+
+    static_assert(BlockSize > 0 && BlockSize % kLanes == 0,
+                  "BlockSize must be a positive multiple of the lane count");
+
+    /// Narrowest counter able to hold BlockSize / kLanes occurrences of one byte.
+    using counter_type = std::conditional_t<
+        (BlockSize / kLanes <= UINT16_MAX), uint16_t, uint32_t>;
+
+    /**
+     * @brief Computes the Shannon entropy of exactly BlockSize bytes.
+     *
+     * @param block Pointer to BlockSize readable bytes.
+     * @return The entropy in bits per byte.
+     */
+    static double block_entropy(const unsigned char* block) {
+        std::array<std::array<counter_type, 256>, kLanes> lanes{};
+        for (size_t i = 0; i < BlockSize; i += kLanes) {
+            lanes[0][block[i]]++;
+            lanes[1][block[i + 1]]++;
+            lanes[2][block[i + 2]]++;
+            lanes[3][block[i + 3]]++;
+        }
+
+        double sum = 0.0;
+        for (size_t b = 0; b < 256; ++b) {
+            size_t count = static_cast<size_t>(lanes[0][b]) + lanes[1][b]
+                         + lanes[2][b] + lanes[3][b];
+            if (count <= kTableCounts) {
+                sum += kCountLog[count];
+            } else {
+                sum += static_cast<double>(count) * std::log2(static_cast<double>(count));
+            }
+        }
+        return kLogBlockSize - sum * kInvBlockSize;
+    }
+
+    /**
+     * @brief Scans a byte range in BlockSize blocks without validating arguments.
+     *
+     * Callers are expected to have validated the range and threshold, as
+     * BlockEntropyScanner::scan() does before dispatching here.
+     *
+     * @param data Pointer to the bytes to scan.
+     * @param size Number of bytes to scan.
+     * @param min_entropy The minimum entropy for a block to be included in the result.
+     * @param ctx The scan context providing result storage.
+     *
+     * @return A reference to ctx.results(), valid until the next scan through @p ctx.
+     */
+    static const std::vector<std::pair<size_t, double>>& scan_blocks(
+        const unsigned char* data,
+        size_t size,
+        double min_entropy,
+        ScanContext& ctx
+    ) {
+        ctx.reset_results();
+        std::vector<std::pair<size_t, double>>& results = ctx.results();
+
+        size_t full_end = size - size % BlockSize;
+        for (size_t offset = 0; offset < full_end; offset += BlockSize) {
+            double entropy = block_entropy(data + offset);
+            if (entropy >= min_entropy) {
+                results.emplace_back(offset, entropy);
+            }
+        }
+
+        if (full_end < size) {
+            size_t len = size - full_end;
+            ctx.clear_histogram();
+            EntropyCalculator::accumulate_histogram(data + full_end, len, ctx.histogram());
+            double entropy = EntropyCalculator::entropy_from_histogram(ctx.histogram(), len);
+            if (entropy >= min_entropy) {
+                results.emplace_back(full_end, entropy);
+            }
+        }
+        return results;
+    }
+
+private:
+    static constexpr std::array<double, kTableCounts + 1> kCountLog =
+        fixed_block_detail::make_count_log_table<kTableCounts>();
+    static constexpr double kLogBlockSize =
+        fixed_block_detail::constexpr_log2(static_cast<double>(BlockSize));
+    static constexpr double kInvBlockSize = 1.0 / static_cast<double>(BlockSize);
+};
+
+#endif // FIXED_BLOCK_SCANNER_HPP
@@ -0,0 +1,170 @@
+#include "io_scheduler.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <fstream>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+IoScheduler::IoScheduler(const IoSchedulerOptions& options)
+    : options_(options) {
+    options_.jobs = std::max<size_t>(options_.jobs, 1);
+    options_.rotational_depth = std::max<size_t>(options_.rotational_depth, 1);
+    if (options_.solid_state_depth == 0) {
+        options_.solid_state_depth = options_.jobs;
+    }
+}
+
+std::vector<ScheduledFile> IoScheduler::plan(const std::vector<fs::path>& files) const {
+    std::vector<ScheduledFile> order;
+    order.reserve(files.size());
+    for (size_t i = 0; i < files.size(); ++i) {
+        ScheduledFile file{i, kUnknownDevice, 0};
+        struct stat st;
+        if (::stat(files[i].c_str(), &st) == 0) {
+            file.device = st.st_dev;
+            file.location = st.st_ino;
+            if (options_.order == IoOrder::Extent) {
+                std::optional<uint64_t> extent = first_extent(files[i]);
+                file.mapped = extent.has_value();
+                file.location = extent.value_or(st.st_ino);
+            }
+        }
+        order.push_back(file);
+    }
+    if (options_.order != IoOrder::Directory) {
+        std::stable_sort(order.begin(), order.end(), [](const ScheduledFile& a, const ScheduledFile& b) {
+            if (a.device != b.device) return a.device < b.device;
+            if (a.mapped != b.mapped) return a.mapped;
+            return a.location < b.location;
+        });
+    } else {
+        // keep directory order within a device; unreadable files still go last
+        std::stable_partition(order.begin(), order.end(), [](const ScheduledFile& f) {
+            return f.device != kUnknownDevice;
+        });
+    }
+    return order;
+}
+
+void IoScheduler::run(const std::vector<fs::path>& files, const Work& work) {
+    std::vector<ScheduledFile> order = plan(files);
+
+    if (options_.jobs == 1) {
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (i + 1 < order.size()) {
+                maybe_prefetch(files[order[i + 1].index], order[i + 1].device);
+            }
+            work(0, order[i].index);
+        }
+        return;
+    }
+
+    // the queue bounds how far ahead of the workers prefetch hints run
+    ThreadPool pool(options_.jobs, options_.jobs * 2);
+    for (const ScheduledFile& file : order) {
+        maybe_prefetch(files[file.index], file.device);
+        pool.submit([this, &work, file](size_t worker) {
+            acquire(file.device);
+            work(worker, file.index);
+            release(file.device);
+        });
+    }
+    pool.wait_idle();
+}
+
+size_t IoScheduler::get_device_depth(uint64_t device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slots_for(device).depth;
+}
+
+size_t IoScheduler::get_jobs() const {
+    return options_.jobs;
+}
+
+IoScheduler::DeviceSlots& IoScheduler::slots_for(uint64_t device) {
+    auto it = devices_.find(device);
+    if (it == devices_.end()) {
+        DeviceSlots slots;
+        slots.rotational = device != kUnknownDevice && is_rotational(device).value_or(false);
+        slots.depth = slots.rotational ? options_.rotational_depth : options_.solid_state_depth;
+        it = devices_.emplace(device, slots).first;
+    }
+    return it->second;
+}
+
+void IoScheduler::acquire(uint64_t device) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    DeviceSlots& slots = slots_for(device);
+    slot_free_.wait(lock, [&slots] { return slots.in_use < slots.depth; });
+    ++slots.in_use;
+}
+
+void IoScheduler::release(uint64_t device) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --devices_[device].in_use;
+    }
+    slot_free_.notify_all();
+}
+
+void IoScheduler::maybe_prefetch(const fs::path& path, uint64_t device) {
+    if (options_.prefetch_bytes == 0 || device == kUnknownDevice) {
+        return;
+    }
+    bool rotational;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rotational = slots_for(device).rotational;
+    }
+    if (rotational) {
+        prefetch(path, options_.prefetch_bytes);
+    }
+}
+
+std::optional<bool> IoScheduler::is_rotational(uint64_t device) {
+    std::string base = "/sys/dev/block/" + std::to_string(major(device)) + ":"
+        + std::to_string(minor(device));
+    // a partition has no queue of its own; its parent disk does
+    for (const char* suffix : {"/queue/rotational", "/../queue/rotational"}) {
+        std::ifstream in(base + suffix);
+        int flag;
+        if (in >> flag) {
+            return flag != 0;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<uint64_t> IoScheduler::first_extent(const fs::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    // struct fiemap ends in a flexible array; room for exactly one extent
+    alignas(struct fiemap) unsigned char buffer[sizeof(struct fiemap) + sizeof(struct fiemap_extent)] = {};
+    auto* map = reinterpret_cast<struct fiemap*>(buffer);
+    map->fm_start = 0;
+    map->fm_length = FIEMAP_MAX_OFFSET;
+    map->fm_extent_count = 1;
+    bool ok = ::ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0;
+    ::close(fd);
+    if (!ok) {
+        return std::nullopt;
+    }
+    return map->fm_extents[0].fe_physical;
+}
+
+void IoScheduler::prefetch(const fs::path& path, uint64_t length) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    ::posix_fadvise(fd, 0, static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+    ::close(fd);
+}
@@ -0,0 +1,152 @@
+#ifndef IO_SCHEDULER_HPP
+#define IO_SCHEDULER_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Order in which IoScheduler visits files on the same device.
+ */
+enum class IoOrder {
+    Directory,  // as given (directory-iterator order)
+    Inode,      // by inode number, a cheap proxy for on-disk placement
+    Extent      // by physical offset of the first extent (FIEMAP), inode as fallback
+};
+
+/**
+ * @struct IoSchedulerOptions
+ * @brief Concurrency and ordering settings for an IoScheduler.
+ */
+struct IoSchedulerOptions {
+    size_t jobs = 1;                    // worker threads
+    IoOrder order = IoOrder::Inode;
+    size_t rotational_depth = 2;        // concurrent reads per spinning disk
+    size_t solid_state_depth = 0;       // concurrent reads per other device; 0 means jobs
+    uint64_t prefetch_bytes = 4 << 20;  // readahead hint for queued files on spinning disks; 0 disables
+};
+
+/**
+ * @struct ScheduledFile
+ * @brief One file of a schedule: its input position and sort key.
+ */
+struct ScheduledFile {
+    size_t index;       // position in the input list
+    uint64_t device;    // st_dev, or kUnknownDevice if stat failed
+    uint64_t location;  // physical offset or inode, depending on the order
+    bool mapped = true; // false if the extent order fell back to the inode
+};
+
+/**
+ * @class IoScheduler
+ * @brief Orders a file list for locality and runs it with per-device concurrency limits.
+ *
+ * Files are grouped by device and sorted within each device, so a cold scan
+ * of a spinning disk sweeps across it instead of seeking back and forth in
+ * directory order. Each device gets a read depth from its class in sysfs:
+ * rotational devices allow only a few concurrent reads, others (NVMe, SSD,
+ * network and virtual filesystems) allow one per worker. Files queued for a
+ * spinning disk are announced to the kernel with POSIX_FADV_WILLNEED so their
+ * first bytes are read ahead while earlier files are analyzed.
+ *
+ * The work callback receives the input index, so results can still be
+ * reported in the original order.
+ */
+class IoScheduler {
+public:
+    static constexpr uint64_t kUnknownDevice = UINT64_MAX;
+
+    using Work = std::function<void(size_t worker, size_t index)>;
+
+    /**
+     * @brief Constructs a scheduler with the given options.
+     */
+    explicit IoScheduler(const IoSchedulerOptions& options);
+
+    IoScheduler(const IoScheduler&) = delete;
+    IoScheduler& operator=(const IoScheduler&) = delete;
+
+    /**
+     * @brief Returns the visiting order for @p files.
+     *
+     * Files are grouped by device; files that cannot be stat'ed come last
+     * so their errors are still reported by the work callback. In extent
+     * order, files without an extent follow the others of their device in
+     * inode order, since inodes and physical offsets are not comparable.
+     */
+    std::vector<ScheduledFile> plan(const std::vector<fs::path>& files) const;
+
+    /**
+     * @brief Calls @p work once for every file, in plan() order.
+     *
+     * With more than one job the calls run on a thread pool; at most the
+     * device depth of calls touch the same device at once. Returns once all
+     * calls have finished.
+     *
+     * @param files The files to process.
+     * @param work Called with the worker index (below the job count) and the
+     *             index of the file in @p files.
+     */
+    void run(const std::vector<fs::path>& files, const Work& work);
+
+    /**
+     * @brief Returns the number of concurrent reads allowed on @p device.
+     */
+    size_t get_device_depth(uint64_t device);
+
+    /**
+     * @brief Returns the number of worker threads.
+     */
+    size_t get_jobs() const;
+
+    /**
+     * @brief Reports whether the block device @p device is rotational.
+     *
+     * Reads queue/rotational from sysfs, going through the parent disk for
+     * partitions.
+     *
+     * @return The flag, or std::nullopt for devices without a block queue
+     *         (tmpfs, NFS, overlay, ...).
+     */
+    static std::optional<bool> is_rotational(uint64_t device);
+
+    /**
+     * @brief Looks up the physical byte offset of the first extent of @p path.
+     *
+     * @return The offset, or std::nullopt if the filesystem does not support
+     *         FIEMAP or the file has no allocated extents.
+     */
+    static std::optional<uint64_t> first_extent(const fs::path& path);
+
+    /**
+     * @brief Asks the kernel to start reading the first @p length bytes of @p path.
+     */
+    static void prefetch(const fs::path& path, uint64_t length);
+
+private:
+    struct DeviceSlots {
+        size_t depth = 1;
+        size_t in_use = 0;
+        bool rotational = false;
+    };
+
+    DeviceSlots& slots_for(uint64_t device);  // mutex_ must be held
+    void acquire(uint64_t device);
+    void release(uint64_t device);
+    void maybe_prefetch(const fs::path& path, uint64_t device);
+
+    IoSchedulerOptions options_;
+    std::map<uint64_t, DeviceSlots> devices_;
+    std::mutex mutex_;
+    std::condition_variable slot_free_;
+};
+
+#endif // IO_SCHEDULER_HPP
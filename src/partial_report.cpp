@@ -0,0 +1,246 @@
+#include "partial_report.hpp"
+#include "block_entropy_scanner.hpp"
+#include "entropy_calculator.hpp"
+#include "file_reader.hpp"
+#include <algorithm>
+
+using json = nlohmann::json;
+
+namespace {
+
+    // bytes requested per read; rounded down to a whole number of blocks
+    constexpr size_t kReadChunk = 1 << 20;
+
+} // namespace
+
+bool PartialScanner::scan(
+    const std::string& path,
+    const std::vector<ShardRange>& ranges,
+    const ScanOptions& options,
+    json& out
+) {
+    out = json::array();
+    FileReader reader(path);
+    const size_t block_size = options.block_size;
+    const size_t chunk = block_size > 0
+        ? std::max(block_size, kReadChunk / block_size * block_size)
+        : kReadChunk;
+
+    for (const ShardRange& range : ranges) {
+        std::array<size_t, 256> histogram{};
+        json blocks = json::array();
+        uint64_t offset = range.offset;
+        const uint64_t end = range.offset + range.length;
+
+        while (offset < end) {
+            size_t want = static_cast<size_t>(std::min<uint64_t>(chunk, end - offset));
+            if (!reader.read_range(offset, want)) {
+                error_message_ = reader.get_error_message();
+                return false;
+            }
+            const std::vector<uint8_t>& data = reader.get_data();
+            if (data.size() != want) {
+                error_message_ = "File changed during scan: " + path;
+                return false;
+            }
+            EntropyCalculator::accumulate_histogram(data.data(), data.size(), histogram);
+            if (block_size > 0) {
+                for (const auto& [block, entropy] : BlockEntropyScanner::scan(
+                        data.data(), data.size(), block_size, options.entropy_threshold, ctx_)) {
+                    blocks.push_back({offset + block, entropy});
+                }
+            }
+            offset += data.size();
+        }
+
+        json jrange;
+        jrange["offset"] = range.offset;
+        jrange["length"] = range.length;
+        jrange["histogram"] = histogram;
+        if (block_size > 0) {
+            jrange["blocks"] = std::move(blocks);
+        }
+        out.push_back(std::move(jrange));
+    }
+    error_message_.clear();
+    return true;
+}
+
+const std::string& PartialScanner::get_error_message() const {
+    return error_message_;
+}
+
+PartialReport::PartialReport(const ShardSpec& spec, const ScanOptions& options, uint64_t split_bytes) {
+    report_["type"] = "partial";
+    report_["version"] = kVersion;
+    report_["shard"] = spec.index;
+    report_["shards"] = spec.count;
+    report_["threshold"] = options.entropy_threshold;
+    report_["block_size"] = options.block_size;
+    report_["split_bytes"] = split_bytes;
+    report_["files"] = json::array();
+    report_["errors"] = json::array();
+}
+
+void PartialReport::add_file(const std::string& key, const std::string& path, uint64_t index,
+                             uint64_t size, json ranges) {
+    json file;
+    file["key"] = key;
+    file["path"] = path;
+    file["index"] = index;
+    file["size"] = size;
+    file["ranges"] = std::move(ranges);
+    report_["files"].push_back(std::move(file));
+}
+
+void PartialReport::add_error(const std::string& key, const std::string& path, uint64_t index,
+                              const std::string& message) {
+    report_["errors"].push_back({{"key", key}, {"path", path}, {"index", index}, {"message", message}});
+}
+
+const json& PartialReport::to_json() const {
+    return report_;
+}
+
+bool PartialReportMerger::add(const json& partial) {
+    try {
+        if (partial.at("type") != "partial" || partial.at("version") != PartialReport::kVersion) {
+            error_message_ = "Not a partial report";
+            return false;
+        }
+        size_t shard = partial.at("shard").get<size_t>();
+        size_t shards = partial.at("shards").get<size_t>();
+        ScanOptions options;
+        options.entropy_threshold = partial.at("threshold").get<double>();
+        options.block_size = partial.at("block_size").get<size_t>();
+        uint64_t split_bytes = partial.at("split_bytes").get<uint64_t>();
+
+        if (!started_) {
+            started_ = true;
+            shard_count_ = shards;
+            seen_shards_.assign(shards, false);
+            options_ = options;
+            split_bytes_ = split_bytes;
+        } else if (shards != shard_count_ || split_bytes != split_bytes_
+                   || options.entropy_threshold != options_.entropy_threshold
+                   || options.block_size != options_.block_size) {
+            error_message_ = "Partial report " + std::to_string(shard)
+                + " was produced with different shard count or scan options";
+            return false;
+        }
+        if (shard >= shard_count_ || seen_shards_[shard]) {
+            error_message_ = "Duplicate or out-of-range shard " + std::to_string(shard);
+            return false;
+        }
+        seen_shards_[shard] = true;
+
+        for (const json& error : partial.at("errors")) {
+            failed_.insert(error.at("key").get<std::string>());
+            file_errors_.push_back(error.at("message").get<std::string>());
+        }
+        for (const json& file : partial.at("files")) {
+            if (!add_file(file)) {
+                return false;
+            }
+        }
+    } catch (const json::exception& e) {
+        error_message_ = std::string("Malformed partial report: ") + e.what();
+        return false;
+    }
+    return true;
+}
+
+bool PartialReportMerger::add_file(const json& file) {
+    std::string key = file.at("key").get<std::string>();
+    std::string path = file.at("path").get<std::string>();
+    uint64_t index = file.at("index").get<uint64_t>();
+    uint64_t size = file.at("size").get<uint64_t>();
+
+    for (const json& range : file.at("ranges")) {
+        uint64_t offset = range.at("offset").get<uint64_t>();
+        uint64_t length = range.at("length").get<uint64_t>();
+        std::array<size_t, 256> histogram = range.at("histogram").get<std::array<size_t, 256>>();
+        std::vector<std::pair<size_t, double>> blocks;
+        if (options_.block_size > 0) {
+            for (const json& block : range.at("blocks")) {
+                blocks.emplace_back(block.at(0).get<size_t>(), block.at(1).get<double>());
+            }
+        }
+
+        if (offset == 0 && length == size) {
+            finalize(path, index, size, histogram, blocks);
+            continue;
+        }
+        SplitFile& split = split_files_[key];
+        if (split.covered > 0 && split.size != size) {
+            error_message_ = "File size differs between shards: " + path;
+            return false;
+        }
+        split.path = path;
+        split.index = index;
+        split.size = size;
+        split.covered += length;
+        for (size_t b = 0; b < 256; ++b) {
+            split.histogram[b] += histogram[b];
+        }
+        split.blocks.insert(split.blocks.end(), blocks.begin(), blocks.end());
+    }
+    return true;
+}
+
+void PartialReportMerger::finalize(
+    const std::string& path,
+    uint64_t index,
+    uint64_t size,
+    const std::array<size_t, 256>& histogram,
+    std::vector<std::pair<size_t, double>>& blocks
+) {
+    std::sort(blocks.begin(), blocks.end());
+    double file_entropy = EntropyCalculator::entropy_from_histogram(histogram, size);
+    json entry;
+    if (FileAnalyzer::make_entry(path, options_, file_entropy, blocks, entry)) {
+        entries_.emplace_back(index, std::move(entry));
+    }
+}
+
+bool PartialReportMerger::finish(json& report) {
+    if (!started_) {
+        error_message_ = "No partial reports given";
+        return false;
+    }
+    for (size_t shard = 0; shard < shard_count_; ++shard) {
+        if (!seen_shards_[shard]) {
+            error_message_ = "Missing partial report for shard " + std::to_string(shard)
+                + " of " + std::to_string(shard_count_);
+            return false;
+        }
+    }
+    for (auto& [key, split] : split_files_) {
+        if (failed_.count(key)) {
+            continue;  // a shard reported the error; skipped like a single-node read failure
+        }
+        if (split.covered != split.size) {
+            error_message_ = "Incomplete ranges for " + split.path;
+            return false;
+        }
+        finalize(split.path, split.index, split.size, split.histogram, split.blocks);
+    }
+
+    std::sort(entries_.begin(), entries_.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    report = json::array();
+    for (auto& [index, entry] : entries_) {
+        report.push_back(std::move(entry));
+    }
+    entries_.clear();
+    return true;
+}
+
+const std::vector<std::string>& PartialReportMerger::get_file_errors() const {
+    return file_errors_;
+}
+
+const std::string& PartialReportMerger::get_error_message() const {
+    return error_message_;
+}
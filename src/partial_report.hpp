@@ -0,0 +1,165 @@
+#ifndef PARTIAL_REPORT_HPP
+#define PARTIAL_REPORT_HPP
+
+#include "file_analyzer.hpp"
+#include "scan_context.hpp"
+#include "shard_planner.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * @class PartialScanner
+ * @brief Scans byte ranges of a file into mergeable per-range results.
+ *
+ * Each range yields its byte histogram and, in block mode, the blocks that
+ * meet the threshold with file-absolute offsets. Ranges start on block
+ * boundaries, so the blocks are exactly those a whole-file scan would give.
+ * Ranges are read in bounded chunks, never whole.
+ */
+class PartialScanner {
+public:
+    /**
+     * @brief Scans @p ranges of the file at @p path.
+     *
+     * @param path The file to read.
+     * @param ranges The ranges to scan, as assigned by ShardPlanner.
+     * @param options The threshold and block size to apply.
+     * @param out Receives one JSON object per range.
+     *
+     * @return true on success, false on a read error (see get_error_message()).
+     */
+    bool scan(
+        const std::string& path,
+        const std::vector<ShardRange>& ranges,
+        const ScanOptions& options,
+        nlohmann::json& out
+    );
+
+    /**
+     * @brief Returns the error message of the last failed scan() call.
+     */
+    const std::string& get_error_message() const;
+
+private:
+    ScanContext ctx_;
+    std::string error_message_;
+};
+
+/**
+ * @class PartialReport
+ * @brief Builds the report written by one shard.
+ *
+ * A partial report records the shard, the scan options and the split size
+ * next to the per-range results, so PartialReportMerger can check that the
+ * parts it combines belong to the same scan.
+ */
+class PartialReport {
+public:
+    static constexpr int kVersion = 1;
+
+    /**
+     * @brief Starts an empty partial report for @p spec.
+     */
+    PartialReport(const ShardSpec& spec, const ScanOptions& options, uint64_t split_bytes);
+
+    /**
+     * @brief Adds the scanned ranges of one file.
+     *
+     * @param key The path relative to the scan root, shared by all shards.
+     * @param path The path as scanned, used in the merged report.
+     * @param index The position of the file in the scan's file list.
+     * @param size The file size in bytes.
+     * @param ranges The range objects produced by PartialScanner::scan().
+     */
+    void add_file(const std::string& key, const std::string& path, uint64_t index,
+                  uint64_t size, nlohmann::json ranges);
+
+    /**
+     * @brief Records a file this shard could not read.
+     */
+    void add_error(const std::string& key, const std::string& path, uint64_t index,
+                   const std::string& message);
+
+    /**
+     * @brief Returns the report as JSON.
+     */
+    const nlohmann::json& to_json() const;
+
+private:
+    nlohmann::json report_;
+};
+
+/**
+ * @class PartialReportMerger
+ * @brief Combines the partial reports of all shards into a single-node report.
+ *
+ * Whole files are finalized as soon as their part is added; split files keep
+ * a summed histogram and their blocks until every range has arrived. The
+ * file entropy is computed from the summed histogram, so the merged report
+ * is identical to the one a single process would have written. Entries are
+ * ordered by the file index each shard recorded, which agrees across shards
+ * because utils::collect_files() returns files sorted by path.
+ */
+class PartialReportMerger {
+public:
+    /**
+     * @brief Adds one partial report.
+     *
+     * @return false if it is malformed, belongs to a different scan or repeats
+     *         a shard already added (see get_error_message()).
+     */
+    bool add(const nlohmann::json& partial);
+
+    /**
+     * @brief Produces the merged report array.
+     *
+     * @return false if shards are missing or a split file was not fully covered.
+     */
+    bool finish(nlohmann::json& report);
+
+    /**
+     * @brief Returns the per-file errors recorded by the shards.
+     */
+    const std::vector<std::string>& get_file_errors() const;
+
+    /**
+     * @brief Returns the error message of the last failed call.
+     */
+    const std::string& get_error_message() const;
+
+private:
+    struct SplitFile {
+        std::string path;
+        uint64_t index = 0;
+        uint64_t size = 0;
+        uint64_t covered = 0;
+        std::array<size_t, 256> histogram{};
+        std::vector<std::pair<size_t, double>> blocks;
+    };
+
+    bool add_file(const nlohmann::json& file);
+    void finalize(const std::string& path, uint64_t index, uint64_t size,
+                  const std::array<size_t, 256>& histogram,
+                  std::vector<std::pair<size_t, double>>& blocks);
+
+    bool started_ = false;
+    size_t shard_count_ = 0;
+    std::vector<bool> seen_shards_;
+    ScanOptions options_;
+    uint64_t split_bytes_ = 0;
+
+    std::map<std::string, SplitFile> split_files_;   // by key
+    std::set<std::string> failed_;                   // keys some shard could not read
+    std::vector<std::pair<uint64_t, nlohmann::json>> entries_;  // (index, entry)
+    std::vector<std::string> file_errors_;
+    std::string error_message_;
+};
+
+#endif // PARTIAL_REPORT_HPP
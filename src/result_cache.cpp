@@ -0,0 +1,61 @@
+#include "result_cache.hpp"
+#include <cstring>
+
+ResultCache::ResultCache(size_t capacity)
+    : capacity_(capacity) {}
+
+std::string ResultCache::make_key(
+    const std::string& path,
+    uintmax_t size,
+    int64_t mtime_ns,
+    const ScanOptions& options
+) {
+    // '\0' cannot appear in a path, so it separates fields unambiguously
+    std::string key = path;
+    key += '\0';
+    key += std::to_string(size);
+    key += '\0';
+    key += std::to_string(mtime_ns);
+    key += '\0';
+    key += std::to_string(options.block_size);
+    key += '\0';
+    // compare thresholds by bit pattern; to_string would round them
+    uint64_t threshold_bits;
+    std::memcpy(&threshold_bits, &options.entropy_threshold, sizeof(threshold_bits));
+    key += std::to_string(threshold_bits);
+    return key;
+}
+
+std::optional<CachedResult> ResultCache::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        return std::nullopt;
+    }
+    items_.splice(items_.begin(), items_, it->second);
+    return it->second->second;
+}
+
+void ResultCache::put(const std::string& key, CachedResult result) {
+    if (capacity_ == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        it->second->second = std::move(result);
+        items_.splice(items_.begin(), items_, it->second);
+        return;
+    }
+    if (items_.size() >= capacity_) {
+        index_.erase(items_.back().first);
+        items_.pop_back();
+    }
+    items_.emplace_front(key, std::move(result));
+    index_.emplace(key, items_.begin());
+}
+
+size_t ResultCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return items_.size();
+}
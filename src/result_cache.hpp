@@ -0,0 +1,83 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include "file_analyzer.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+/**
+ * @struct CachedResult
+ * @brief Outcome of analyzing one file version with one set of options.
+ */
+struct CachedResult {
+    bool has_entry = false;   // false if nothing met the threshold
+    nlohmann::json entry;     // the report entry when has_entry is true
+};
+
+/**
+ * @class ResultCache
+ * @brief Thread-safe LRU cache of analysis results keyed by file version.
+ *
+ * A key combines the path, file size and modification time with the scan
+ * options, so a file that changes on disk simply misses the cache and its
+ * stale entry ages out.
+ */
+class ResultCache {
+public:
+
+    /**
+     * @brief Constructs a cache holding at most @p capacity results.
+     *
+     * @param capacity Maximum number of entries; 0 disables caching.
+     */
+    explicit ResultCache(size_t capacity);
+
+    /**
+     * @brief Builds the cache key for a file version and scan options.
+     *
+     * @param path The file path.
+     * @param size The file size in bytes.
+     * @param mtime_ns The modification time in nanoseconds since the epoch.
+     * @param options The scan options applied.
+     */
+    static std::string make_key(
+        const std::string& path,
+        uintmax_t size,
+        int64_t mtime_ns,
+        const ScanOptions& options
+    );
+
+    /**
+     * @brief Looks up @p key, marking it most recently used on a hit.
+     *
+     * @return The cached result, or std::nullopt on a miss.
+     */
+    std::optional<CachedResult> get(const std::string& key);
+
+    /**
+     * @brief Inserts or replaces the result for @p key, evicting the least
+     *        recently used entry when full.
+     */
+    void put(const std::string& key, CachedResult result);
+
+    /**
+     * @brief Returns the number of cached results.
+     */
+    size_t size() const;
+
+private:
+    using Item = std::pair<std::string, CachedResult>;
+
+    size_t capacity_;
+    std::list<Item> items_;  // front is most recently used
+    std::unordered_map<std::string, std::list<Item>::iterator> index_;
+    mutable std::mutex mutex_;
+};
+
+#endif // RESULT_CACHE_HPP
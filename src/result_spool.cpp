@@ -0,0 +1,314 @@
+#include "result_spool.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+    // bookkeeping per buffered entry on top of its text
+    constexpr size_t kEntryOverhead = sizeof(uint64_t) * 2 + sizeof(std::string);
+
+    template <typename Entry>
+    bool entry_before(const Entry& a, const Entry& b) {
+        return a.index != b.index ? a.index < b.index : a.sequence < b.sequence;
+    }
+
+    // formats an entry exactly as it appears inside an array dumped with indent 2
+    std::string format_entry(const nlohmann::json& entry) {
+        std::string text = entry.dump(2);
+        std::string indented;
+        indented.reserve(text.size() + text.size() / 8 + 2);
+        indented += "  ";
+        for (char c : text) {
+            indented += c;
+            if (c == '\n') indented += "  ";  // JSON strings escape their newlines
+        }
+        return indented;
+    }
+
+    // formats blocks as elements of the "blocks" array of a format_entry() text
+    void append_blocks(const std::vector<std::pair<size_t, double>>& blocks, bool separate, std::string& out) {
+        for (const auto& [offset, entropy] : blocks) {
+            nlohmann::json block;
+            block["offset"] = offset;
+            block["entropy"] = entropy;
+            std::string text = block.dump(2);
+            out += separate ? ",\n      " : "      ";
+            for (char c : text) {
+                out += c;
+                if (c == '\n') out += "      ";
+            }
+            separate = true;
+        }
+    }
+
+    // sequential reader over one run of the spill file
+    class RunReader {
+    public:
+        RunReader(int fd, uint64_t offset, uint64_t bytes)
+            : fd_(fd), pos_(offset), end_(offset + bytes) {}
+
+        bool next(uint64_t& index, uint64_t& sequence, bool& continues, std::string& text, bool& ok) {
+            ok = true;
+            if (pos_ >= end_) return false;
+            uint64_t header[4];
+            if (!read_exact(header, sizeof(header))) { ok = false; return false; }
+            index = header[0];
+            sequence = header[1];
+            continues = header[2] != 0;
+            text.resize(header[3]);
+            if (!read_exact(text.data(), text.size())) { ok = false; return false; }
+            return true;
+        }
+
+    private:
+        bool read_exact(void* dest, size_t length) {
+            char* out = static_cast<char*>(dest);
+            while (length > 0) {
+                ssize_t n = ::pread(fd_, out, length, static_cast<off_t>(pos_));
+                if (n <= 0) return false;
+                out += n;
+                pos_ += static_cast<uint64_t>(n);
+                length -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        int fd_;
+        uint64_t pos_;
+        uint64_t end_;
+    };
+
+} // namespace
+
+ResultSpool::ResultSpool(BufferPool* pool, size_t memory_limit)
+    : pool_(pool), memory_limit_(memory_limit) {}
+
+ResultSpool::~ResultSpool() {
+    if (pool_ && memory_used_ > 0) {
+        pool_->release(memory_used_);
+    }
+    if (file_) {
+        std::fclose(file_);
+    }
+}
+
+bool ResultSpool::add(uint64_t index, const nlohmann::json& entry) {
+    std::string text = format_entry(entry);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    drop_locked(index);  // an entry left open here belongs to a file that failed
+    ++count_;
+    return push_locked(index, false, std::move(text));
+}
+
+bool ResultSpool::add_blocks(uint64_t index, const std::vector<std::pair<size_t, double>>& blocks, bool first) {
+    // the entry's text is cut where its blocks are: the opening, then
+    // each run, then end_blocks() closes the array and adds the other
+    // fields ("blocks" sorts first among them)
+    std::string text;
+    if (first) {
+        text = "  {\n    \"blocks\": [\n";
+    }
+    append_blocks(blocks, !first, text);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (first) {
+        drop_locked(index);
+        streams_[index] = sequence_;
+    } else if (streams_.find(index) == streams_.end()) {
+        error_message_ = "No entry is being streamed at position " + std::to_string(index);
+        return false;
+    }
+    return push_locked(index, !first, std::move(text));
+}
+
+bool ResultSpool::end_blocks(uint64_t index, const nlohmann::json& entry) {
+    nlohmann::json rest = entry;
+    rest.erase("blocks");
+    std::string text = "\n    ],\n" + format_entry(rest).substr(4);  // past the opening "  {\n"
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto stream = streams_.find(index);
+    if (stream == streams_.end()) {
+        error_message_ = "No entry is being streamed at position " + std::to_string(index);
+        return false;
+    }
+    streams_.erase(stream);
+    ++count_;
+    return push_locked(index, true, std::move(text));
+}
+
+bool ResultSpool::push_locked(uint64_t index, bool continues, std::string text) {
+    size_t cost = text.size() + kEntryOverhead;
+    uint64_t sequence = sequence_++;
+    if (!reserve_locked(cost)) {
+        if (!spill_locked()) return false;
+        if (!reserve_locked(cost)) {
+            // larger than the whole allowance: goes to disk on its own
+            pending_.push_back({index, sequence, continues, std::move(text)});
+            return spill_locked();
+        }
+    }
+    memory_used_ += cost;
+    pending_.push_back({index, sequence, continues, std::move(text)});
+    return true;
+}
+
+void ResultSpool::drop_locked(uint64_t index) {
+    auto stream = streams_.find(index);
+    if (stream != streams_.end()) {
+        dropped_.push_back({index, stream->second, sequence_ - 1});
+        streams_.erase(stream);
+    }
+}
+
+bool ResultSpool::reserve_locked(size_t bytes) {
+    if (memory_limit_ > 0 && memory_used_ + bytes > memory_limit_) {
+        return false;
+    }
+    return !pool_ || pool_->try_reserve(bytes);
+}
+
+bool ResultSpool::spill_locked() {
+    if (pending_.empty()) {
+        return true;
+    }
+    if (!file_) {
+        std::string pattern = (fs::temp_directory_path() / "entropix-spool-XXXXXX").string();
+        int fd = ::mkstemp(pattern.data());
+        if (fd >= 0) {
+            ::unlink(pattern.c_str());  // nothing is left behind, however the process ends
+            file_ = ::fdopen(fd, "w+b");
+        }
+        if (!file_) {
+            if (fd >= 0) ::close(fd);
+            error_message_ = "Cannot create spill file in " + fs::temp_directory_path().string();
+            return false;
+        }
+    }
+
+    std::sort(pending_.begin(), pending_.end(), entry_before<Pending>);
+    Run run{file_size_, 0};
+    bool ok = std::fseek(file_, static_cast<long>(file_size_), SEEK_SET) == 0;
+    for (const auto& [index, sequence, continues, text] : pending_) {
+        uint64_t header[4] = {index, sequence, continues ? 1u : 0u, text.size()};
+        ok = ok && std::fwrite(header, sizeof(header), 1, file_) == 1
+            && (text.empty() || std::fwrite(text.data(), text.size(), 1, file_) == 1);
+        run.bytes += sizeof(header) + text.size();
+    }
+    ok = ok && std::fflush(file_) == 0;
+    if (!ok) {
+        error_message_ = "Cannot write spill file";
+        return false;
+    }
+    file_size_ += run.bytes;
+    runs_.push_back(run);
+
+    pending_.clear();
+    pending_.shrink_to_fit();
+    if (pool_ && memory_used_ > 0) {
+        pool_->release(memory_used_);
+    }
+    memory_used_ = 0;
+    return true;
+}
+
+bool ResultSpool::write_array(std::ostream& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::sort(pending_.begin(), pending_.end(), entry_before<Pending>);
+    while (!streams_.empty()) {
+        drop_locked(streams_.begin()->first);  // never ended: their files failed
+    }
+    auto dropped = [&](uint64_t index, uint64_t sequence) {
+        return std::any_of(dropped_.begin(), dropped_.end(), [&](const Dropped& d) {
+            return d.index == index && sequence >= d.first && sequence <= d.last;
+        });
+    };
+
+    // sources: every spilled run plus the in-memory entries
+    std::vector<RunReader> readers;
+    for (const Run& run : runs_) {
+        readers.emplace_back(::fileno(file_), run.offset, run.bytes);
+    }
+    const size_t memory_source = readers.size();
+    size_t memory_pos = 0;
+
+    struct Head {
+        uint64_t index;
+        uint64_t sequence;
+        bool continues;
+        size_t source;
+        std::string text;
+    };
+    auto later = [](const Head& a, const Head& b) { return entry_before(b, a); };
+    std::vector<Head> heads;  // min-heap on (index, sequence), one head per source
+
+    auto advance = [&](size_t source) -> bool {
+        Head head{0, 0, false, source, {}};
+        if (source == memory_source) {
+            if (memory_pos == pending_.size()) return true;
+            head.index = pending_[memory_pos].index;
+            head.sequence = pending_[memory_pos].sequence;
+            head.continues = pending_[memory_pos].continues;
+            head.text = std::move(pending_[memory_pos].text);
+            ++memory_pos;
+        } else {
+            bool ok;
+            if (!readers[source].next(head.index, head.sequence, head.continues, head.text, ok)) return ok;
+        }
+        heads.push_back(std::move(head));
+        std::push_heap(heads.begin(), heads.end(), later);
+        return true;
+    };
+
+    for (size_t source = 0; source <= memory_source; ++source) {
+        if (!advance(source)) {
+            error_message_ = "Cannot read spill file";
+            return false;
+        }
+    }
+
+    bool first = true;
+    out << "[";
+    while (!heads.empty()) {
+        std::pop_heap(heads.begin(), heads.end(), later);
+        Head head = std::move(heads.back());
+        heads.pop_back();
+        if (dropped_.empty() || !dropped(head.index, head.sequence)) {
+            // pieces of a streamed entry follow each other without a separator
+            out << (head.continues ? "" : first ? "\n" : ",\n") << head.text;
+            first = false;
+        }
+        if (!advance(head.source)) {
+            error_message_ = "Cannot read spill file";
+            return false;
+        }
+    }
+    out << (first ? "]" : "\n]") << "\n";
+
+    pending_.clear();
+    dropped_.clear();
+    if (pool_ && memory_used_ > 0) {
+        pool_->release(memory_used_);
+    }
+    memory_used_ = 0;
+    return true;
+}
+
+uint64_t ResultSpool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+size_t ResultSpool::get_spill_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return runs_.size();
+}
+
+const std::string& ResultSpool::get_error_message() const {
+    return error_message_;
+}
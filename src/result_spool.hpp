@@ -0,0 +1,146 @@
+#ifndef RESULT_SPOOL_HPP
+#define RESULT_SPOOL_HPP
+
+#include "buffer_pool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/**
+ * @class ResultSpool
+ * @brief Collects report entries out of order and writes them in order, spilling to disk.
+ *
+ * Entries are kept as formatted text keyed by their position in the file
+ * list; entries added under the same position (the members of one archive)
+ * keep the order they were added in. When the in-memory text would exceed the spool's limit, or the
+ * shared BufferPool refuses the reservation, the buffered entries are
+ * sorted and appended to an unlinked temporary file as one run. At the end
+ * write_array() merges the runs and the remaining entries by position and
+ * writes the same text utils::write_json_output() would for the full array.
+ *
+ * A block entry can also arrive in pieces: add_blocks() takes its blocks
+ * run by run as a file is streamed, and end_blocks() the rest of the entry,
+ * so a file's blocks need not all be in memory at once.
+ *
+ * add(), add_blocks() and end_blocks() are thread-safe. Entries of one
+ * position are added by one thread at a time.
+ */
+class ResultSpool {
+public:
+    /**
+     * @brief Constructs an empty spool.
+     *
+     * @param pool Pool that in-memory entries are charged to, or nullptr.
+     * @param memory_limit Maximum bytes of buffered entries; 0 for no limit
+     *                     of its own.
+     */
+    ResultSpool(BufferPool* pool, size_t memory_limit);
+
+    /**
+     * @brief Closes the temporary file and returns reserved memory.
+     */
+    ~ResultSpool();
+
+    ResultSpool(const ResultSpool&) = delete;
+    ResultSpool& operator=(const ResultSpool&) = delete;
+
+    /**
+     * @brief Adds an entry of the file at position @p index.
+     *
+     * @return false if spilling to disk failed (see get_error_message()).
+     */
+    bool add(uint64_t index, const nlohmann::json& entry);
+
+    /**
+     * @brief Adds a run of (offset, entropy) blocks to the entry being streamed at @p index.
+     *
+     * @p first starts a new entry. An entry that is not ended with
+     * end_blocks() before the next entry at the same position, or before
+     * write_array(), is left out of the report.
+     *
+     * @return false if spilling to disk failed (see get_error_message()).
+     */
+    bool add_blocks(uint64_t index, const std::vector<std::pair<size_t, double>>& blocks, bool first);
+
+    /**
+     * @brief Completes the entry being streamed at @p index.
+     *
+     * @param entry The entry; its "blocks" array is ignored, the blocks
+     *              given to add_blocks() take its place.
+     *
+     * @return false if no entry is being streamed at @p index or spilling
+     *         to disk failed (see get_error_message()).
+     */
+    bool end_blocks(uint64_t index, const nlohmann::json& entry);
+
+    /**
+     * @brief Writes all entries as a JSON array ordered by position.
+     *
+     * Consumes the buffered entries; call once, after the last add().
+     *
+     * @return false if a spilled run could not be read back.
+     */
+    bool write_array(std::ostream& out);
+
+    /**
+     * @brief Returns the number of entries added.
+     */
+    uint64_t size() const;
+
+    /**
+     * @brief Returns the number of runs written to disk.
+     */
+    size_t get_spill_count() const;
+
+    /**
+     * @brief Returns the error message of the last failed call.
+     */
+    const std::string& get_error_message() const;
+
+private:
+    struct Pending {
+        uint64_t index;
+        uint64_t sequence;  // add() order, for entries of the same position
+        bool continues;     // a later piece of a streamed entry, written without a separator
+        std::string text;
+    };
+
+    struct Dropped {
+        uint64_t index;
+        uint64_t first;  // sequences of the pieces of an unfinished streamed entry
+        uint64_t last;
+    };
+
+    struct Run {
+        uint64_t offset;  // first record in the spill file
+        uint64_t bytes;
+    };
+
+    bool push_locked(uint64_t index, bool continues, std::string text);
+    bool reserve_locked(size_t bytes);
+    bool spill_locked();
+    void drop_locked(uint64_t index);
+
+    BufferPool* pool_;
+    size_t memory_limit_;
+    size_t memory_used_ = 0;
+    uint64_t count_ = 0;     // complete entries
+    uint64_t sequence_ = 0;  // pieces added, entries or parts of them
+    std::unordered_map<uint64_t, uint64_t> streams_;  // position -> first sequence of its open entry
+    std::vector<Dropped> dropped_;
+    std::vector<Pending> pending_;
+    std::FILE* file_ = nullptr;
+    uint64_t file_size_ = 0;
+    std::vector<Run> runs_;
+    std::string error_message_;
+    mutable std::mutex mutex_;
+};
+
+#endif // RESULT_SPOOL_HPP
@@ -0,0 +1,407 @@
+#include "scan_checkpoint.hpp"
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+using json = nlohmann::json;
+
+namespace {
+
+    constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+    constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+    bool stat_file(const fs::path& path, uint64_t& size, int64_t& mtime_ns) {
+        std::error_code size_ec;
+        std::error_code time_ec;
+        size = fs::file_size(path, size_ec);
+        auto mtime = fs::last_write_time(path, time_ec);
+        if (size_ec || time_ec) {
+            return false;
+        }
+        mtime_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            mtime.time_since_epoch()).count();
+        return true;
+    }
+
+    std::string journal_line(size_t index, const json& entry) {
+        return json{{"index", index}, {"entry", entry}}.dump() + "\n";
+    }
+
+    // the data must be on disk before a checkpoint that refers to it
+    bool flush_and_sync(std::FILE* file) {
+        return std::fflush(file) == 0 && ::fsync(::fileno(file)) == 0;
+    }
+
+} // namespace
+
+ScanCheckpoint::ScanCheckpoint(std::string path, std::chrono::milliseconds interval)
+    : path_(std::move(path)), journal_path_(path_ + ".journal"), interval_(interval) {}
+
+ScanCheckpoint::~ScanCheckpoint() {
+    if (journal_) {
+        std::fclose(journal_);
+    }
+}
+
+uint64_t ScanCheckpoint::hash_files(const std::vector<fs::path>& files) {
+    return hash_files(files, kFnvOffset);
+}
+
+uint64_t ScanCheckpoint::hash_files(const std::vector<fs::path>& files, uint64_t hash) {
+    for (const fs::path& file : files) {
+        for (char c : file.native()) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * kFnvPrime;
+        }
+        hash = hash * kFnvPrime;  // separator, so "ab","c" differs from "a","bc"
+    }
+    return hash;
+}
+
+bool ScanCheckpoint::open_journal(bool truncate) {
+    if (journal_) {
+        std::fclose(journal_);
+    }
+    journal_ = std::fopen(journal_path_.c_str(), truncate ? "w+b" : "r+b");
+    if (!journal_) {
+        error_message_ = "Cannot open checkpoint journal: " + journal_path_;
+        return false;
+    }
+    return true;
+}
+
+bool ScanCheckpoint::begin(const json& scan, const std::vector<fs::path>& files) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    scan_ = scan;
+    list_hash_ = hash_files(files);
+    completed_.assign(files.size(), false);
+    completed_count_ = 0;
+    in_progress_.clear();
+    journal_bytes_ = 0;
+    has_prefix_ = false;
+    prefix_aggregates_ = json();
+    if (!open_journal(true)) {
+        return false;
+    }
+    // written up front so a run interrupted before the first interval resumes too
+    return write_locked();
+}
+
+bool ScanCheckpoint::resume(const json& scan, const std::vector<fs::path>& files,
+                            ResultSpool& spool, bool& found) {
+    std::ifstream in(path_);
+    found = in.is_open();
+    if (!found) {
+        return begin(scan, files);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    json state = json::parse(in, nullptr, false);
+    try {
+        if (state.is_discarded() || state.at("type") != "checkpoint"
+            || state.at("version") != kVersion) {
+            error_message_ = "Not a checkpoint file: " + path_;
+            return false;
+        }
+        if (state.at("scan") != scan) {
+            error_message_ = "Checkpoint " + path_ + " was taken from a different scan or options";
+            return false;
+        }
+        if (state.at("files").get<uint64_t>() != files.size()
+            || state.at("list_hash").get<uint64_t>() != hash_files(files)) {
+            error_message_ = "Files under the scan root changed since checkpoint " + path_;
+            return false;
+        }
+
+        scan_ = scan;
+        list_hash_ = hash_files(files);
+        completed_.assign(files.size(), false);
+        completed_count_ = 0;
+        for (const json& run : state.at("completed")) {
+            uint64_t first = run.at(0).get<uint64_t>();
+            uint64_t end = run.at(1).get<uint64_t>();
+            if (first > end || end > files.size()) {
+                throw std::out_of_range("completed run outside the file list");
+            }
+            for (uint64_t i = first; i < end; ++i) {
+                completed_[i] = true;
+            }
+            completed_count_ += end - first;
+        }
+        in_progress_.clear();
+        for (const json& file : state.at("in_progress")) {
+            InProgress record;
+            size_t index = file.at("index").get<size_t>();
+            if (index >= files.size()) {
+                throw std::out_of_range("file in progress outside the file list");
+            }
+            record.size = file.at("size").get<uint64_t>();
+            record.mtime_ns = file.at("mtime_ns").get<int64_t>();
+            record.progress.offset = file.at("offset").get<uint64_t>();
+            record.progress.histogram = file.at("histogram").get<std::array<size_t, 256>>();
+            for (const json& block : file.at("blocks")) {
+                record.progress.blocks.emplace_back(block.at(0).get<size_t>(), block.at(1).get<double>());
+            }
+            record.members = file.value("members", uint64_t{0});
+            in_progress_[index] = std::move(record);
+        }
+        journal_bytes_ = state.at("journal_bytes").get<uint64_t>();
+        has_prefix_ = state.contains("prefix");
+        if (has_prefix_) {
+            const json& prefix = state.at("prefix");
+            completed_count_ = prefix.at("files").get<uint64_t>();
+            prefix_hash_ = prefix.at("list_hash").get<uint64_t>();
+            prefix_aggregates_ = prefix.at("aggregates");
+        }
+    } catch (const std::exception& e) {
+        error_message_ = "Corrupt checkpoint file " + path_ + ": " + e.what();
+        return false;
+    }
+    // the journal holds entries of an archive's first members; they cannot be taken back
+    for (const auto& [index, record] : in_progress_) {
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        if (record.members > 0 && (!stat_file(files[index], size, mtime_ns) || size != record.size
+                                   || mtime_ns != record.mtime_ns)) {
+            error_message_ = "Archive " + files[index].string() + " changed since checkpoint " + path_;
+            return false;
+        }
+    }
+
+    // lines after the checkpointed length belong to files that will be scanned again
+    std::error_code ec;
+    uint64_t journal_size = fs::file_size(journal_path_, ec);
+    if (ec || journal_size < journal_bytes_) {
+        error_message_ = "Checkpoint journal is missing or truncated: " + journal_path_;
+        return false;
+    }
+    fs::resize_file(journal_path_, journal_bytes_, ec);
+    if (ec) {
+        error_message_ = "Cannot truncate checkpoint journal: " + journal_path_;
+        return false;
+    }
+    std::ifstream journal(journal_path_);
+    std::string line;
+    while (std::getline(journal, line)) {
+        json record = json::parse(line, nullptr, false);
+        if (record.is_discarded() || !record.contains("index") || !record.contains("entry")) {
+            error_message_ = "Corrupt checkpoint journal: " + journal_path_;
+            return false;
+        }
+        if (!spool.add(record["index"].get<uint64_t>(), record["entry"])) {
+            error_message_ = spool.get_error_message();
+            return false;
+        }
+    }
+    if (!open_journal(false) || std::fseek(journal_, 0, SEEK_END) != 0) {
+        error_message_ = "Cannot open checkpoint journal: " + journal_path_;
+        return false;
+    }
+    last_write_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool ScanCheckpoint::is_complete(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index < completed_.size() && completed_[index];
+}
+
+bool ScanCheckpoint::get_progress(size_t index, const fs::path& path, FileProgress& progress) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = in_progress_.find(index);
+    if (it == in_progress_.end() || it->second.members > 0) {
+        return false;
+    }
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    if (!stat_file(path, size, mtime_ns) || size != it->second.size
+        || mtime_ns != it->second.mtime_ns) {
+        return false;  // changed since; start the file over
+    }
+    progress = it->second.progress;
+    return true;
+}
+
+uint64_t ScanCheckpoint::get_member_count(size_t index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = in_progress_.find(index);
+    return it == in_progress_.end() ? 0 : it->second.members;
+}
+
+bool ScanCheckpoint::update_progress(size_t index, const fs::path& path, const FileProgress& progress) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = in_progress_.find(index);
+    if (it == in_progress_.end()) {
+        InProgress record;
+        if (!stat_file(path, record.size, record.mtime_ns)) {
+            return true;  // cannot be verified on resume; the file will just start over
+        }
+        it = in_progress_.emplace(index, std::move(record)).first;
+    }
+    // only the blocks found since the last update are copied
+    FileProgress& recorded = it->second.progress;
+    if (progress.offset < recorded.offset || progress.blocks.size() < recorded.blocks.size()) {
+        recorded.blocks.clear();  // the analyzer started this file over
+    }
+    recorded.offset = progress.offset;
+    recorded.histogram = progress.histogram;
+    recorded.blocks.insert(recorded.blocks.end(),
+                           progress.blocks.begin() + static_cast<std::ptrdiff_t>(recorded.blocks.size()),
+                           progress.blocks.end());
+    return maybe_write_locked();
+}
+
+bool ScanCheckpoint::write_journal(const std::string& lines) {
+    if (std::fwrite(lines.data(), lines.size(), 1, journal_) != 1) {
+        error_message_ = "Cannot write checkpoint journal: " + journal_path_;
+        return false;
+    }
+    journal_bytes_ += lines.size();
+    return true;
+}
+
+bool ScanCheckpoint::complete(size_t index, const json* entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entry && !write_journal(journal_line(index, *entry))) {
+        return false;
+    }
+    if (index < completed_.size() && !completed_[index]) {
+        completed_[index] = true;
+        ++completed_count_;
+    }
+    in_progress_.erase(index);
+    return maybe_write_locked();
+}
+
+bool ScanCheckpoint::complete_member(size_t index, const fs::path& path, const json* entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (entry && !write_journal(journal_line(index, *entry))) {
+        return false;
+    }
+    auto it = in_progress_.find(index);
+    if (it == in_progress_.end()) {
+        // unlike a file's progress this cannot be dropped; an unknown size fails the check on resume
+        InProgress record;
+        stat_file(path, record.size, record.mtime_ns);
+        it = in_progress_.emplace(index, std::move(record)).first;
+    }
+    ++it->second.members;
+    return maybe_write_locked();
+}
+
+bool ScanCheckpoint::complete_prefix(uint64_t files, uint64_t list_hash, json aggregates) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    has_prefix_ = true;
+    completed_count_ = files;
+    prefix_hash_ = list_hash;
+    prefix_aggregates_ = std::move(aggregates);
+    return maybe_write_locked();
+}
+
+bool ScanCheckpoint::get_prefix(uint64_t& files, uint64_t& list_hash, json& aggregates) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!has_prefix_) {
+        return false;
+    }
+    files = completed_count_;
+    list_hash = prefix_hash_;
+    aggregates = prefix_aggregates_;
+    return true;
+}
+
+bool ScanCheckpoint::write() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return write_locked();
+}
+
+bool ScanCheckpoint::maybe_write_locked() {
+    if (std::chrono::steady_clock::now() - last_write_ < interval_) {
+        return true;
+    }
+    return write_locked();
+}
+
+bool ScanCheckpoint::write_locked() {
+    // a failed write is retried after the next interval, not on every file
+    last_write_ = std::chrono::steady_clock::now();
+    if (!journal_ || !flush_and_sync(journal_)) {
+        error_message_ = "Cannot sync checkpoint journal: " + journal_path_;
+        return false;
+    }
+
+    json state;
+    state["type"] = "checkpoint";
+    state["version"] = kVersion;
+    state["scan"] = scan_;
+    state["files"] = completed_.size();
+    state["list_hash"] = list_hash_;
+    state["journal_bytes"] = journal_bytes_;
+    // completed files as [first, end) runs; mostly contiguous in scheduling order
+    json runs = json::array();
+    for (size_t i = 0; i < completed_.size();) {
+        if (!completed_[i]) {
+            ++i;
+            continue;
+        }
+        size_t first = i;
+        while (i < completed_.size() && completed_[i]) ++i;
+        runs.push_back({first, i});
+    }
+    state["completed"] = std::move(runs);
+    json files = json::array();
+    for (const auto& [index, record] : in_progress_) {
+        json file;
+        file["index"] = index;
+        file["size"] = record.size;
+        file["mtime_ns"] = record.mtime_ns;
+        file["offset"] = record.progress.offset;
+        file["histogram"] = record.progress.histogram;
+        file["blocks"] = record.progress.blocks;
+        if (record.members > 0) {
+            file["members"] = record.members;
+        }
+        files.push_back(std::move(file));
+    }
+    state["in_progress"] = std::move(files);
+    if (has_prefix_) {
+        state["prefix"] = {{"files", completed_count_}, {"list_hash", prefix_hash_},
+                           {"aggregates", prefix_aggregates_}};
+    }
+
+    std::string text = state.dump();
+    std::string tmp_path = path_ + ".tmp";
+    std::FILE* out = std::fopen(tmp_path.c_str(), "wb");
+    bool ok = out && std::fwrite(text.data(), text.size(), 1, out) == 1 && flush_and_sync(out);
+    if (out) {
+        ok = std::fclose(out) == 0 && ok;
+    }
+    if (!ok) {
+        error_message_ = "Cannot write checkpoint: " + tmp_path;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    if (std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+        error_message_ = "Cannot replace checkpoint: " + path_;
+        std::remove(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+void ScanCheckpoint::remove() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (journal_) {
+        std::fclose(journal_);
+        journal_ = nullptr;
+    }
+    std::remove(path_.c_str());
+    std::remove(journal_path_.c_str());
+}
+
+uint64_t ScanCheckpoint::get_completed_count() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return completed_count_;
+}
+
+const std::string& ScanCheckpoint::get_error_message() const {
+    return error_message_;
+}
@@ -0,0 +1,225 @@
+#ifndef SCAN_CHECKPOINT_HPP
+#define SCAN_CHECKPOINT_HPP
+
+#include "file_analyzer.hpp"
+#include "result_spool.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+/**
+ * @class ScanCheckpoint
+ * @brief Records the progress of a long scan so an interrupted run can resume.
+ *
+ * Two files are kept next to each other:
+ *
+ * - The journal (<path>.journal) receives every report entry as its file
+ *   completes, one JSON line per entry. It is the scan's streaming output.
+ * - The checkpoint (<path>) says which files are complete, how far each
+ *   large file in progress has got (offset, byte histogram and qualifying
+ *   blocks) or how many members of each archive in progress are done, and
+ *   how many journal bytes belong to that work.
+ *
+ * The checkpoint is rewritten at most once per interval, from whichever
+ * worker completes a file or a chunk after the interval has passed. The
+ * journal is synced first and the checkpoint is replaced atomically
+ * (temporary file and rename), so after a crash the pair always describes
+ * a consistent state; journal lines written after the last checkpoint are
+ * discarded on resume and their files scanned again.
+ *
+ * A checkpoint only resumes the scan it was taken from: the root, options
+ * and file list must match. Files in progress are continued only if their
+ * size and modification time are unchanged, and otherwise start over. An
+ * archive in progress has already journaled entries for its first members,
+ * so if it changed the checkpoint cannot be resumed at all.
+ *
+ * Streamed scans (summaries), which never hold the file list, are begun
+ * with an empty list and instead record a completed prefix of the file
+ * stream with complete_prefix(): its length, a hash of its paths and the
+ * caller's aggregates at that point. They have no journal entries and no
+ * files in progress.
+ *
+ * All methods after begin()/resume() are thread-safe.
+ */
+class ScanCheckpoint {
+public:
+    static constexpr int kVersion = 1;
+
+    /**
+     * @brief Constructs a checkpoint kept at @p path.
+     *
+     * @param path The checkpoint file; the journal is @p path + ".journal".
+     * @param interval Minimum time between two checkpoint writes.
+     */
+    ScanCheckpoint(std::string path, std::chrono::milliseconds interval);
+
+    /**
+     * @brief Closes the journal.
+     */
+    ~ScanCheckpoint();
+
+    ScanCheckpoint(const ScanCheckpoint&) = delete;
+    ScanCheckpoint& operator=(const ScanCheckpoint&) = delete;
+
+    /**
+     * @brief Starts a new scan of @p files, discarding any earlier checkpoint.
+     *
+     * @param scan Identifies the scan (root and options); compared on resume.
+     * @param files The files of the scan, in report order.
+     *
+     * @return false if the journal or checkpoint cannot be written.
+     */
+    bool begin(const nlohmann::json& scan, const std::vector<fs::path>& files);
+
+    /**
+     * @brief Continues the scan recorded at the checkpoint path.
+     *
+     * Replays the journal entries of completed files into @p spool and
+     * truncates the journal to the checkpointed length.
+     *
+     * @param found Set to false if there is no checkpoint; begin() has then
+     *              been called instead.
+     *
+     * @return false if the checkpoint is unreadable, belongs to a different
+     *         scan or file list, an archive in progress has changed, or the
+     *         journal is shorter than recorded.
+     */
+    bool resume(const nlohmann::json& scan, const std::vector<fs::path>& files,
+                ResultSpool& spool, bool& found);
+
+    /**
+     * @brief Returns whether the file at position @p index was completed.
+     */
+    bool is_complete(size_t index) const;
+
+    /**
+     * @brief Looks up the recorded progress of the file at position @p index.
+     *
+     * @return true and fills @p progress if the file was in progress and its
+     *         size and modification time still match; false for archives.
+     */
+    bool get_progress(size_t index, const fs::path& path, FileProgress& progress) const;
+
+    /**
+     * @brief Returns how many members of the archive at position @p index are complete.
+     */
+    uint64_t get_member_count(size_t index) const;
+
+    /**
+     * @brief Records that the file at position @p index has been analyzed up to @p progress.
+     *
+     * @return false if a due checkpoint could not be written.
+     */
+    bool update_progress(size_t index, const fs::path& path, const FileProgress& progress);
+
+    /**
+     * @brief Records that the file at position @p index is complete.
+     *
+     * @param entry The file's report entry, or nullptr if it has none.
+     *
+     * @return false if the journal or a due checkpoint could not be written.
+     */
+    bool complete(size_t index, const nlohmann::json* entry);
+
+    /**
+     * @brief Records that the next member of the archive at position @p index is complete.
+     *
+     * The archive itself is completed with complete(index, nullptr) after
+     * its last member. Member entries are replayed in this order on resume.
+     *
+     * @param path The archive.
+     * @param entry The member's report entry, or nullptr if it has none.
+     *
+     * @return false if the journal or a due checkpoint could not be written.
+     */
+    bool complete_member(size_t index, const fs::path& path, const nlohmann::json* entry);
+
+    /**
+     * @brief Records that the first @p files files of a streamed scan are complete.
+     *
+     * @param list_hash hash_files() of their paths.
+     * @param aggregates The caller's results for them, restored by get_prefix().
+     *
+     * @return false if a due checkpoint could not be written.
+     */
+    bool complete_prefix(uint64_t files, uint64_t list_hash, nlohmann::json aggregates);
+
+    /**
+     * @brief Looks up the completed prefix of a streamed scan.
+     *
+     * @return false if none was recorded; the scan starts from the first file.
+     */
+    bool get_prefix(uint64_t& files, uint64_t& list_hash, nlohmann::json& aggregates) const;
+
+    /**
+     * @brief Writes the checkpoint now, regardless of the interval.
+     */
+    bool write();
+
+    /**
+     * @brief Deletes the checkpoint and journal once the report is written.
+     */
+    void remove();
+
+    /**
+     * @brief Returns the number of completed files, or the length of a streamed scan's prefix.
+     */
+    uint64_t get_completed_count() const;
+
+    /**
+     * @brief Returns the error message of the last failed call.
+     */
+    const std::string& get_error_message() const;
+
+    /**
+     * @brief Stable 64-bit FNV-1a hash of the file list, in order.
+     */
+    static uint64_t hash_files(const std::vector<fs::path>& files);
+
+    /**
+     * @brief Continues @p hash, a hash_files() result, over @p files.
+     *
+     * Hashing a list in pieces gives the same result as hashing it whole.
+     */
+    static uint64_t hash_files(const std::vector<fs::path>& files, uint64_t hash);
+
+private:
+    struct InProgress {
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        FileProgress progress;
+        uint64_t members = 0;  // archives only
+    };
+
+    bool open_journal(bool truncate);
+    bool write_journal(const std::string& lines);
+    bool write_locked();
+    bool maybe_write_locked();
+
+    std::string path_;
+    std::string journal_path_;
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point last_write_;
+    nlohmann::json scan_;
+    uint64_t list_hash_ = 0;
+    std::vector<bool> completed_;
+    uint64_t completed_count_ = 0;
+    std::map<size_t, InProgress> in_progress_;
+    std::FILE* journal_ = nullptr;
+    uint64_t journal_bytes_ = 0;
+    bool has_prefix_ = false;  // streamed scans only
+    uint64_t prefix_hash_ = 0;
+    nlohmann::json prefix_aggregates_;
+    std::string error_message_;
+    mutable std::mutex mutex_;
+};
+
+#endif // SCAN_CHECKPOINT_HPP
@@ -0,0 +1,34 @@
+#include "scan_context.hpp"
+
+ScanContext::ScanContext(size_t expected_blocks, size_t scratch_bytes) {
+    histogram_.fill(0);
+    results_.reserve(expected_blocks);
+    scratch_.resize(scratch_bytes);
+}
+
+std::array<size_t, 256>& ScanContext::histogram() {
+    return histogram_;
+}
+
+void ScanContext::clear_histogram() {
+    histogram_.fill(0);
+}
+
+std::vector<std::pair<size_t, double>>& ScanContext::results() {
+    return results_;
+}
+
+const std::vector<std::pair<size_t, double>>& ScanContext::results() const {
+    return results_;
+}
+
+void ScanContext::reset_results() {
+    results_.clear();
+}
+
+std::vector<unsigned char>& ScanContext::scratch(size_t min_size) {
+    if (scratch_.size() < min_size) {
+        scratch_.resize(min_size);
+    }
+    return scratch_;
+}
@@ -0,0 +1,79 @@
+#ifndef SCAN_CONTEXT_HPP
+#define SCAN_CONTEXT_HPP
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+/**
+ * @class ScanContext
+ * @brief Reusable working storage for block entropy scans.
+ *
+ * A ScanContext owns the histogram, result and scratch buffers that a block
+ * scan needs. Buffers are only ever grown, never shrunk, so once a context has
+ * seen its largest input, further scans through it perform no heap allocations.
+ *
+ * A context is not thread-safe; give each worker its own and reuse it across
+ * blocks and files.
+ */
+class ScanContext {
+public:
+
+    /**
+     * @brief Constructs a ScanContext with optional preallocated capacity.
+     *
+     * @param expected_blocks Number of block results to reserve up front.
+     * @param scratch_bytes Number of scratch bytes to reserve up front.
+     */
+    explicit ScanContext(size_t expected_blocks = 0, size_t scratch_bytes = 0);
+
+    /**
+     * @brief Returns the histogram buffer used for the current block.
+     *
+     * The contents are only meaningful between a call to clear_histogram()
+     * and the next one.
+     *
+     * @return A reference to a 256-element byte frequency array.
+     */
+    std::array<size_t, 256>& histogram();
+
+    /**
+     * @brief Zeroes the histogram buffer.
+     */
+    void clear_histogram();
+
+    /**
+     * @brief Returns the (offset, entropy) results of the most recent scan.
+     *
+     * @return A reference to the result buffer owned by this context.
+     */
+    std::vector<std::pair<size_t, double>>& results();
+    const std::vector<std::pair<size_t, double>>& results() const;
+
+    /**
+     * @brief Clears the result buffer.
+     *
+     * Capacity from earlier scans is retained, so a scan only allocates when
+     * it produces more results than any previous scan through this context.
+     */
+    void reset_results();
+
+    /**
+     * @brief Returns a scratch byte buffer of at least @p min_size bytes.
+     *
+     * The buffer acts as a grow-only arena for callers that need temporary
+     * byte storage (e.g. read buffers). Its contents are unspecified.
+     *
+     * @param min_size The minimum number of bytes required.
+     * @return A reference to the scratch buffer.
+     */
+    std::vector<unsigned char>& scratch(size_t min_size);
+
+private:
+    std::array<size_t, 256> histogram_;
+    std::vector<std::pair<size_t, double>> results_;
+    std::vector<unsigned char> scratch_;
+};
+
+#endif // SCAN_CONTEXT_HPP
@@ -0,0 +1,407 @@
+#include "scan_daemon.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+    // longest request line accepted before the connection is dropped
+    constexpr size_t kMaxRequestLine = 64 * 1024;
+
+    bool send_all(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            sent += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // paths are not always valid UTF-8; replace bad bytes rather than throw
+    std::string dump_line(const json& message) {
+        return message.dump(-1, ' ', false, json::error_handler_t::replace) + "\n";
+    }
+
+    bool send_line(int fd, const json& message) {
+        return send_all(fd, dump_line(message));
+    }
+
+    json error_reply(const json& id, const std::string& message) {
+        json reply;
+        reply["id"] = id;
+        reply["error"] = message;
+        reply["done"] = true;
+        return reply;
+    }
+
+    // Output lines produced by workers for one request, drained by the
+    // connection thread.
+    struct RequestState {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::string> lines;
+        size_t in_flight = 0;
+        size_t reported = 0;
+        size_t errors = 0;
+        size_t cached = 0;
+    };
+
+} // namespace
+
+ScanDaemon::ScanDaemon(const DaemonOptions& options)
+    : options_(options), cache_(options.cache_entries) {
+    options_.workers = std::max<size_t>(options_.workers, 1);
+    options_.max_requests = std::max<size_t>(options_.max_requests, 1);
+    options_.max_connections = std::max<size_t>(options_.max_connections, 1);
+    if (options_.max_in_flight == 0) {
+        options_.max_in_flight = 2 * options_.workers;
+    }
+}
+
+ScanDaemon::~ScanDaemon() {
+    int fd = listen_fd_.exchange(-1);
+    if (fd >= 0) {
+        ::close(fd);
+        ::unlink(options_.socket_path.c_str());
+    }
+}
+
+bool ScanDaemon::start() {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (options_.socket_path.empty() || options_.socket_path.size() >= sizeof(addr.sun_path)) {
+        error_message_ = "Invalid socket path: " + options_.socket_path;
+        return false;
+    }
+    std::memcpy(addr.sun_path, options_.socket_path.c_str(), options_.socket_path.size() + 1);
+
+    // replace a stale socket left by a previous run, but never a regular file
+    struct stat st;
+    if (::lstat(options_.socket_path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+        ::unlink(options_.socket_path.c_str());
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        error_message_ = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        error_message_ = std::string("bind: ") + std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    ::chmod(options_.socket_path.c_str(), 0600);
+    if (::listen(fd, SOMAXCONN) < 0) {
+        error_message_ = std::string("listen: ") + std::strerror(errno);
+        ::close(fd);
+        ::unlink(options_.socket_path.c_str());
+        return false;
+    }
+
+    analyzers_.resize(options_.workers);
+    worker_requests_.assign(options_.workers, 0);
+    pool_ = std::make_unique<ThreadPool>(options_.workers, 4 * options_.workers);
+    listen_fd_ = fd;
+    return true;
+}
+
+void ScanDaemon::run() {
+    while (!stopping_) {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        if (stopping_) {
+            ::close(fd);
+            break;
+        }
+        reap_connections(false);
+
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        if (connections_.size() >= options_.max_connections) {
+            // refuse rather than start another thread; the client may retry
+            send_line(fd, error_reply(nullptr, "Too many connections."));
+            ::close(fd);
+            continue;
+        }
+        connections_.push_back(std::make_unique<Connection>());
+        Connection* conn = connections_.back().get();
+        conn->fd = fd;
+        conn->thread = std::thread(&ScanDaemon::serve_connection, this, conn);
+    }
+    stopping_ = true;
+
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        requests_cv_.notify_all();
+    }
+    {
+        // wake connection threads blocked reading from idle clients
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (auto& conn : connections_) {
+            if (conn->fd >= 0) {
+                ::shutdown(conn->fd, SHUT_RDWR);
+            }
+        }
+    }
+    reap_connections(true);
+    pool_->wait_idle();
+}
+
+void ScanDaemon::stop() {
+    stopping_ = true;
+    int fd = listen_fd_.load();
+    if (fd >= 0) {
+        ::shutdown(fd, SHUT_RDWR);  // wakes accept(); async-signal-safe
+    }
+}
+
+const std::string& ScanDaemon::get_error_message() const {
+    return error_message_;
+}
+
+void ScanDaemon::reap_connections(bool all) {
+    std::list<std::unique_ptr<Connection>> finished;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        for (auto it = connections_.begin(); it != connections_.end();) {
+            if (all || (*it)->done) {
+                finished.push_back(std::move(*it));
+                it = connections_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    for (auto& conn : finished) {
+        conn->thread.join();
+    }
+}
+
+void ScanDaemon::serve_connection(Connection* conn) {
+    std::string buffer;
+    char chunk[4096];
+    bool open = true;
+
+    while (open && !stopping_) {
+        ssize_t n = ::read(conn->fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        buffer.append(chunk, static_cast<size_t>(n));
+
+        size_t newline;
+        while (open && (newline = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty()) continue;
+            open = handle_request(conn->fd, line);
+        }
+        if (buffer.size() > kMaxRequestLine) {
+            send_line(conn->fd, error_reply(nullptr, "Request line too long."));
+            break;
+        }
+    }
+
+    // hide the fd from run() before closing it so it is never shut down after reuse
+    int fd;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex_);
+        fd = conn->fd;
+        conn->fd = -1;
+    }
+    ::close(fd);
+    conn->done = true;
+}
+
+void ScanDaemon::acquire_request_slot() {
+    std::unique_lock<std::mutex> lock(requests_mutex_);
+    requests_cv_.wait(lock, [this] {
+        return active_requests_ < options_.max_requests || stopping_;
+    });
+    ++active_requests_;
+}
+
+void ScanDaemon::release_request_slot() {
+    {
+        std::lock_guard<std::mutex> lock(requests_mutex_);
+        --active_requests_;
+    }
+    requests_cv_.notify_one();
+}
+
+bool ScanDaemon::handle_request(int fd, const std::string& line) {
+    json request = json::parse(line, nullptr, false);
+    if (request.is_discarded() || !request.is_object()) {
+        return send_line(fd, error_reply(nullptr, "Request must be a JSON object."));
+    }
+    json id = request.value("id", json(nullptr));
+
+    ScanOptions scan_options;
+    std::string path;
+    bool recursive = false;
+    std::string extension;
+    try {
+        path = request.at("path").get<std::string>();
+        scan_options.entropy_threshold = request.value("threshold", 0.0);
+        int64_t block_size = request.value("block_size", int64_t{0});
+        recursive = request.value("recursive", false);
+        extension = request.value("extension", std::string());
+        if (scan_options.entropy_threshold < 0.0 || scan_options.entropy_threshold > 8.0) {
+            return send_line(fd, error_reply(id, "Entropy threshold must be in range [0.0, 8.0]."));
+        }
+        if (block_size < 0) {
+            return send_line(fd, error_reply(id, "block_size must be >= 0."));
+        }
+        scan_options.block_size = static_cast<size_t>(block_size);
+    } catch (const json::exception& e) {
+        return send_line(fd, error_reply(id, std::string("Invalid request: ") + e.what()));
+    }
+    if (!extension.empty() && extension[0] != '.')
+        extension = "." + extension;
+
+    std::vector<fs::path> files;
+    try {
+        files = utils::collect_files(path, recursive, extension);
+    } catch (const std::exception& e) {
+        return send_line(fd, error_reply(id, e.what()));
+    }
+
+    acquire_request_slot();
+    const uint64_t serial = ++request_count_;
+    auto state = std::make_shared<RequestState>();
+    size_t next = 0;
+    bool client_ok = true;
+
+    for (;;) {
+        // keep at most max_in_flight files of this request in the pool
+        while (client_ok && !stopping_ && next < files.size()) {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (state->in_flight >= options_.max_in_flight) break;
+                ++state->in_flight;
+            }
+            std::string file = files[next++].string();
+            pool_->submit([this, state, serial, file, scan_options, id](size_t worker) {
+                json reply;
+                reply["id"] = id;
+                bool reported = false;
+                bool failed = false;
+                bool from_cache = false;
+                std::string line;
+
+                // a task that throws would terminate the daemon, so any failure
+                // becomes an error line for this file
+                try {
+                    struct stat st;
+                    std::string key;
+                    std::optional<CachedResult> cached;
+                    if (::stat(file.c_str(), &st) == 0) {
+                        int64_t mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000
+                                         + st.st_mtim.tv_nsec;
+                        key = ResultCache::make_key(file, static_cast<uintmax_t>(st.st_size),
+                                                    mtime_ns, scan_options);
+                        cached = cache_.get(key);
+                    }
+
+                    if (cached) {
+                        from_cache = true;
+                        reported = cached->has_entry;
+                        if (reported) reply["entry"] = std::move(cached->entry);
+                    } else {
+                        FileAnalyzer& analyzer = analyzers_[worker];
+                        if (worker_requests_[worker] != serial) {
+                            // the tree may have changed since this worker's last request
+                            worker_requests_[worker] = serial;
+                            analyzer.revalidate_directory();
+                        }
+                        if (analyzer.analyze(file, scan_options)) {
+                            reported = analyzer.has_entry();
+                            CachedResult result;
+                            result.has_entry = reported;
+                            if (reported) result.entry = analyzer.get_entry();
+                            if (!key.empty()) cache_.put(key, result);
+                            if (reported) reply["entry"] = std::move(result.entry);
+                        } else {
+                            failed = true;
+                            reply["path"] = file;
+                            reply["error"] = analyzer.get_error_message();
+                        }
+                    }
+                    if (reported || failed) {
+                        line = dump_line(reply);
+                    }
+                } catch (const std::exception& e) {
+                    reported = false;
+                    failed = true;
+                    reply = json::object();
+                    reply["id"] = id;
+                    reply["path"] = file;
+                    reply["error"] = e.what();
+                    line = dump_line(reply);
+                }
+
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (!line.empty()) {
+                    state->lines.push_back(std::move(line));
+                }
+                state->reported += reported;
+                state->errors += failed;
+                state->cached += from_cache;
+                --state->in_flight;
+                state->cv.notify_one();
+            });
+        }
+
+        std::deque<std::string> lines;
+        bool finished;
+        {
+            std::unique_lock<std::mutex> lock(state->mutex);
+            bool can_submit = client_ok && !stopping_ && next < files.size();
+            state->cv.wait(lock, [&] {
+                return !state->lines.empty() || state->in_flight == 0
+                    || (can_submit && state->in_flight < options_.max_in_flight);
+            });
+            lines.swap(state->lines);
+            finished = state->in_flight == 0 && !(client_ok && !stopping_ && next < files.size());
+        }
+        for (const std::string& out : lines) {
+            if (client_ok && !send_all(fd, out)) {
+                client_ok = false;
+            }
+        }
+        if (finished) break;
+    }
+    release_request_slot();
+
+    if (!client_ok) {
+        return false;
+    }
+    json done;
+    done["id"] = id;
+    done["done"] = true;
+    done["files"] = next;
+    done["reported"] = state->reported;
+    done["errors"] = state->errors;
+    done["cached"] = state->cached;
+    if (stopping_) {
+        done["error"] = "Daemon is shutting down.";
+    }
+    return send_line(fd, done);
+}
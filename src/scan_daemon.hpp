@@ -0,0 +1,128 @@
+#ifndef SCAN_DAEMON_HPP
+#define SCAN_DAEMON_HPP
+
+#include "file_analyzer.hpp"
+#include "result_cache.hpp"
+#include "thread_pool.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @struct DaemonOptions
+ * @brief Settings for a long-running ScanDaemon.
+ */
+struct DaemonOptions {
+    std::string socket_path;        // Unix domain socket to listen on
+    size_t workers = 4;             // analysis threads shared by all requests
+    size_t max_requests = 8;        // requests processed concurrently; others wait
+    size_t max_connections = 64;    // open client connections; further ones are refused
+    size_t max_in_flight = 0;       // files queued per request; 0 means 2 * workers
+    size_t cache_entries = 65536;   // results kept in the LRU cache; 0 disables it
+};
+
+/**
+ * @class ScanDaemon
+ * @brief Serves scan requests over a Unix domain socket with a warm worker pool.
+ *
+ * Clients send one JSON object per line:
+ *
+ *     {"id": 1, "path": "/evidence", "threshold": 7.5, "block_size": 0,
+ *      "recursive": true, "extension": ".bin"}
+ *
+ * Only "path" is required. The daemon answers with one JSON line per reported
+ * file ({"id", "entry"}) or unreadable file ({"id", "path", "error"}) as soon
+ * as it is analyzed, followed by a summary line ({"id", "done": true, ...}).
+ * Malformed requests get a single {"id", "error", "done": true} line.
+ *
+ * Each request keeps at most max_in_flight files in the shared pool, so a
+ * client that stops reading only stalls its own request. At most max_requests
+ * requests are processed at once; further requests wait for a free slot.
+ * At most max_connections clients are connected at once; a further client
+ * gets a single {"error": "Too many connections.", "done": true} line.
+ * Results are cached by path, size, mtime and options, so repeated scans of
+ * unchanged files skip reading them.
+ */
+class ScanDaemon {
+public:
+
+    /**
+     * @brief Constructs a daemon; no socket is opened until start().
+     */
+    explicit ScanDaemon(const DaemonOptions& options);
+
+    /**
+     * @brief Stops the daemon if running and removes its socket file.
+     */
+    ~ScanDaemon();
+
+    ScanDaemon(const ScanDaemon&) = delete;
+    ScanDaemon& operator=(const ScanDaemon&) = delete;
+
+    /**
+     * @brief Creates, binds and listens on the socket.
+     *
+     * A stale socket file at the same path is replaced. The socket is made
+     * accessible to the owning user only.
+     *
+     * @return true on success, false otherwise (see get_error_message()).
+     */
+    bool start();
+
+    /**
+     * @brief Accepts and serves connections until stop() is called.
+     *
+     * Returns after all connection threads have finished.
+     */
+    void run();
+
+    /**
+     * @brief Asks run() to return. Safe to call from a signal handler.
+     */
+    void stop();
+
+    /**
+     * @brief Returns the error message of a failed start().
+     */
+    const std::string& get_error_message() const;
+
+private:
+    struct Connection {
+        int fd = -1;
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    void serve_connection(Connection* conn);
+    bool handle_request(int fd, const std::string& line);
+    void acquire_request_slot();
+    void release_request_slot();
+    void reap_connections(bool all);
+
+    DaemonOptions options_;
+    std::string error_message_;
+    std::atomic<int> listen_fd_{-1};
+    std::atomic<bool> stopping_{false};
+
+    std::vector<FileAnalyzer> analyzers_;  // one per pool worker
+    std::vector<uint64_t> worker_requests_;  // last request each worker served
+    std::atomic<uint64_t> request_count_{0};
+    ResultCache cache_;
+    std::unique_ptr<ThreadPool> pool_;     // destroyed before the analyzers and cache its tasks use
+
+    std::list<std::unique_ptr<Connection>> connections_;
+    std::mutex connections_mutex_;
+
+    size_t active_requests_ = 0;
+    std::mutex requests_mutex_;
+    std::condition_variable requests_cv_;
+};
+
+#endif // SCAN_DAEMON_HPP
@@ -0,0 +1,65 @@
+#include "shard_planner.hpp"
+#include <algorithm>
+#include <charconv>
+
+bool ShardSpec::parse(const std::string& text, ShardSpec& spec) {
+    size_t slash = text.find('/');
+    if (slash == std::string::npos) {
+        return false;
+    }
+    size_t index = 0;
+    size_t count = 0;
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    auto first = std::from_chars(begin, begin + slash, index);
+    auto second = std::from_chars(begin + slash + 1, end, count);
+    if (first.ec != std::errc() || first.ptr != begin + slash
+        || second.ec != std::errc() || second.ptr != end
+        || count == 0 || index >= count) {
+        return false;
+    }
+    spec.index = index;
+    spec.count = count;
+    return true;
+}
+
+ShardPlanner::ShardPlanner(const ShardSpec& spec, uint64_t split_bytes, size_t block_size)
+    : spec_(spec) {
+    uint64_t align = block_size > 0 ? block_size : 1;
+    split_bytes_ = std::max<uint64_t>(split_bytes / align * align, align);
+}
+
+std::vector<ShardRange> ShardPlanner::assign(const std::string& key, uint64_t size) const {
+    std::vector<ShardRange> ranges;
+    if (size == 0) {
+        return ranges;
+    }
+    uint64_t first_shard = hash_key(key) % spec_.count;
+    if (size < split_bytes_) {
+        if (first_shard == spec_.index) {
+            ranges.push_back({0, size});
+        }
+        return ranges;
+    }
+    uint64_t pieces = (size + split_bytes_ - 1) / split_bytes_;
+    for (uint64_t piece = 0; piece < pieces; ++piece) {
+        if ((first_shard + piece) % spec_.count == spec_.index) {
+            uint64_t offset = piece * split_bytes_;
+            ranges.push_back({offset, std::min(split_bytes_, size - offset)});
+        }
+    }
+    return ranges;
+}
+
+uint64_t ShardPlanner::get_split_bytes() const {
+    return split_bytes_;
+}
+
+uint64_t ShardPlanner::hash_key(const std::string& key) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
@@ -0,0 +1,88 @@
+#ifndef SHARD_PLANNER_HPP
+#define SHARD_PLANNER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @struct ShardSpec
+ * @brief Identifies one shard out of a fixed number of shards.
+ */
+struct ShardSpec {
+    size_t index = 0;  // 0-based, below count
+    size_t count = 1;
+
+    /**
+     * @brief Parses "i/N" with 0 <= i < N.
+     *
+     * @return true if @p text was valid; @p spec is left unchanged otherwise.
+     */
+    static bool parse(const std::string& text, ShardSpec& spec);
+};
+
+/**
+ * @struct ShardRange
+ * @brief A byte range [offset, offset + length) of one file.
+ */
+struct ShardRange {
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
+
+/**
+ * @class ShardPlanner
+ * @brief Deterministically splits a scan across shards.
+ *
+ * Every shard sees the same file list and makes the same decisions, so no
+ * coordination is needed between processes or hosts:
+ *
+ * - Files smaller than the split size belong whole to the shard selected by
+ *   a hash of their key (the path relative to the scan root).
+ * - Larger files are cut into ranges of the split size, rounded down to a
+ *   whole number of blocks, and the ranges are dealt round-robin starting
+ *   at the file's hashed shard.
+ *
+ * Keys rather than absolute paths are hashed, so shards may mount the
+ * evidence set at different locations.
+ */
+class ShardPlanner {
+public:
+    static constexpr uint64_t kDefaultSplitBytes = 256ull << 20;
+
+    /**
+     * @brief Constructs a planner for @p spec.
+     *
+     * @param spec The shard this process runs.
+     * @param split_bytes Files of at least this many bytes are split into ranges.
+     * @param block_size The block scan size; ranges start on block boundaries.
+     */
+    ShardPlanner(const ShardSpec& spec, uint64_t split_bytes, size_t block_size);
+
+    /**
+     * @brief Returns the ranges of a file that belong to this shard.
+     *
+     * Empty files produce no ranges on any shard.
+     *
+     * @param key The file's path relative to the scan root.
+     * @param size The file size in bytes.
+     */
+    std::vector<ShardRange> assign(const std::string& key, uint64_t size) const;
+
+    /**
+     * @brief Returns the effective range size after block alignment.
+     */
+    uint64_t get_split_bytes() const;
+
+    /**
+     * @brief Stable 64-bit FNV-1a hash used to pick a file's shard.
+     */
+    static uint64_t hash_key(const std::string& key);
+
+private:
+    ShardSpec spec_;
+    uint64_t split_bytes_;
+};
+
+#endif // SHARD_PLANNER_HPP
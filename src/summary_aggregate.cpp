@@ -0,0 +1,215 @@
+#include "summary_aggregate.hpp"
+#include <algorithm>
+
+using json = nlohmann::json;
+
+namespace {
+
+    // orders the heap so the lowest-entropy file is on top and evicted first;
+    // ties break on path so results do not depend on insertion order
+    struct TopFileGreater {
+        template <typename T>
+        bool operator()(const T& a, const T& b) const {
+            if (a.entropy != b.entropy) return a.entropy > b.entropy;
+            return a.path < b.path;
+        }
+    };
+
+    // full precision; doubles round-trip exactly through nlohmann::json
+    json rollup_to_state(const RollupStats& stats) {
+        return {stats.files, stats.bytes, stats.flagged, stats.entropy_sum, stats.max_entropy};
+    }
+
+    RollupStats rollup_from_state(const json& state) {
+        RollupStats stats;
+        stats.files = state.at(0).get<uint64_t>();
+        stats.bytes = state.at(1).get<uint64_t>();
+        stats.flagged = state.at(2).get<uint64_t>();
+        stats.entropy_sum = state.at(3).get<double>();
+        stats.max_entropy = state.at(4).get<double>();
+        return stats;
+    }
+
+    json rollup_to_json(const RollupStats& stats) {
+        json j;
+        j["files"] = stats.files;
+        j["bytes"] = stats.bytes;
+        j["flagged"] = stats.flagged;
+        j["mean_entropy"] = stats.files ? stats.entropy_sum / stats.files : 0.0;
+        j["max_entropy"] = stats.max_entropy;
+        return j;
+    }
+
+} // namespace
+
+void RollupStats::add(uint64_t size, double entropy, bool is_flagged) {
+    files += 1;
+    bytes += size;
+    flagged += is_flagged;
+    entropy_sum += entropy;
+    max_entropy = std::max(max_entropy, entropy);
+}
+
+void RollupStats::merge(const RollupStats& other) {
+    files += other.files;
+    bytes += other.bytes;
+    flagged += other.flagged;
+    entropy_sum += other.entropy_sum;
+    max_entropy = std::max(max_entropy, other.max_entropy);
+}
+
+SummaryAggregate::SummaryAggregate(
+    const fs::path& root,
+    size_t top_k,
+    size_t max_groups,
+    size_t dir_depth
+) : root_(root), top_k_(top_k), max_groups_(std::max<size_t>(max_groups, 1)),
+    dir_depth_(std::max<size_t>(dir_depth, 1)) {}
+
+std::string SummaryAggregate::directory_key(const fs::path& path) const {
+    fs::path parent = path.parent_path().lexically_relative(root_);
+    if (parent.empty() || *parent.begin() == "..") {
+        return ".";  // the root itself, or a single-file scan
+    }
+    fs::path key;
+    size_t depth = 0;
+    for (const fs::path& part : parent) {
+        if (depth++ == dir_depth_) break;
+        key /= part;
+    }
+    return key.string();
+}
+
+void SummaryAggregate::add_to_group(
+    std::map<std::string, RollupStats>& groups,
+    const std::string& key,
+    const RollupStats& stats
+) {
+    auto it = groups.find(key);
+    if (it == groups.end()) {
+        // one slot stays reserved for "(other)"
+        bool full = groups.size() + 1 >= max_groups_ && key != kOtherGroup;
+        it = groups.emplace(full ? kOtherGroup : key, RollupStats{}).first;
+    }
+    it->second.merge(stats);
+}
+
+void SummaryAggregate::push_top(double entropy, uint64_t size, const std::string& path) {
+    if (top_k_ == 0) return;
+    TopFile file{entropy, size, path};
+    if (top_.size() < top_k_) {
+        top_.push_back(std::move(file));
+        std::push_heap(top_.begin(), top_.end(), TopFileGreater{});
+    } else if (TopFileGreater{}(file, top_.front())) {
+        std::pop_heap(top_.begin(), top_.end(), TopFileGreater{});
+        top_.back() = std::move(file);
+        std::push_heap(top_.begin(), top_.end(), TopFileGreater{});
+    }
+}
+
+void SummaryAggregate::add(const fs::path& path, uint64_t size, double entropy, bool flagged) {
+    RollupStats stats;
+    stats.add(size, entropy, flagged);
+    totals_.merge(stats);
+
+    size_t bin = static_cast<size_t>(entropy * kEntropyBins / 8.0);
+    histogram_[std::min(bin, kEntropyBins - 1)]++;
+
+    std::string ext = path.extension().string();
+    add_to_group(extensions_, ext.empty() ? "(none)" : ext, stats);
+    add_to_group(directories_, directory_key(path), stats);
+    push_top(entropy, size, path.string());
+}
+
+void SummaryAggregate::add_error() {
+    errors_++;
+}
+
+void SummaryAggregate::merge(const SummaryAggregate& other) {
+    totals_.merge(other.totals_);
+    errors_ += other.errors_;
+    for (size_t i = 0; i < kEntropyBins; ++i) {
+        histogram_[i] += other.histogram_[i];
+    }
+    for (const auto& [key, stats] : other.extensions_) {
+        add_to_group(extensions_, key, stats);
+    }
+    for (const auto& [key, stats] : other.directories_) {
+        add_to_group(directories_, key, stats);
+    }
+    for (const TopFile& file : other.top_) {
+        push_top(file.entropy, file.size, file.path);
+    }
+}
+
+uint64_t SummaryAggregate::get_file_count() const {
+    return totals_.files;
+}
+
+json SummaryAggregate::to_state() const {
+    json state;
+    state["totals"] = rollup_to_state(totals_);
+    state["errors"] = errors_;
+    state["histogram"] = histogram_;
+    json extensions = json::object();
+    for (const auto& [key, stats] : extensions_) extensions[key] = rollup_to_state(stats);
+    state["extensions"] = std::move(extensions);
+    json directories = json::object();
+    for (const auto& [key, stats] : directories_) directories[key] = rollup_to_state(stats);
+    state["directories"] = std::move(directories);
+    json top = json::array();
+    for (const TopFile& file : top_) top.push_back({file.entropy, file.size, file.path});
+    state["top"] = std::move(top);
+    return state;
+}
+
+void SummaryAggregate::load_state(const json& state) {
+    totals_ = rollup_from_state(state.at("totals"));
+    errors_ = state.at("errors").get<uint64_t>();
+    histogram_ = state.at("histogram").get<std::array<uint64_t, kEntropyBins>>();
+    extensions_.clear();
+    for (const auto& [key, stats] : state.at("extensions").items()) {
+        extensions_[key] = rollup_from_state(stats);
+    }
+    directories_.clear();
+    for (const auto& [key, stats] : state.at("directories").items()) {
+        directories_[key] = rollup_from_state(stats);
+    }
+    top_.clear();
+    for (const json& file : state.at("top")) {
+        push_top(file.at(0).get<double>(), file.at(1).get<uint64_t>(), file.at(2).get<std::string>());
+    }
+}
+
+json SummaryAggregate::to_json(double threshold) const {
+    json report;
+    report["type"] = "summary";
+    report["threshold"] = threshold;
+    report["files"] = totals_.files;
+    report["bytes"] = totals_.bytes;
+    report["flagged"] = totals_.flagged;
+    report["errors"] = errors_;
+    report["mean_entropy"] = totals_.files ? totals_.entropy_sum / totals_.files : 0.0;
+
+    json histogram;
+    histogram["bin_width"] = 8.0 / kEntropyBins;
+    histogram["counts"] = histogram_;
+    report["entropy_histogram"] = std::move(histogram);
+
+    json extensions = json::object();
+    for (const auto& [key, stats] : extensions_) extensions[key] = rollup_to_json(stats);
+    report["extensions"] = std::move(extensions);
+
+    json directories = json::object();
+    for (const auto& [key, stats] : directories_) directories[key] = rollup_to_json(stats);
+    report["directories"] = std::move(directories);
+
+    std::vector<TopFile> top = top_;
+    std::sort(top.begin(), top.end(), TopFileGreater{});
+    json top_files = json::array();
+    for (const TopFile& file : top) {
+        top_files.push_back({{"path", file.path}, {"entropy", file.entropy}, {"size", file.size}});
+    }
+    report["top_files"] = std::move(top_files);
+    return report;
+}
@@ -0,0 +1,140 @@
+#ifndef SUMMARY_AGGREGATE_HPP
+#define SUMMARY_AGGREGATE_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+
+/**
+ * @struct RollupStats
+ * @brief Totals for a group of files (one extension or one directory).
+ */
+struct RollupStats {
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+    uint64_t flagged = 0;      // files that met the threshold
+    double entropy_sum = 0.0;  // for the mean
+    double max_entropy = 0.0;
+
+    void add(uint64_t size, double entropy, bool is_flagged);
+    void merge(const RollupStats& other);
+};
+
+/**
+ * @class SummaryAggregate
+ * @brief Fixed-size statistics over any number of scanned files.
+ *
+ * Keeps an entropy histogram across files, per-extension and per-directory
+ * rollups, and the top-K highest-entropy files in a bounded heap. Memory and
+ * output size do not grow with the number of files: each rollup holds at
+ * most max_groups keys, and files in further groups are counted under
+ * "(other)".
+ *
+ * Aggregates built by separate workers over disjoint files can be combined
+ * with merge().
+ */
+class SummaryAggregate {
+public:
+    static constexpr size_t kEntropyBins = 64;  // 0.125 bits per byte each
+    static constexpr const char* kOtherGroup = "(other)";
+
+    /**
+     * @brief Constructs an empty aggregate.
+     *
+     * @param root The scan root; directory rollups are relative to it.
+     * @param top_k Number of highest-entropy files to keep.
+     * @param max_groups Maximum distinct keys per rollup before "(other)" is used.
+     * @param dir_depth Number of leading directory components used as the directory key.
+     */
+    explicit SummaryAggregate(
+        const fs::path& root,
+        size_t top_k = 100,
+        size_t max_groups = 1024,
+        size_t dir_depth = 1
+    );
+
+    /**
+     * @brief Records one analyzed file.
+     *
+     * @param path The file path.
+     * @param size The file size in bytes.
+     * @param entropy The file entropy.
+     * @param flagged Whether the file met the threshold (was reported).
+     */
+    void add(const fs::path& path, uint64_t size, double entropy, bool flagged);
+
+    /**
+     * @brief Records a file that could not be read.
+     */
+    void add_error();
+
+    /**
+     * @brief Adds all statistics of @p other into this aggregate.
+     *
+     * Both aggregates should use the same root, top_k and max_groups.
+     */
+    void merge(const SummaryAggregate& other);
+
+    /**
+     * @brief Returns the number of files recorded with add().
+     */
+    uint64_t get_file_count() const;
+
+    /**
+     * @brief Returns the complete internal state, for checkpoints.
+     *
+     * Unlike to_json(), nothing is rounded or dropped, so an aggregate
+     * restored with load_state() continues exactly where this one stands.
+     */
+    nlohmann::json to_state() const;
+
+    /**
+     * @brief Replaces the statistics with a state returned by to_state().
+     *
+     * The root, top_k and max_groups of this aggregate are kept.
+     *
+     * @throws nlohmann::json::exception if @p state is malformed.
+     */
+    void load_state(const nlohmann::json& state);
+
+    /**
+     * @brief Serializes the aggregate into a summary report object.
+     *
+     * @param threshold The entropy threshold used for flagging, recorded in the report.
+     */
+    nlohmann::json to_json(double threshold) const;
+
+private:
+    void add_to_group(std::map<std::string, RollupStats>& groups, const std::string& key,
+                      const RollupStats& stats);
+    void push_top(double entropy, uint64_t size, const std::string& path);
+    std::string directory_key(const fs::path& path) const;
+
+    fs::path root_;
+    size_t top_k_;
+    size_t max_groups_;
+    size_t dir_depth_;
+
+    RollupStats totals_;
+    uint64_t errors_ = 0;
+    std::array<uint64_t, kEntropyBins> histogram_{};
+    std::map<std::string, RollupStats> extensions_;
+    std::map<std::string, RollupStats> directories_;
+
+    struct TopFile {
+        double entropy;
+        uint64_t size;
+        std::string path;
+    };
+    std::vector<TopFile> top_;  // min-heap on entropy, at most top_k_ entries
+};
+
+#endif // SUMMARY_AGGREGATE_HPP
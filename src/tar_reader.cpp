@@ -0,0 +1,302 @@
+#include "tar_reader.hpp"
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+namespace {
+
+    // header field offsets and lengths (POSIX ustar)
+    constexpr size_t kNameOffset = 0, kNameLength = 100;
+    constexpr size_t kSizeOffset = 124, kSizeLength = 12;
+    constexpr size_t kChecksumOffset = 148, kChecksumLength = 8;
+    constexpr size_t kTypeOffset = 156;
+    constexpr size_t kLinkOffset = 157, kLinkLength = 100;
+    constexpr size_t kMagicOffset = 257;
+    constexpr size_t kPrefixOffset = 345, kPrefixLength = 155;
+
+    // long names and pax headers are read into memory; anything larger is not a name
+    constexpr uint64_t kMaxHeaderText = 1 << 20;
+
+    std::string field_string(const unsigned char* block, size_t offset, size_t length) {
+        const char* start = reinterpret_cast<const char*>(block + offset);
+        return std::string(start, strnlen(start, length));
+    }
+
+    // octal, space or NUL terminated; or GNU base-256 when the high bit is set
+    std::optional<uint64_t> field_number(const unsigned char* block, size_t offset, size_t length) {
+        const unsigned char* field = block + offset;
+        uint64_t value = 0;
+        if (field[0] & 0x80) {
+            if (field[0] != 0x80) {
+                return std::nullopt;  // negative or wider than 64 bits
+            }
+            for (size_t i = 1; i < length; ++i) {
+                if (value >> 56) return std::nullopt;
+                value = (value << 8) | field[i];
+            }
+            return value;
+        }
+        size_t i = 0;
+        while (i < length && field[i] == ' ') ++i;
+        bool digits = false;
+        for (; i < length && field[i] >= '0' && field[i] <= '7'; ++i) {
+            if (value >> 61) return std::nullopt;
+            value = value * 8 + (field[i] - '0');
+            digits = true;
+        }
+        if (!digits || (i < length && field[i] != ' ' && field[i] != '\0')) {
+            return std::nullopt;
+        }
+        return value;
+    }
+
+    bool checksum_matches(const unsigned char* block) {
+        std::optional<uint64_t> stored = field_number(block, kChecksumOffset, kChecksumLength);
+        if (!stored) {
+            return false;
+        }
+        // the checksum field itself counts as spaces; some old tars summed signed bytes
+        uint64_t unsigned_sum = 0;
+        int64_t signed_sum = 0;
+        for (size_t i = 0; i < TarReader::kBlockSize; ++i) {
+            bool in_field = i >= kChecksumOffset && i < kChecksumOffset + kChecksumLength;
+            unsigned char byte = in_field ? ' ' : block[i];
+            unsigned_sum += byte;
+            signed_sum += static_cast<signed char>(byte);
+        }
+        return *stored == unsigned_sum || static_cast<int64_t>(*stored) == signed_sum;
+    }
+
+    uint64_t padding_after(uint64_t size) {
+        return (TarReader::kBlockSize - size % TarReader::kBlockSize) % TarReader::kBlockSize;
+    }
+
+} // namespace
+
+TarReader::TarReader(ByteSource& source)
+    : source_(source) {}
+
+bool TarReader::is_header(const unsigned char* block) {
+    return std::memcmp(block + kMagicOffset, "ustar", 5) == 0 && checksum_matches(block);
+}
+
+bool TarReader::fail(const std::string& message) {
+    error_message_ = message;
+    done_ = true;
+    return false;
+}
+
+bool TarReader::read_block(unsigned char* block, bool& end) {
+    end = false;
+    size_t got = 0;
+    if (!source_.read(block, kBlockSize, got)) {
+        return fail(source_.get_error_message());
+    }
+    if (got == 0) {
+        // no end-of-archive marker after a complete member (skips check the
+        // member's data is all there); tolerated like GNU tar does
+        end = true;
+        return true;
+    }
+    if (got < kBlockSize) {
+        return fail("Truncated tar header at offset " + std::to_string(offset_));
+    }
+    offset_ += kBlockSize;
+    return true;
+}
+
+bool TarReader::read_text(uint64_t size, std::string& text) {
+    if (size > kMaxHeaderText) {
+        return fail("Oversized tar extended header at offset " + std::to_string(offset_));
+    }
+    text.resize(static_cast<size_t>(size));
+    size_t got = 0;
+    if (!source_.read(reinterpret_cast<unsigned char*>(text.data()), text.size(), got)) {
+        return fail(source_.get_error_message());
+    }
+    if (got < text.size() || !source_.skip(padding_after(size))) {
+        return fail("Truncated tar extended header at offset " + std::to_string(offset_));
+    }
+    offset_ += size + padding_after(size);
+    return true;
+}
+
+bool TarReader::next(TarMember& member) {
+    if (done_) {
+        return false;
+    }
+    if (!source_.skip(remaining_ + padding_)) {
+        return fail("Truncated tar archive at offset " + std::to_string(offset_));
+    }
+    offset_ += remaining_ + padding_;
+    remaining_ = 0;
+    padding_ = 0;
+
+    // extended names and sizes apply to the header that follows them
+    std::optional<std::string> long_name;
+    std::optional<std::string> long_link;
+    std::optional<std::string> pax_path;
+    std::optional<std::string> pax_link;
+    std::optional<uint64_t> pax_size;
+    bool pax_sparse = false;
+    unsigned char block[kBlockSize];
+    while (true) {
+        bool end = false;
+        if (!read_block(block, end)) {
+            return false;
+        }
+        if (end || std::all_of(block, block + kBlockSize, [](unsigned char b) { return b == 0; })) {
+            done_ = true;  // end of archive
+            return false;
+        }
+        uint64_t header_offset = offset_ - kBlockSize;
+        std::optional<uint64_t> size = field_number(block, kSizeOffset, kSizeLength);
+        if (!checksum_matches(block) || !size) {
+            return fail("Bad tar header at offset " + std::to_string(header_offset));
+        }
+
+        char type = static_cast<char>(block[kTypeOffset]);
+        if (type == 'L') {
+            std::string text;
+            if (!read_text(*size, text)) return false;
+            long_name = text.substr(0, text.find('\0'));
+            continue;
+        }
+        if (type == 'K') {
+            std::string text;
+            if (!read_text(*size, text)) return false;
+            long_link = text.substr(0, text.find('\0'));
+            continue;
+        }
+        if (type == 'x') {
+            std::string text;
+            if (!read_text(*size, text)) return false;
+            // records are "<length> <key>=<value>\n", the length counting the whole record
+            for (size_t pos = 0; pos < text.size();) {
+                size_t space = text.find(' ', pos);
+                size_t length = 0;
+                for (size_t i = pos; space != std::string::npos && i < space; ++i) {
+                    length = text[i] >= '0' && text[i] <= '9' ? length * 10 + (text[i] - '0') : 0;
+                    if (length > text.size()) break;
+                }
+                if (space == std::string::npos || length <= space - pos + 1
+                    || pos + length > text.size() || text[pos + length - 1] != '\n') {
+                    return fail("Malformed pax header at offset " + std::to_string(header_offset));
+                }
+                std::string record = text.substr(space + 1, pos + length - space - 2);
+                size_t equals = record.find('=');
+                std::string key = record.substr(0, equals);
+                std::string value = equals == std::string::npos ? "" : record.substr(equals + 1);
+                if (key == "path" || key == "GNU.sparse.name") {
+                    pax_path = value;  // a sparse file's own name hides behind a made-up one
+                } else if (key == "linkpath") {
+                    pax_link = value;
+                } else if (key == "size") {
+                    uint64_t parsed = 0;
+                    bool valid = !value.empty() && value.size() <= 19;
+                    for (char c : value) {
+                        valid = valid && c >= '0' && c <= '9';
+                        parsed = parsed * 10 + static_cast<uint64_t>(c - '0');
+                    }
+                    if (!valid) {
+                        return fail("Malformed pax size at offset " + std::to_string(header_offset));
+                    }
+                    pax_size = parsed;
+                }
+                if (key.rfind("GNU.sparse.", 0) == 0) {
+                    pax_sparse = true;
+                }
+                pos += length;
+            }
+            continue;
+        }
+        if (pax_size) {
+            size = pax_size;
+        }
+
+        TarMember::Kind kind = TarMember::Kind::File;
+        if (type == '1') {
+            kind = TarMember::Kind::HardLink;
+        } else if (type == 'S' || pax_sparse) {
+            kind = TarMember::Kind::Sparse;
+        } else if (type != '0' && type != '\0' && type != '7') {
+            // nothing to analyze (directory, symbolic link, device, global header, ...)
+            if (!source_.skip(*size + padding_after(*size))) {
+                return fail("Truncated tar archive at offset " + std::to_string(offset_));
+            }
+            offset_ += *size + padding_after(*size);
+            long_name.reset();
+            long_link.reset();
+            pax_path.reset();
+            pax_link.reset();
+            pax_size.reset();
+            pax_sparse = false;
+            continue;
+        }
+
+        if (pax_path) {
+            member.path = *pax_path;
+        } else if (long_name) {
+            member.path = *long_name;
+        } else {
+            member.path = field_string(block, kNameOffset, kNameLength);
+            std::string prefix = field_string(block, kPrefixOffset, kPrefixLength);
+            if (std::memcmp(block + kMagicOffset, "ustar\0", 6) == 0 && !prefix.empty()) {
+                member.path = prefix + "/" + member.path;  // POSIX only; GNU uses the field otherwise
+            }
+        }
+        if (member.path.rfind("./", 0) == 0) {
+            member.path.erase(0, 2);
+        }
+        member.size = *size;
+        member.kind = kind;
+        member.link_target.clear();
+        if (kind == TarMember::Kind::HardLink) {
+            member.link_target = pax_link ? *pax_link
+                : long_link ? *long_link : field_string(block, kLinkOffset, kLinkLength);
+            if (member.link_target.rfind("./", 0) == 0) {
+                member.link_target.erase(0, 2);
+            }
+        }
+        // only regular files are read; the data of the others is skipped by the next call
+        remaining_ = kind == TarMember::Kind::File ? *size : 0;
+        padding_ = *size - remaining_ + padding_after(*size);
+        return true;
+    }
+}
+
+bool TarReader::read(unsigned char* buffer, size_t length, size_t& bytes_read) {
+    bytes_read = 0;
+    size_t want = static_cast<size_t>(std::min<uint64_t>(length, remaining_));
+    if (want == 0) {
+        return true;
+    }
+    if (!source_.read(buffer, want, bytes_read)) {
+        return fail(source_.get_error_message());
+    }
+    remaining_ -= bytes_read;
+    offset_ += bytes_read;
+    if (bytes_read < want) {
+        return fail("Truncated tar archive at offset " + std::to_string(offset_));
+    }
+    return true;
+}
+
+bool TarReader::skip(uint64_t length) {
+    uint64_t within = std::min(length, remaining_);
+    if (!source_.skip(within)) {
+        return fail("Truncated tar archive at offset " + std::to_string(offset_));
+    }
+    remaining_ -= within;
+    offset_ += within;
+    // past the end of the member: the member is short, not this archive
+    return within == length;
+}
+
+uint64_t TarReader::get_offset() const {
+    return offset_;
+}
+
+const std::string& TarReader::get_error_message() const {
+    return error_message_;
+}
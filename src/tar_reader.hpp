@@ -0,0 +1,104 @@
+#ifndef TAR_READER_HPP
+#define TAR_READER_HPP
+
+#include "byte_source.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @struct TarMember
+ * @brief A regular file stored in a tar archive, or a hard link or sparse file.
+ */
+struct TarMember {
+    enum class Kind {
+        File,      // data follows the header
+        HardLink,  // no data of its own; shares that of link_target
+        Sparse     // GNU sparse file, stored without its holes; not readable here
+    };
+
+    std::string path;  // member path, without a leading "./"
+    uint64_t size = 0;
+    Kind kind = Kind::File;
+    std::string link_target;  // hard links: the path of the member they share data with
+};
+
+/**
+ * @class TarReader
+ * @brief Streams the regular-file members of a tar archive from a ByteSource.
+ *
+ * Understands POSIX ustar headers (with the name prefix field), GNU long
+ * names ('L' records), pax extended headers ('x' records with path and
+ * size) and GNU base-256 sizes for members of 8 GiB and more. Hard links
+ * (with GNU long link names and pax linkpath records) and GNU sparse files
+ * are returned with their kind but no data to read. Directories, symbolic
+ * links, devices and other entries are skipped, as are pax global headers.
+ *
+ * The archive is read strictly front to back: next() moves to the next
+ * regular member, and read() returns that member's bytes, so the reader is
+ * itself a ByteSource and can feed a nested TarReader. Nothing is buffered
+ * beyond one 512-byte header.
+ */
+class TarReader : public ByteSource {
+public:
+    static constexpr size_t kBlockSize = 512;
+
+    /**
+     * @brief Constructs a reader over @p source, positioned before the first member.
+     */
+    explicit TarReader(ByteSource& source);
+
+    /**
+     * @brief Moves to the next member, skipping what is left of the current one.
+     *
+     * @return true if @p member was filled; false at the end of the archive
+     *         (get_error_message() empty) or on a malformed or truncated
+     *         archive (get_error_message() set).
+     */
+    bool next(TarMember& member);
+
+    /**
+     * @brief Reads the current member's bytes; comes up short at the end of the member.
+     */
+    bool read(unsigned char* buffer, size_t length, size_t& bytes_read) override;
+
+    /**
+     * @brief Skips bytes of the current member.
+     *
+     * @return false if the member ends first (get_error_message() stays
+     *         empty: the archive itself is intact) or the archive is truncated.
+     */
+    bool skip(uint64_t length) override;
+
+    const std::string& get_error_message() const override;
+
+    /**
+     * @brief Returns how far into the archive the reader is.
+     *
+     * Straight after next() this is where the member's data starts; after
+     * the end of the archive, where the end-of-archive marker ends.
+     */
+    uint64_t get_offset() const;
+
+    /**
+     * @brief Checks whether @p block (512 bytes) is a ustar or GNU tar header.
+     *
+     * Requires the ustar magic and a valid header checksum, so ordinary data
+     * is not mistaken for an archive.
+     */
+    static bool is_header(const unsigned char* block);
+
+private:
+    bool read_block(unsigned char* block, bool& end);
+    bool read_text(uint64_t size, std::string& text);
+    bool fail(const std::string& message);
+
+    ByteSource& source_;
+    uint64_t remaining_ = 0;  // unread bytes of the current member
+    uint64_t padding_ = 0;    // bytes up to the next header after the member
+    uint64_t offset_ = 0;     // position in the archive, for error messages
+    bool done_ = false;
+    std::string error_message_;
+};
+
+#endif // TAR_READER_HPP
@@ -0,0 +1,62 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t workers, size_t max_queued)
+    : max_queued_(std::max<size_t>(max_queued, 1)) {
+    workers = std::max<size_t>(workers, 1);
+    workers_.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    not_empty_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return queue_.size() < max_queued_; });
+    queue_.push_back(std::move(task));
+    lock.unlock();
+    not_empty_.notify_one();
+}
+
+void ThreadPool::wait_idle() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queue_.empty() && running_ == 0; });
+}
+
+size_t ThreadPool::size() const {
+    return workers_.size();
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    for (;;) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+        if (queue_.empty()) {
+            return;  // stopping and fully drained
+        }
+        Task task = std::move(queue_.front());
+        queue_.pop_front();
+        ++running_;
+        lock.unlock();
+        not_full_.notify_one();
+
+        task(index);
+
+        lock.lock();
+        --running_;
+        if (queue_.empty() && running_ == 0) {
+            idle_.notify_all();
+        }
+    }
+}
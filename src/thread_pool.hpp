@@ -0,0 +1,74 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed-size worker pool with a bounded task queue.
+ *
+ * Tasks receive the index of the worker running them, so callers can keep
+ * per-worker state (such as a FileAnalyzer) in a vector indexed by worker.
+ *
+ * submit() blocks while the queue is full, which propagates backpressure to
+ * producers instead of letting the queue grow without bound.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void(size_t worker)>;
+
+    /**
+     * @brief Starts @p workers threads sharing a queue of at most @p max_queued tasks.
+     *
+     * @param workers Number of worker threads; at least one is started.
+     * @param max_queued Maximum number of queued (not yet running) tasks;
+     *                   at least one.
+     */
+    ThreadPool(size_t workers, size_t max_queued);
+
+    /**
+     * @brief Runs all queued tasks to completion and joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queues a task, blocking while the queue is full.
+     *
+     * @param task The task to run on some worker.
+     */
+    void submit(Task task);
+
+    /**
+     * @brief Blocks until the queue is empty and no task is running.
+     */
+    void wait_idle();
+
+    /**
+     * @brief Returns the number of worker threads.
+     */
+    size_t size() const;
+
+private:
+    void worker_loop(size_t index);
+
+    std::vector<std::thread> workers_;
+    std::deque<Task> queue_;
+    size_t max_queued_;
+    size_t running_ = 0;
+    bool stopping_ = false;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::condition_variable idle_;
+};
+
+#endif // THREAD_POOL_HPP
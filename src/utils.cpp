@@ -1,4 +1,7 @@
 #include <utils.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
 #include <filesystem>
 #include <system_error>
 #include <vector>
@@ -9,6 +12,17 @@ namespace utils {
 
 std::vector<fs::path> collect_files(const fs::path& root, bool recursive, const std::string& extension) {
     std::vector<fs::path> out;
+    for_each_file(root, recursive, extension, [&out](const fs::path& path) {
+        out.push_back(path);
+    });
+    // directory order differs between filesystems and hosts; reports and
+    // shard positions must not
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+void for_each_file(const fs::path& root, bool recursive, const std::string& extension,
+                   const std::function<void(const fs::path&)>& visit) {
     std::error_code ec;
 
     if (!fs::exists(root, ec)) {
@@ -16,7 +30,7 @@ std::vector<fs::path> collect_files(const fs::path& root, bool recursive, const
     }
     if (fs::is_regular_file(root, ec)) {
         if (extension.empty() || root.extension() == extension) {
-            out.push_back(root);
+            visit(root);
         }
     }
     else if (fs::is_directory(root, ec)) {
@@ -26,7 +40,7 @@ std::vector<fs::path> collect_files(const fs::path& root, bool recursive, const
                     fs::directory_options::skip_permission_denied, ec)) {
                 if (!ec && entry.is_regular_file(ec))
                     if (extension.empty() || entry.path().extension() == extension) {
-                        out.push_back(entry.path());
+                        visit(entry.path());
                     }
             }
             ec.clear();
@@ -35,7 +49,7 @@ std::vector<fs::path> collect_files(const fs::path& root, bool recursive, const
                     fs::directory_options::skip_permission_denied, ec)) {
                 if (!ec && entry.is_regular_file(ec))
                     if (extension.empty() || entry.path().extension() == extension) {
-                        out.push_back(entry.path());
+                        visit(entry.path());
                     }
             }
             ec.clear();
@@ -44,8 +58,31 @@ std::vector<fs::path> collect_files(const fs::path& root, bool recursive, const
     else {
         throw std::invalid_argument(root.string() + " is neither file nor directory");
     }
+}
 
-    return out;
+bool parse_size(const std::string& text, uint64_t& bytes) {
+    uint64_t value = 0;
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    auto [ptr, ec] = std::from_chars(begin, end, value);
+    if (ec != std::errc() || ptr == begin) {
+        return false;
+    }
+    int shift = 0;
+    if (ptr != end) {
+        switch (*ptr++) {
+            case 'k': case 'K': shift = 10; break;
+            case 'm': case 'M': shift = 20; break;
+            case 'g': case 'G': shift = 30; break;
+            case 't': case 'T': shift = 40; break;
+            default: return false;
+        }
+    }
+    if (ptr != end || (shift > 0 && value > (UINT64_MAX >> shift))) {
+        return false;
+    }
+    bytes = value << shift;
+    return true;
 }
 
 std::string make_report_filename(const std::string& prefix) {
@@ -1,6 +1,7 @@
 #pragma once
 #include <vector>
 #include <filesystem>
+#include <functional>
 #include <nlohmann/json.hpp>
 
 namespace fs = std::filesystem;
@@ -13,10 +14,38 @@ namespace utils {
      * @param root      the file or directory to scan
      * @param recursive if true, descend into subdirs
      * @throws std::invalid_argument if `root` doesn’t exist or isn’t a file/dir
-     * @returns a flat vector of all regular files found
+     * @returns a flat vector of all regular files found, sorted by path so the
+     *          order does not depend on the filesystem's directory order
      */
     std::vector<fs::path> collect_files(const fs::path& root, bool recursive, const std::string& extension = ""); 
+
+    /**
+     * @brief Calls `visit` for each file collect_files() would return, without
+     *        materializing the list.
+     *
+     * Memory use stays constant however many files the tree holds. Files are
+     * visited in directory order, not sorted.
+     *
+     * @param root      the file or directory to scan
+     * @param recursive if true, descend into subdirs
+     * @param extension only visit files with this extension, if non-empty
+     * @param visit     called once per regular file found
+     * @throws std::invalid_argument if `root` doesn’t exist or isn’t a file/dir
+     */
+    void for_each_file(const fs::path& root, bool recursive, const std::string& extension,
+                       const std::function<void(const fs::path&)>& visit);
     
+    /**
+     * @brief Parses a byte count such as "1048576", "64K", "512M" or "2G".
+     *
+     * Suffixes are binary (K = 1024) and case-insensitive.
+     *
+     * @param text  the text to parse
+     * @param bytes receives the value on success
+     * @returns true if `text` was a valid size
+     */
+    bool parse_size(const std::string& text, uint64_t& bytes);
+
     /*
     @brief Creates a JSON output report filename from prefix, with timestamp
     @param prefix the prefix for the report filename
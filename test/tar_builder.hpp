@@ -0,0 +1,65 @@
+#ifndef TAR_BUILDER_HPP
+#define TAR_BUILDER_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Builds tar archives in memory for the archive tests.
+ */
+namespace tar_builder {
+
+    // a ustar header (or GNU, with the "ustar  " magic) with a valid checksum
+    inline std::string header(const std::string& name, uint64_t size, char type = '0',
+                              const std::string& prefix = "", bool gnu = false,
+                              const std::string& link = "") {
+        std::string block(512, '\0');
+        block.replace(0, std::min<size_t>(name.size(), 100), name.substr(0, 100));
+        block.replace(100, 7, "0000644");
+        char octal[13];
+        std::snprintf(octal, sizeof(octal), "%011llo", static_cast<unsigned long long>(size));
+        block.replace(124, 11, octal);
+        block[156] = type;
+        block.replace(157, std::min<size_t>(link.size(), 100), link.substr(0, 100));
+        block.replace(257, 8, gnu ? std::string("ustar  \0", 8) : std::string("ustar\0" "00", 8));
+        block.replace(345, prefix.size(), prefix);
+        block.replace(148, 8, "        ");
+        unsigned sum = 0;
+        for (unsigned char c : block) sum += c;
+        std::snprintf(octal, sizeof(octal), "%06o", sum);
+        block.replace(148, 7, std::string(octal, 6) + '\0');
+        return block;
+    }
+
+    inline std::string padded(const std::string& data) {
+        return data + std::string((512 - data.size() % 512) % 512, '\0');
+    }
+
+    inline std::string entry(const std::string& name, const std::string& data, char type = '0') {
+        return header(name, data.size(), type) + padded(data);
+    }
+
+    inline std::string hard_link(const std::string& name, const std::string& target) {
+        return header(name, 0, '1', "", false, target);
+    }
+
+    inline std::string end_marker() {
+        return std::string(1024, '\0');
+    }
+
+    // regular members in order, then the end marker
+    inline std::string archive(const std::vector<std::pair<std::string, std::string>>& members) {
+        std::string out;
+        for (const auto& [name, data] : members) {
+            out += entry(name, data);
+        }
+        return out + end_marker();
+    }
+
+} // namespace tar_builder
+
+#endif // TAR_BUILDER_HPP
@@ -0,0 +1,308 @@
+#include <gtest/gtest.h>
+#include "archive_scanner.hpp"
+#include "tar_builder.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+using namespace tar_builder;
+
+namespace {
+
+    std::string noisy(size_t size, unsigned seed) {
+        std::string data(size, '\0');
+        for (size_t i = 0; i < size; ++i) {
+            seed = seed * 1103515245 + 12345;
+            data[i] = static_cast<char>(i % 3000 < 1500 ? seed >> 16 : 'k');
+        }
+        return data;
+    }
+
+} // namespace
+
+class ArchiveScannerTest : public ::testing::Test {
+protected:
+    fs::path temp_dir;
+    ScanOptions options;
+
+    void SetUp() override {
+        temp_dir = fs::temp_directory_path() / "entropix_test_archive";
+        fs::create_directories(temp_dir);
+        options.block_size = 512;
+        options.entropy_threshold = 7.0;
+    }
+
+    void TearDown() override {
+        fs::remove_all(temp_dir);
+    }
+
+    std::string write(const std::string& name, const std::string& bytes) {
+        fs::path path = temp_dir / name;
+        std::ofstream(path, std::ios::binary) << bytes;
+        return path.string();
+    }
+};
+
+TEST_F(ArchiveScannerTest, MembersMatchAnalysisOfTheirBytes) {
+    // test that each member is reported as archive!member with offsets relative to the member
+    std::string a = noisy(9000, 1);
+    std::string b = noisy(70000, 2);  // past the small-file limit
+    std::string path = write("evidence.tar", archive({{"a.bin", a}, {"dir/b.bin", b}}));
+
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> paths;
+    std::vector<nlohmann::json> entries;
+    bool is_archive = false;
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer& member_analyzer) {
+        paths.push_back(member);
+        entries.push_back(member_analyzer.has_entry() ? member_analyzer.get_entry() : nlohmann::json());
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_TRUE(is_archive);
+    ASSERT_EQ(paths, (std::vector<std::string>{path + "!a.bin", path + "!dir/b.bin"}));
+
+    FileAnalyzer expected;
+    expected.analyze_buffer(path + "!a.bin", reinterpret_cast<const unsigned char*>(a.data()), a.size(), options);
+    EXPECT_EQ(entries[0], expected.get_entry());
+    expected.analyze_buffer(path + "!dir/b.bin", reinterpret_cast<const unsigned char*>(b.data()), b.size(), options);
+    EXPECT_EQ(entries[1], expected.get_entry());
+}
+
+TEST_F(ArchiveScannerTest, NestedArchivesAreScannedRecursively) {
+    // test that a tar member holding a tar is opened too, with both names in the path
+    std::string inner = archive({{"secret.bin", noisy(4000, 3)}});
+    std::string path = write("outer.tar", archive({{"notes.txt", "plain text"}, {"inner.tar", inner}}));
+
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> paths;
+    bool is_archive = false;
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer&) {
+        paths.push_back(member);
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_EQ(paths, (std::vector<std::string>{path + "!notes.txt", path + "!inner.tar!secret.bin"}));
+}
+
+TEST_F(ArchiveScannerTest, OrdinaryFileIsNotAnArchive) {
+    // test that a non-tar file is analyzed whole, as FileAnalyzer::analyze() would
+    std::string path = write("plain.bin", noisy(3000, 4));
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    bool called = false;
+    bool is_archive = true;
+    EXPECT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string&, FileAnalyzer&) { called = true; },
+                             is_archive));
+    EXPECT_FALSE(is_archive);
+    EXPECT_FALSE(called);
+    EXPECT_EQ(analyzer.get_file_size(), 3000u);
+    FileAnalyzer expected;
+    ASSERT_TRUE(expected.analyze(path, options));
+    EXPECT_EQ(analyzer.get_file_entropy(), expected.get_file_entropy());
+    EXPECT_EQ(analyzer.has_entry(), expected.has_entry());
+}
+
+TEST_F(ArchiveScannerTest, TruncatedArchiveKeepsEarlierMembers) {
+    // test that members before a truncation are reported, then the error and the whole file as plain data
+    std::string full = archive({{"first.bin", noisy(2000, 5)}, {"second.bin", noisy(5000, 6)}});
+    std::string path = write("cut.tar", full.substr(0, 512 * 6));
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> paths;
+    bool is_archive = true;
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer&) {
+        paths.push_back(member);
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_FALSE(is_archive);
+    EXPECT_EQ(paths, std::vector<std::string>{path + "!first.bin"});
+    ASSERT_EQ(scanner.get_member_errors().size(), 1u);
+    EXPECT_EQ(scanner.get_member_errors()[0].rfind(path + ": Truncated", 0), 0u);
+    EXPECT_EQ(analyzer.get_file_size(), 512u * 6);
+}
+
+TEST_F(ArchiveScannerTest, DamagedNestedArchiveDoesNotStopTheOuterOne) {
+    // test that a truncated nested archive, or a member that only looks like one, is recorded and scanned as data
+    std::string cut = archive({{"ok.bin", noisy(1000, 7)}, {"lost.bin", noisy(3000, 8)}}).substr(0, 512 * 5);
+    std::string fake = header("fake.tar", 0) + std::string(512, 'x');  // header-like start, then noise
+    std::string path = write("outer.tar", archive({{"inner.tar", cut}, {"fake.tar", fake},
+                                                   {"after.bin", noisy(2000, 9)}}));
+
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> paths;
+    std::vector<nlohmann::json> entries;
+    bool is_archive = false;
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer& member_analyzer) {
+        paths.push_back(member);
+        entries.push_back(member_analyzer.has_entry() ? member_analyzer.get_entry() : nlohmann::json());
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_EQ(paths, (std::vector<std::string>{path + "!inner.tar!ok.bin", path + "!inner.tar",
+                                               path + "!fake.tar!fake.tar", path + "!fake.tar",
+                                               path + "!after.bin"}));
+    FileAnalyzer expected;
+    expected.analyze_buffer(path + "!inner.tar", reinterpret_cast<const unsigned char*>(cut.data()), cut.size(),
+                            options);
+    EXPECT_EQ(entries[1], expected.get_entry());
+    ASSERT_EQ(scanner.get_member_errors().size(), 2u);
+    EXPECT_EQ(scanner.get_member_errors()[0].rfind(path + "!inner.tar: Truncated", 0), 0u);
+    EXPECT_EQ(scanner.get_member_errors()[1].rfind(path + "!fake.tar: Bad tar header", 0), 0u);
+}
+
+TEST_F(ArchiveScannerTest, NestedArchiveSkipsNonRegularEntries) {
+    // test that directories, links and long-name records inside a nested archive are handled like at the top
+    std::string long_name(150, 'n');
+    std::string inner = header("dir/", 0, '5') + header("dir/link", 0, '2')
+        + entry("././@LongLink", long_name + '\0', 'L') + entry("short", noisy(600, 10))
+        + entry("dir/data.bin", noisy(1500, 11)) + end_marker();
+    std::string path = write("outer.tar", archive({{"inner.tar", inner}, {"tail.txt", "tail"}}));
+
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> paths;
+    bool is_archive = false;
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer& member_analyzer) {
+        paths.push_back(member);
+        if (member.find("data.bin") != std::string::npos) {
+            EXPECT_EQ(member_analyzer.get_file_size(), 1500u);
+        }
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_EQ(paths, (std::vector<std::string>{path + "!inner.tar!" + long_name, path + "!inner.tar!dir/data.bin",
+                                               path + "!tail.txt"}));
+    EXPECT_TRUE(scanner.get_member_errors().empty());
+}
+
+TEST_F(ArchiveScannerTest, ResumeSkipsReportedMembers) {
+    // test that resuming after N members reports exactly the members a full scan reports after them
+    std::string inner = archive({{"x.bin", noisy(700, 12)}, {"y.bin", noisy(800, 13)}});
+    std::string path = write("outer.tar", archive({{"a.bin", noisy(500, 14)}, {"inner.tar", inner},
+                                                   {"b.bin", noisy(70000, 15)}}));
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> all;
+    bool is_archive = false;
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer&) {
+        all.push_back(member);
+    }, is_archive));
+    ASSERT_EQ(all.size(), 4u);
+
+    std::vector<std::string> rest;
+    ASSERT_TRUE(scanner.resume(path, options, analyzer, 2, [&](const std::string& member, FileAnalyzer&) {
+        rest.push_back(member);
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_EQ(rest, std::vector<std::string>(all.begin() + 2, all.end()));
+    EXPECT_FALSE(scanner.resume(path, options, analyzer, 5, [](const std::string&, FileAnalyzer&) {}, is_archive));
+}
+
+TEST_F(ArchiveScannerTest, StopCallbackEndsTheScanBetweenMembers) {
+    // test that a stop request ends the scan after the current member with a "stopped" error
+    std::string path = write("stop.tar", archive({{"a.bin", noisy(500, 16)}, {"b.bin", noisy(500, 17)},
+                                                  {"c.bin", noisy(500, 18)}}));
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> paths;
+    scanner.set_stop_callback([&] { return paths.size() == 1; });
+    bool is_archive = false;
+    EXPECT_FALSE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer&) {
+        paths.push_back(member);
+    }, is_archive));
+    EXPECT_TRUE(is_archive);
+    EXPECT_EQ(paths, std::vector<std::string>{path + "!a.bin"});
+    EXPECT_NE(scanner.get_error_message().find("stopped"), std::string::npos);
+}
+
+TEST_F(ArchiveScannerTest, DataAfterTheEndMarkerIsScanned) {
+    // test that bytes after an end marker are reported as a trailing member, at the top and nested
+    std::string hidden = noisy(100000, 19);
+    std::string inner = archive({{"x.bin", noisy(600, 20)}}) + std::string(4096, '\0') + "appended";
+    std::string path = write("trailing.tar", archive({{"inner.tar", inner}})
+                             + std::string(9216, '\0') + std::string(300, '\0') + hidden);
+
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> paths;
+    std::vector<nlohmann::json> entries;
+    bool is_archive = false;
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer& member_analyzer) {
+        paths.push_back(member);
+        entries.push_back(member_analyzer.has_entry() ? member_analyzer.get_entry() : nlohmann::json());
+        if (member.find("inner.tar!<trailing>") != std::string::npos) {
+            EXPECT_EQ(member_analyzer.get_file_size(), 8u);
+        }
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_EQ(paths, (std::vector<std::string>{path + "!inner.tar!x.bin", path + "!inner.tar!<trailing>",
+                                               path + "!<trailing>"}));
+
+    // offsets count from the block holding the first non-zero byte
+    std::string section = std::string(300, '\0') + hidden;
+    FileAnalyzer expected;
+    expected.analyze_buffer(path + "!<trailing>", reinterpret_cast<const unsigned char*>(section.data()),
+                            section.size(), options);
+    EXPECT_EQ(entries.back(), expected.get_entry());
+
+    // zero padding alone is not trailing data
+    std::string padded_path = write("padded.tar", archive({{"x.bin", noisy(600, 21)}}) + std::string(9216, '\0'));
+    paths.clear();
+    ASSERT_TRUE(scanner.scan(padded_path, options, analyzer, [&](const std::string& member, FileAnalyzer&) {
+        paths.push_back(member);
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_EQ(paths, std::vector<std::string>{padded_path + "!x.bin"});
+}
+
+TEST_F(ArchiveScannerTest, TruncationAfterANestedEndMarkerIsAnError) {
+    // test that an outer archive cut after a nested archive's end marker is reported, not taken as complete
+    std::string inner = archive({{"x.bin", noisy(600, 22)}}) + std::string(9216, '\0');  // record padding
+    std::string full = archive({{"inner.tar", inner}, {"later.bin", noisy(2000, 23)}});
+    size_t cut = 512 + 512 + 1024 + 1024;  // outer header, x.bin, its data, the inner end marker
+    std::string path = write("cut.tar", full.substr(0, cut));
+
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> paths;
+    bool is_archive = true;
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer&) {
+        paths.push_back(member);
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_EQ(paths, std::vector<std::string>{path + "!inner.tar!x.bin"});
+    ASSERT_EQ(scanner.get_member_errors().size(), 1u);
+    EXPECT_EQ(scanner.get_member_errors()[0].rfind(path + ": Truncated", 0), 0u);
+    EXPECT_FALSE(is_archive);
+
+    // a nested entry larger than its member fails the nested archive only
+    std::string short_inner = header("dir/", 4096, '5') + header("gone.bin", 0);
+    path = write("short.tar", archive({{"inner.tar", short_inner}, {"later.bin", noisy(2000, 24)}}));
+    paths.clear();
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer&) {
+        paths.push_back(member);
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_TRUE(is_archive);
+    EXPECT_EQ(paths, (std::vector<std::string>{path + "!inner.tar", path + "!later.bin"}));
+    ASSERT_EQ(scanner.get_member_errors().size(), 1u);
+    EXPECT_EQ(scanner.get_member_errors()[0].rfind(path + "!inner.tar: Truncated", 0), 0u);
+}
+
+TEST_F(ArchiveScannerTest, HardLinksAreReportedAsTheirTarget) {
+    // test that a hard link gets its target's entry under its own name, and sparse members are errors
+    std::string data = noisy(9000, 25);
+    std::string path = write("hl.tar", entry("x.bin", data) + hard_link("y.bin", "x.bin")
+                                       + hard_link("z.bin", "missing.bin") + entry("s.bin", "stored", 'S')
+                                       + entry("after.bin", noisy(700, 26)) + end_marker());
+    ArchiveScanner scanner;
+    FileAnalyzer analyzer;
+    std::vector<std::string> paths;
+    std::vector<nlohmann::json> entries;
+    bool is_archive = false;
+    ASSERT_TRUE(scanner.scan(path, options, analyzer, [&](const std::string& member, FileAnalyzer& member_analyzer) {
+        paths.push_back(member);
+        entries.push_back(member_analyzer.has_entry() ? member_analyzer.get_entry() : nlohmann::json());
+    }, is_archive)) << scanner.get_error_message();
+    EXPECT_EQ(paths, (std::vector<std::string>{path + "!x.bin", path + "!y.bin", path + "!after.bin"}));
+    ASSERT_FALSE(entries[0].is_null());
+    nlohmann::json alias = entries[0];
+    alias["path"] = path + "!y.bin";
+    EXPECT_EQ(entries[1], alias);
+    ASSERT_EQ(scanner.get_member_errors().size(), 2u);
+    EXPECT_EQ(scanner.get_member_errors()[0], path + "!z.bin: hard link to missing.bin, which is not in the archive");
+    EXPECT_EQ(scanner.get_member_errors()[1].rfind(path + "!s.bin: GNU sparse", 0), 0u);
+}
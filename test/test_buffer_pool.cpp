@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include "buffer_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+TEST(BufferPoolTest, GrantsPreferredSizeWhenBudgetAllows) {
+    // test that an uncontended acquisition gets the preferred size, rounded to the granule
+    BufferPool pool(1 << 20);
+    BufferPool::Buffer buffer = pool.acquire(100000, 4096, 4096);
+    EXPECT_EQ(buffer.size(), 98304u);
+    EXPECT_NE(buffer.data(), nullptr);
+}
+
+TEST(BufferPoolTest, ShrinksBuffersWhenBudgetIsTight) {
+    // test that a second buffer is shrunk to what is left of the budget
+    BufferPool pool(64 * 1024);
+    BufferPool::Buffer first = pool.acquire(48 * 1024, 4096, 4096);
+    BufferPool::Buffer second = pool.acquire(48 * 1024, 4096, 4096);
+    EXPECT_EQ(first.size(), 48u * 1024);
+    EXPECT_EQ(second.size(), 16u * 1024);
+    EXPECT_LE(pool.get_peak(), pool.get_budget());
+}
+
+TEST(BufferPoolTest, BlocksUntilMemoryIsReturned) {
+    // test that an acquisition stalls while not even the minimum fits
+    BufferPool pool(8192);
+    std::atomic<bool> acquired{false};
+    BufferPool::Buffer held = pool.acquire(8192, 8192);
+    std::thread waiter([&] {
+        BufferPool::Buffer buffer = pool.acquire(4096, 4096);
+        acquired = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(acquired.load());
+    held = BufferPool::Buffer();
+    waiter.join();
+    EXPECT_TRUE(acquired.load());
+}
+
+TEST(BufferPoolTest, ReservationsShareTheBudget) {
+    // test that try_reserve() refuses what does not fit and release() returns it
+    BufferPool pool(10000);
+    EXPECT_TRUE(pool.try_reserve(6000));
+    EXPECT_FALSE(pool.try_reserve(6000));
+    pool.release(6000);
+    EXPECT_TRUE(pool.try_reserve(6000));
+}
+
+TEST(BufferPoolTest, MinimumAboveBudgetIsClamped) {
+    // test that a minimum larger than the budget cannot deadlock
+    BufferPool pool(4096);
+    BufferPool::Buffer buffer = pool.acquire(1 << 20, 1 << 20, 512);
+    EXPECT_EQ(buffer.size(), 4096u);
+}
+
+TEST(BufferPoolTest, UnlimitedPoolGrantsPreferredSize) {
+    // test that a zero budget never shrinks or blocks
+    BufferPool pool(0);
+    BufferPool::Buffer a = pool.acquire(1 << 20, 1);
+    BufferPool::Buffer b = pool.acquire(1 << 20, 1);
+    EXPECT_EQ(a.size(), 1u << 20);
+    EXPECT_EQ(b.size(), 1u << 20);
+}
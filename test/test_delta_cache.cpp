@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include "delta_cache.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+TEST(DeltaCacheTest, FingerprintDetectsChangesAndLength) {
+    // test that content and length changes alter the fingerprint
+    std::vector<unsigned char> a(100, 'A');
+    std::vector<unsigned char> b = a;
+    b[57] = 'B';
+    uint64_t fa = DeltaCache::fingerprint(a.data(), a.size());
+    EXPECT_EQ(fa, DeltaCache::fingerprint(a.data(), a.size()));
+    EXPECT_NE(fa, DeltaCache::fingerprint(b.data(), b.size()));
+    EXPECT_NE(fa, DeltaCache::fingerprint(a.data(), a.size() - 1));
+}
+
+TEST(DeltaCacheTest, SaveAndLoadRoundTrip) {
+    // test that records survive a save/load cycle
+    fs::path file = fs::temp_directory_path() / "entropix_test_delta.cache";
+    DeltaCache cache;
+    FileRecord record;
+    record.size = 600;
+    record.mtime_ns = 12345;
+    record.block_size = 512;
+    record.segment_blocks = DeltaCache::segment_blocks(512);
+    record.blocks.resize(2);
+    record.blocks[0].fingerprint = 7;
+    record.blocks[0].entropy = 3.5;
+    record.segments.resize(1);
+    record.segments[0]['A'] = 512;
+    record.segments[0]['B'] = 88;
+    cache.put("/evidence/a.bin", record);
+    ASSERT_TRUE(cache.save(file.string())) << cache.get_error_message();
+
+    DeltaCache loaded;
+    ASSERT_TRUE(loaded.load(file.string())) << loaded.get_error_message();
+    const FileRecord* found = loaded.find("/evidence/a.bin");
+    ASSERT_NE(found, nullptr);
+    EXPECT_EQ(found->size, 600);
+    EXPECT_EQ(found->mtime_ns, 12345);
+    ASSERT_EQ(found->blocks.size(), 2);
+    EXPECT_EQ(found->blocks[0].fingerprint, 7);
+    EXPECT_DOUBLE_EQ(found->blocks[0].entropy, 3.5);
+    ASSERT_EQ(found->segments.size(), 1);
+    EXPECT_EQ(found->segments[0]['B'], 88);
+    fs::remove(file);
+}
+
+TEST(DeltaCacheTest, MissingFileLoadsEmpty) {
+    // test that a first run without a cache file is not an error
+    DeltaCache cache;
+    EXPECT_TRUE(cache.load((fs::temp_directory_path() / "entropix_no_such.cache").string()));
+    EXPECT_EQ(cache.size(), 0);
+}
+
+TEST(DeltaCacheTest, RejectsCorruptFile) {
+    // test that garbage and truncated files are rejected
+    fs::path file = fs::temp_directory_path() / "entropix_test_corrupt.cache";
+    std::ofstream(file, std::ios::binary) << "definitely not a cache";
+    DeltaCache cache;
+    EXPECT_FALSE(cache.load(file.string()));
+
+    DeltaCache good;
+    FileRecord record;
+    record.size = 10;
+    record.block_size = 512;
+    record.blocks.resize(1);
+    record.segments.resize(1);
+    good.put("x", record);
+    ASSERT_TRUE(good.save(file.string()));
+    fs::resize_file(file, fs::file_size(file) - 100);
+    EXPECT_FALSE(cache.load(file.string()));
+    EXPECT_EQ(cache.size(), 0);
+    fs::remove(file);
+}
+
+namespace {
+
+    // a record for a file of @p size bytes in 512-byte blocks
+    FileRecord make_record(uint64_t size, uint64_t fingerprint) {
+        FileRecord record;
+        record.size = size;
+        record.block_size = 512;
+        record.segment_blocks = DeltaCache::segment_blocks(512);
+        record.blocks.resize((size + 511) / 512);
+        record.blocks[0].fingerprint = fingerprint;
+        record.segments.resize((record.blocks.size() + record.segment_blocks - 1) / record.segment_blocks);
+        return record;
+    }
+
+} // namespace
+
+TEST(DeltaCacheTest, HistogramsArePerSegment) {
+    // test that a 10 MiB file in 512-byte blocks needs well under a tenth of its size
+    fs::path file = fs::temp_directory_path() / "entropix_test_delta_size.cache";
+    fs::remove(file);
+    DeltaCache cache;
+    cache.put("/evidence/big.bin", make_record(10 << 20, 1));
+    ASSERT_TRUE(cache.save(file.string())) << cache.get_error_message();
+    EXPECT_EQ(DeltaCache::segment_blocks(512), 128);
+    EXPECT_EQ(DeltaCache::segment_blocks(1 << 20), 1);
+    EXPECT_LT(fs::file_size(file), (10 << 20) / 20);
+    fs::remove(file);
+}
+
+TEST(DeltaCacheTest, SaveAppendsToTheLoadedFile) {
+    // test that a rescan appends changed records instead of rewriting the file
+    fs::path file = fs::temp_directory_path() / "entropix_test_delta_append.cache";
+    fs::remove(file);
+    {
+        DeltaCache cache;
+        for (int i = 0; i < 100; ++i) {
+            cache.put("/evidence/" + std::to_string(i), make_record(1 << 20, i));
+        }
+        ASSERT_TRUE(cache.save(file.string()));
+    }
+    auto before = fs::file_size(file);
+    ino_t inode;
+    {
+        struct stat st;
+        ASSERT_EQ(::stat(file.c_str(), &st), 0);
+        inode = st.st_ino;
+    }
+
+    DeltaCache cache;
+    ASSERT_TRUE(cache.load(file.string()));
+    EXPECT_EQ(cache.size(), 100);
+    cache.put("/evidence/7", make_record(1 << 20, 700));
+    ASSERT_TRUE(cache.save(file.string()));
+    struct stat st;
+    ASSERT_EQ(::stat(file.c_str(), &st), 0);
+    EXPECT_EQ(st.st_ino, inode);
+    EXPECT_GT(fs::file_size(file), before);
+    EXPECT_LT(fs::file_size(file), before + before / 50);
+
+    DeltaCache loaded;
+    ASSERT_TRUE(loaded.load(file.string()));
+    EXPECT_EQ(loaded.size(), 100);
+    ASSERT_NE(loaded.find("/evidence/7"), nullptr);
+    EXPECT_EQ(loaded.find("/evidence/7")->blocks[0].fingerprint, 700);
+    EXPECT_EQ(loaded.find("/evidence/8")->blocks[0].fingerprint, 8);
+    fs::remove(file);
+}
+
+TEST(DeltaCacheTest, UnsavedRecordsAreIgnored) {
+    // test that records put without a save do not survive, and the file stays loadable
+    fs::path file = fs::temp_directory_path() / "entropix_test_delta_unsaved.cache";
+    fs::remove(file);
+    {
+        DeltaCache cache;
+        cache.put("/evidence/a", make_record(600, 1));
+        ASSERT_TRUE(cache.save(file.string()));
+        cache.put("/evidence/a", make_record(600, 2));
+        cache.put("/evidence/b", make_record(600, 3));
+    }
+    DeltaCache loaded;
+    ASSERT_TRUE(loaded.load(file.string())) << loaded.get_error_message();
+    EXPECT_EQ(loaded.size(), 1);
+    ASSERT_NE(loaded.find("/evidence/a"), nullptr);
+    EXPECT_EQ(loaded.find("/evidence/a")->blocks[0].fingerprint, 1);
+    fs::remove(file);
+}
+
+TEST(DeltaCacheTest, EvictsMissingFiles) {
+    // test that records of deleted files are dropped and stay dropped after a reload
+    fs::path dir = fs::temp_directory_path() / "entropix_test_delta_evict";
+    fs::create_directories(dir);
+    std::ofstream(dir / "kept.bin") << "kept";
+    fs::path file = dir / "cache";
+    {
+        DeltaCache cache;
+        cache.put((dir / "kept.bin").string(), make_record(4, 1));
+        cache.put((dir / "gone.bin").string(), make_record(4, 2));
+        ASSERT_TRUE(cache.save(file.string()));
+    }
+    {
+        DeltaCache cache;
+        ASSERT_TRUE(cache.load(file.string()));
+        EXPECT_EQ(cache.evict_missing(), 1);
+        ASSERT_TRUE(cache.save(file.string()));
+    }
+    DeltaCache loaded;
+    ASSERT_TRUE(loaded.load(file.string()));
+    EXPECT_EQ(loaded.size(), 1);
+    EXPECT_NE(loaded.find((dir / "kept.bin").string()), nullptr);
+    EXPECT_EQ(loaded.find((dir / "gone.bin").string()), nullptr);
+    fs::remove_all(dir);
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include "delta_scanner.hpp"
+#include "file_analyzer.hpp"
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class DeltaScannerTest : public ::testing::Test {
+protected:
+    fs::path file;
+
+    void SetUp() override {
+        file = fs::temp_directory_path() / "entropix_test_delta.bin";
+        write_blocks(file, 0, 8, std::ios::trunc);
+    }
+
+    void TearDown() override {
+        fs::remove(file);
+    }
+
+    // writes `count` 512-byte blocks, alternating low and high entropy
+    static void write_blocks(const fs::path& path, int first, int count, std::ios::openmode mode) {
+        std::ofstream out(path, std::ios::binary | mode);
+        for (int b = first; b < first + count; ++b) {
+            for (int i = 0; i < 512; ++i) {
+                out.put(static_cast<char>(b % 2 ? (i * 37 + b) % 256 : 'A'));
+            }
+        }
+    }
+
+    // forces a visible mtime change even on coarse-grained filesystems
+    void bump_mtime() {
+        fs::last_write_time(file, fs::last_write_time(file) + std::chrono::seconds(1));
+    }
+
+    static ScanOptions block_options() {
+        ScanOptions options;
+        options.block_size = 512;
+        options.entropy_threshold = 4.0;
+        return options;
+    }
+
+    nlohmann::json full_scan_entry() {
+        FileAnalyzer analyzer;
+        EXPECT_TRUE(analyzer.analyze(file.string(), block_options()));
+        return analyzer.has_entry() ? analyzer.get_entry() : nlohmann::json();
+    }
+};
+
+TEST_F(DeltaScannerTest, FirstScanMatchesFullScan) {
+    // test that a cold delta scan reads everything and agrees with FileAnalyzer
+    DeltaCache cache;
+    DeltaScanner scanner(cache);
+    ASSERT_TRUE(scanner.analyze(file.string(), block_options()));
+    EXPECT_EQ(scanner.get_bytes_read(), 8 * 512);
+    EXPECT_EQ(scanner.get_blocks_reused(), 0);
+    ASSERT_TRUE(scanner.has_entry());
+    EXPECT_EQ(scanner.get_entry(), full_scan_entry());
+}
+
+TEST_F(DeltaScannerTest, UnchangedFileIsNotRead) {
+    // test that an unchanged file is answered entirely from the cache
+    DeltaCache cache;
+    DeltaScanner scanner(cache);
+    ASSERT_TRUE(scanner.analyze(file.string(), block_options()));
+    ASSERT_TRUE(scanner.analyze(file.string(), block_options()));
+    EXPECT_EQ(scanner.get_bytes_read(), 0);
+    EXPECT_EQ(scanner.get_blocks_reused(), 8);
+    EXPECT_EQ(scanner.get_entry(), full_scan_entry());
+}
+
+TEST_F(DeltaScannerTest, AppendReadsOnlyTail) {
+    // test that appended data is read without re-reading the old body
+    DeltaCache cache;
+    DeltaScanner scanner(cache);
+    ASSERT_TRUE(scanner.analyze(file.string(), block_options()));
+
+    write_blocks(file, 8, 4, std::ios::app);
+    bump_mtime();
+    ASSERT_TRUE(scanner.analyze(file.string(), block_options()));
+    // two verification blocks plus the four new ones
+    EXPECT_EQ(scanner.get_bytes_read(), (2 + 4) * 512);
+    EXPECT_EQ(scanner.get_blocks_reused(), 8);
+    EXPECT_EQ(scanner.get_entry(), full_scan_entry());
+}
+
+TEST_F(DeltaScannerTest, InPlaceModificationReusesUnchangedBlocks) {
+    // test that a modified block is recomputed and the rest reused
+    DeltaCache cache;
+    DeltaScanner scanner(cache);
+    ASSERT_TRUE(scanner.analyze(file.string(), block_options()));
+
+    {
+        std::fstream io(file, std::ios::binary | std::ios::in | std::ios::out);
+        io.seekp(3 * 512 + 10);
+        io << "modified";
+    }
+    bump_mtime();
+    ASSERT_TRUE(scanner.analyze(file.string(), block_options()));
+    EXPECT_EQ(scanner.get_blocks_reused(), 7);
+    EXPECT_EQ(scanner.get_entry(), full_scan_entry());
+}
+
+TEST_F(DeltaScannerTest, GlobalModeMergesHistograms) {
+    // test that global mode file entropy matches a full scan after an append
+    DeltaCache cache;
+    DeltaScanner scanner(cache);
+    ScanOptions options;
+    ASSERT_TRUE(scanner.analyze(file.string(), options));
+    write_blocks(file, 8, 300, std::ios::app);
+    bump_mtime();
+    ASSERT_TRUE(scanner.analyze(file.string(), options));
+
+    FileAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.analyze(file.string(), options));
+    EXPECT_DOUBLE_EQ(scanner.get_entry()["entropy"].get<double>(),
+                     analyzer.get_entry()["entropy"].get<double>());
+}
+
+TEST_F(DeltaScannerTest, MissingFileFails) {
+    // test that a missing file is reported as an error
+    DeltaCache cache;
+    DeltaScanner scanner(cache);
+    EXPECT_FALSE(scanner.analyze((file.string() + ".missing"), block_options()));
+    EXPECT_FALSE(scanner.get_error_message().empty());
+}
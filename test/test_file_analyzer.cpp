@@ -0,0 +1,288 @@
+#include <gtest/gtest.h>
+#include "file_analyzer.hpp"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class FileAnalyzerTest : public ::testing::Test {
+protected:
+    fs::path temp_dir;
+
+    void SetUp() override {
+        temp_dir = fs::temp_directory_path() / "entropix_test_analyzer";
+        fs::create_directories(temp_dir);
+        std::ofstream(temp_dir / "low.txt") << std::string(1024, 'A');
+        std::ofstream out(temp_dir / "high.bin", std::ios::binary);
+        for (int i = 0; i < 1024; ++i) out.put(static_cast<char>(i % 256));
+        out.close();
+        std::ofstream(temp_dir / "empty.txt").close();
+    }
+
+    void TearDown() override {
+        fs::remove_all(temp_dir);
+    }
+};
+
+TEST_F(FileAnalyzerTest, GlobalModeReportsHighEntropyFile) {
+    // test that a file above the threshold produces a global entry
+    FileAnalyzer analyzer;
+    ScanOptions options;
+    options.entropy_threshold = 7.0;
+    ASSERT_TRUE(analyzer.analyze((temp_dir / "high.bin").string(), options));
+    ASSERT_TRUE(analyzer.has_entry());
+    EXPECT_EQ(analyzer.get_entry()["type"], "global");
+    EXPECT_NEAR(analyzer.get_entry()["entropy"].get<double>(), 8.0, 1e-9);
+}
+
+TEST_F(FileAnalyzerTest, GlobalModeSkipsLowEntropyFile) {
+    // test that a file below the threshold produces no entry
+    FileAnalyzer analyzer;
+    ScanOptions options;
+    options.entropy_threshold = 1.0;
+    ASSERT_TRUE(analyzer.analyze((temp_dir / "low.txt").string(), options));
+    EXPECT_FALSE(analyzer.has_entry());
+}
+
+TEST_F(FileAnalyzerTest, BlockModeReportsBlocksAndFileEntropy) {
+    // test that block mode lists qualifying blocks and the file entropy
+    FileAnalyzer analyzer;
+    ScanOptions options;
+    options.block_size = 512;
+    ASSERT_TRUE(analyzer.analyze((temp_dir / "high.bin").string(), options));
+    ASSERT_TRUE(analyzer.has_entry());
+    const nlohmann::json& entry = analyzer.get_entry();
+    EXPECT_EQ(entry["type"], "block");
+    EXPECT_EQ(entry["blocks"].size(), 2);
+    EXPECT_EQ(entry["blocks"][1]["offset"], 512);
+    EXPECT_NEAR(entry["file_entropy"].get<double>(), 8.0, 1e-9);
+}
+
+TEST_F(FileAnalyzerTest, EmptyFileProducesNoEntry) {
+    // test that empty files are skipped instead of throwing
+    FileAnalyzer analyzer;
+    ScanOptions options;
+    options.block_size = 512;
+    EXPECT_TRUE(analyzer.analyze((temp_dir / "empty.txt").string(), options));
+    EXPECT_FALSE(analyzer.has_entry());
+}
+
+TEST_F(FileAnalyzerTest, MissingFileReportsError) {
+    // test that unreadable files fail with a message
+    FileAnalyzer analyzer;
+    EXPECT_FALSE(analyzer.analyze((temp_dir / "missing.bin").string(), ScanOptions{}));
+    EXPECT_FALSE(analyzer.get_error_message().empty());
+}
+
+TEST_F(FileAnalyzerTest, AnalyzeBufferUsesGivenPath) {
+    // test that in-memory analysis records the supplied path
+    std::vector<unsigned char> data(100, 'x');
+    FileAnalyzer analyzer;
+    analyzer.analyze_buffer("virtual/path", data.data(), data.size(), ScanOptions{});
+    ASSERT_TRUE(analyzer.has_entry());
+    EXPECT_EQ(analyzer.get_entry()["path"], "virtual/path");
+}
+
+TEST_F(FileAnalyzerTest, SmallFileLimitBoundaryMatchesBufferAnalysis) {
+    // test that files on either side of the small-file limit give the same results as in memory
+    for (size_t size : {FileAnalyzer::kSmallFileLimit, FileAnalyzer::kSmallFileLimit + 1}) {
+        std::vector<unsigned char> data(size);
+        for (size_t i = 0; i < size; ++i) data[i] = static_cast<unsigned char>((i * 31) ^ (i >> 7));
+        fs::path path = temp_dir / ("boundary" + std::to_string(size) + ".bin");
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), size);
+
+        ScanOptions options;
+        options.block_size = 4096;
+        FileAnalyzer from_file;
+        FileAnalyzer from_buffer;
+        ASSERT_TRUE(from_file.analyze(path.string(), options));
+        from_buffer.analyze_buffer(path.string(), data.data(), data.size(), options);
+        EXPECT_EQ(from_file.get_file_size(), size);
+        EXPECT_EQ(from_file.get_file_entropy(), from_buffer.get_file_entropy());
+        EXPECT_EQ(from_file.get_entry(), from_buffer.get_entry());
+    }
+}
+
+TEST_F(FileAnalyzerTest, SameNameInDifferentDirectories) {
+    // test that the cached directory descriptor is not reused for another directory
+    fs::create_directories(temp_dir / "a");
+    fs::create_directories(temp_dir / "b");
+    std::ofstream(temp_dir / "a" / "same.txt") << std::string(64, 'A');
+    std::ofstream(temp_dir / "b" / "same.txt") << "abcdefgh";
+
+    FileAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.analyze((temp_dir / "a" / "same.txt").string(), ScanOptions{}));
+    EXPECT_EQ(analyzer.get_file_entropy(), 0.0);
+    ASSERT_TRUE(analyzer.analyze((temp_dir / "b" / "same.txt").string(), ScanOptions{}));
+    EXPECT_NEAR(analyzer.get_file_entropy(), 3.0, 1e-9);
+}
+
+TEST_F(FileAnalyzerTest, RenamedAndRecreatedDirectory) {
+    // test that a directory renamed and re-created under the same path is not read through the old descriptor
+    // once revalidated, and that a removed one is noticed when opening through it fails
+    fs::create_directories(temp_dir / "dir");
+    std::ofstream(temp_dir / "dir" / "file.txt") << std::string(64, 'A');
+    std::string path = (temp_dir / "dir" / "file.txt").string();
+
+    FileAnalyzer analyzer;
+    ASSERT_TRUE(analyzer.analyze(path, ScanOptions{}));
+    EXPECT_EQ(analyzer.get_file_entropy(), 0.0);
+
+    fs::rename(temp_dir / "dir", temp_dir / "old");
+    fs::create_directories(temp_dir / "dir");
+    std::ofstream(temp_dir / "dir" / "file.txt") << "abcdefgh";
+    analyzer.revalidate_directory();
+    ASSERT_TRUE(analyzer.analyze(path, ScanOptions{}));
+    EXPECT_NEAR(analyzer.get_file_entropy(), 3.0, 1e-9);
+
+    fs::remove_all(temp_dir / "dir");
+    EXPECT_FALSE(analyzer.analyze(path, ScanOptions{}));
+    fs::rename(temp_dir / "old", temp_dir / "dir");
+    ASSERT_TRUE(analyzer.analyze(path, ScanOptions{})) << analyzer.get_error_message();
+    EXPECT_EQ(analyzer.get_file_entropy(), 0.0);
+}
+
+TEST_F(FileAnalyzerTest, ClaimedFileIsNotAnalyzed) {
+    // test that the probe filter sees the start of the file and a claimed file is left unanalyzed
+    FileAnalyzer analyzer;
+    ScanOptions options;
+    options.entropy_threshold = 7.0;
+    std::string seen;
+    bool claimed = false;
+    ASSERT_TRUE(analyzer.analyze((temp_dir / "high.bin").string(), options,
+        [&](const unsigned char* data, size_t size) {
+            seen.assign(reinterpret_cast<const char*>(data), size);
+            return true;
+        }, claimed));
+    EXPECT_TRUE(claimed);
+    EXPECT_FALSE(analyzer.has_entry());
+    ASSERT_EQ(seen.size(), 1024u);
+    EXPECT_EQ(static_cast<unsigned char>(seen[255]), 255);
+
+    ASSERT_TRUE(analyzer.analyze((temp_dir / "high.bin").string(), options,
+        [](const unsigned char*, size_t) { return false; }, claimed));
+    EXPECT_FALSE(claimed);
+    EXPECT_TRUE(analyzer.has_entry());
+}
+
+TEST_F(FileAnalyzerTest, DirectoryPathReportsError) {
+    // test that a directory passed as a file fails instead of reading as empty
+    FileAnalyzer analyzer;
+    EXPECT_FALSE(analyzer.analyze(temp_dir.string(), ScanOptions{}));
+    EXPECT_FALSE(analyzer.get_error_message().empty());
+}
+
+TEST_F(FileAnalyzerTest, TakeEntryMovesTheEntryOut) {
+    // test that take_entry() returns the same entry get_entry() would
+    FileAnalyzer analyzer;
+    ScanOptions options;
+    options.entropy_threshold = 7.0;
+    ASSERT_TRUE(analyzer.analyze((temp_dir / "high.bin").string(), options));
+    nlohmann::json expected = analyzer.get_entry();
+    ASSERT_TRUE(analyzer.analyze((temp_dir / "high.bin").string(), options));
+    EXPECT_EQ(analyzer.take_entry(), expected);
+}
+
+TEST_F(FileAnalyzerTest, PooledStreamingMatchesBufferAnalysis) {
+    // test that a large file streamed through a tiny pool gives the in-memory results
+    std::vector<unsigned char> data(300000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>((i / 5000) % 2 ? (i * 131) ^ (i >> 9) : 'q');
+    }
+    fs::path path = temp_dir / "streamed.bin";
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    ScanOptions options;
+    options.block_size = 512;
+    options.entropy_threshold = 6.0;
+    BufferPool pool(70000);  // room for one 64 KiB chunk at a time
+    FileAnalyzer from_file;
+    from_file.set_buffer_pool(&pool);
+    FileAnalyzer from_buffer;
+    ASSERT_TRUE(from_file.analyze(path.string(), options));
+    from_buffer.analyze_buffer(path.string(), data.data(), data.size(), options);
+    EXPECT_EQ(from_file.get_file_entropy(), from_buffer.get_file_entropy());
+    EXPECT_EQ(from_file.get_entry(), from_buffer.get_entry());
+    EXPECT_LE(pool.get_peak(), 70000u);
+}
+
+TEST_F(FileAnalyzerTest, StoppedStreamResumesToSameResults) {
+    // test that a stream stopped by the progress callback resumes to the uninterrupted results
+    std::vector<unsigned char> data(300000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>((i / 7000) % 2 ? (i * 167) ^ (i >> 7) : 'z');
+    }
+    fs::path path = temp_dir / "resumed.bin";
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    ScanOptions options;
+    options.block_size = 512;
+    options.entropy_threshold = 6.0;
+    BufferPool pool(70000);  // 64 KiB chunks, so the callback runs several times
+    FileAnalyzer analyzer;
+    analyzer.set_buffer_pool(&pool);
+    FileProgress saved;
+    analyzer.set_progress_callback([&](const FileProgress& progress) {
+        saved = progress;
+        return progress.offset < 128 * 1024;
+    });
+    EXPECT_FALSE(analyzer.analyze(path.string(), options));
+    EXPECT_EQ(saved.offset % options.block_size, 0u);
+    EXPECT_GE(saved.offset, 128u * 1024);
+
+    FileAnalyzer resumed;
+    resumed.set_buffer_pool(&pool);
+    ASSERT_TRUE(resumed.resume(path.string(), options, saved));
+    FileAnalyzer whole;
+    whole.analyze_buffer(path.string(), data.data(), data.size(), options);
+    EXPECT_EQ(resumed.get_file_size(), data.size());
+    EXPECT_EQ(resumed.get_file_entropy(), whole.get_file_entropy());
+    EXPECT_EQ(resumed.get_entry(), whole.get_entry());
+}
+
+TEST_F(FileAnalyzerTest, BlockSinkReceivesEveryBlockInRuns) {
+    // test that a streamed file's blocks reach the sink in order and the entry keeps the rest
+    std::vector<unsigned char> data(600000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<unsigned char>((i * 2654435761u) >> 13);
+    }
+    fs::path path = temp_dir / "sunk.bin";
+    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    ScanOptions options;
+    options.block_size = 64;
+    options.entropy_threshold = 0.0;  // every block qualifies, well over kBlockRun
+    FileAnalyzer whole;
+    whole.analyze_buffer(path.string(), data.data(), data.size(), options);
+    nlohmann::json expected = whole.get_entry();
+    expected["blocks"] = nlohmann::json::array();
+
+    BufferPool pool(70000);  // too small for a run, so each chunk goes out on its own
+    for (BufferPool* with : {static_cast<BufferPool*>(nullptr), &pool}) {
+        std::vector<std::pair<size_t, double>> sunk;
+        size_t runs = 0;
+        size_t firsts = 0;
+        FileAnalyzer analyzer;
+        analyzer.set_buffer_pool(with);
+        analyzer.set_block_sink([&](const std::vector<std::pair<size_t, double>>& blocks, bool first) {
+            sunk.insert(sunk.end(), blocks.begin(), blocks.end());
+            ++runs;
+            firsts += first;
+        });
+        ASSERT_TRUE(analyzer.analyze(path.string(), options));
+        EXPECT_EQ(firsts, 1u);
+        ASSERT_EQ(sunk.size(), data.size() / 64);
+        for (size_t i = 0; i < sunk.size(); ++i) {
+            EXPECT_EQ(sunk[i].first, whole.get_entry()["blocks"][i]["offset"].get<size_t>());
+            EXPECT_EQ(sunk[i].second, whole.get_entry()["blocks"][i]["entropy"].get<double>());
+        }
+        EXPECT_EQ(analyzer.get_sunk_block_count(), sunk.size());
+        EXPECT_TRUE(analyzer.has_entry());
+        EXPECT_EQ(analyzer.get_entry(), expected);
+        if (with) {
+            EXPECT_GT(runs, 1u);
+        }
+    }
+    EXPECT_LE(pool.get_peak(), 70000u);
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "file_reader.hpp"
+#include <filesystem>
+#include <iterator>
 #include <fstream>
 
 
@@ -62,3 +64,66 @@ TEST(FileReaderTest, GetErrorMessageOnFailure) {
     EXPECT_FALSE(reader.is_valid());
     EXPECT_FALSE(reader.get_error_message().empty());  // Should not be empty on failure
 }
+
+TEST(FileReaderTest, ReadRangeReturnsRequestedBytes) {
+    std::string temp_filename = "temp_range_file.txt";
+    std::ofstream outfile(temp_filename, std::ios::binary);
+    outfile << "0123456789";
+    outfile.close();
+
+    FileReader reader(temp_filename);
+    ASSERT_TRUE(reader.read_range(3, 4));
+    EXPECT_EQ(std::string(reader.get_data().begin(), reader.get_data().end()), "3456");
+    EXPECT_EQ(reader.get_file_size(), 10);
+
+    // a range running past the end is returned short
+    ASSERT_TRUE(reader.read_range(8, 10));
+    EXPECT_EQ(std::string(reader.get_data().begin(), reader.get_data().end()), "89");
+
+    std::remove(temp_filename.c_str());
+}
+
+TEST(FileReaderTest, ReadRangeOnNonexistentFileFails) {
+    FileReader reader("nonexistent_file.txt");
+    EXPECT_FALSE(reader.read_range(0, 16));
+    EXPECT_FALSE(reader.get_error_message().empty());
+}
+
+TEST(FileReaderTest, ReadFileDoesNotGrowPastFileSize) {
+    // test that a file read whole gets a buffer of its own size, not twice that
+    std::string temp_filename = "temp_exact_size.bin";
+    std::ofstream(temp_filename, std::ios::binary) << std::string(100000, 'x');
+
+    FileReader reader(temp_filename);
+    ASSERT_TRUE(reader.read_file());
+    EXPECT_EQ(reader.get_data().size(), 100000);
+    EXPECT_EQ(reader.get_data().capacity(), 100000);
+
+    std::remove(temp_filename.c_str());
+}
+
+TEST(FileReaderTest, ReadFileReadsPseudoFiles) {
+    // test that files reporting a size of 0, like those in /proc, are read whole
+    FileReader reader("/proc/self/maps");
+    ASSERT_TRUE(reader.read_file());
+    EXPECT_GT(reader.get_data().size(), 0);
+    EXPECT_EQ(reader.get_file_size(), reader.get_data().size());
+}
+
+TEST(FileReaderTest, DirectoryFailsOnEveryCall) {
+    // test that a failed open is not mistaken for an open file on the next call
+    std::string dir = (std::filesystem::temp_directory_path() / "entropix_test_reader_dir").string();
+    std::filesystem::create_directories(dir);
+    auto open_fds = [] {
+        return std::distance(std::filesystem::directory_iterator("/proc/self/fd"),
+                             std::filesystem::directory_iterator());
+    };
+    auto before = open_fds();
+    FileReader reader(dir);
+    EXPECT_FALSE(reader.read_file());
+    EXPECT_EQ(open_fds(), before);
+    EXPECT_FALSE(reader.read_file());
+    EXPECT_FALSE(reader.read_range(0, 16));
+    EXPECT_EQ(reader.get_error_message(), "Failed to open file: " + dir);
+    std::filesystem::remove_all(dir);
+}
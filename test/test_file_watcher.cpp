@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include "file_watcher.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+using namespace std::chrono_literals;
+
+class FileWatcherTest : public ::testing::Test {
+protected:
+    fs::path temp_dir;
+
+    void SetUp() override {
+        temp_dir = fs::temp_directory_path() / "entropix_test_watch";
+        fs::remove_all(temp_dir);
+        fs::create_directories(temp_dir / "sub");
+        std::ofstream(temp_dir / "existing.txt") << "existing";
+    }
+
+    void TearDown() override {
+        fs::remove_all(temp_dir);
+    }
+
+    // polls until at least one path is ready or the deadline passes
+    static std::vector<fs::path> poll_until_ready(FileWatcher& watcher, int max_ms = 2000) {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(max_ms);
+        while (std::chrono::steady_clock::now() < deadline) {
+            std::vector<fs::path> ready = watcher.poll(100);
+            if (!ready.empty()) return ready;
+        }
+        return {};
+    }
+};
+
+TEST_F(FileWatcherTest, ReportsFileClosedAfterWrite) {
+    // test that writing a file reports it once it has been closed
+    FileWatcher watcher(temp_dir, false, 20ms);
+    ASSERT_TRUE(watcher.start()) << watcher.get_error_message();
+    std::ofstream(temp_dir / "new.bin") << "data";
+
+    std::vector<fs::path> ready = poll_until_ready(watcher);
+    ASSERT_EQ(ready.size(), 1);
+    EXPECT_EQ(ready[0], temp_dir / "new.bin");
+}
+
+TEST_F(FileWatcherTest, DebouncesRepeatedWrites) {
+    // test that several writes in quick succession produce a single report
+    FileWatcher watcher(temp_dir, false, 100ms);
+    ASSERT_TRUE(watcher.start());
+    for (int i = 0; i < 5; ++i) {
+        std::ofstream(temp_dir / "busy.log", std::ios::app) << "line\n";
+    }
+    EXPECT_TRUE(watcher.poll(0).empty());  // still inside the debounce window
+
+    std::vector<fs::path> ready = poll_until_ready(watcher);
+    ASSERT_EQ(ready.size(), 1);
+    EXPECT_EQ(ready[0], temp_dir / "busy.log");
+    EXPECT_TRUE(watcher.poll(200).empty());
+}
+
+TEST_F(FileWatcherTest, IgnoresSubdirectoriesWhenNotRecursive) {
+    // test that non-recursive watchers ignore writes in subdirectories
+    FileWatcher watcher(temp_dir, false, 10ms);
+    ASSERT_TRUE(watcher.start());
+    std::ofstream(temp_dir / "sub" / "nested.bin") << "data";
+    EXPECT_TRUE(poll_until_ready(watcher, 300).empty());
+}
+
+TEST_F(FileWatcherTest, RecursiveWatchesNewDirectories) {
+    // test that files in existing and newly created subdirectories are reported
+    FileWatcher watcher(temp_dir, true, 10ms);
+    ASSERT_TRUE(watcher.start());
+    std::ofstream(temp_dir / "sub" / "nested.bin") << "data";
+    std::vector<fs::path> ready = poll_until_ready(watcher);
+    ASSERT_EQ(ready.size(), 1);
+    EXPECT_EQ(ready[0], temp_dir / "sub" / "nested.bin");
+
+    fs::create_directories(temp_dir / "later");
+    std::ofstream(temp_dir / "later" / "dropped.bin") << "data";
+    ready = poll_until_ready(watcher);
+    ASSERT_EQ(ready.size(), 1);
+    EXPECT_EQ(ready[0], temp_dir / "later" / "dropped.bin");
+}
+
+TEST_F(FileWatcherTest, SingleFileRootOnlyReportsThatFile) {
+    // test that watching a single file ignores its siblings
+    FileWatcher watcher(temp_dir / "existing.txt", false, 10ms);
+    ASSERT_TRUE(watcher.start());
+    std::ofstream(temp_dir / "other.txt") << "noise";
+    std::ofstream(temp_dir / "existing.txt") << "changed";
+    std::vector<fs::path> ready = poll_until_ready(watcher);
+    ASSERT_EQ(ready.size(), 1);
+    EXPECT_EQ(ready[0], temp_dir / "existing.txt");
+}
+
+TEST_F(FileWatcherTest, DeletedFileIsNotReported) {
+    // test that a file removed before its debounce expires is dropped
+    FileWatcher watcher(temp_dir, false, 200ms);
+    ASSERT_TRUE(watcher.start());
+    std::ofstream(temp_dir / "tmp.bin") << "data";
+    watcher.poll(50);
+    fs::remove(temp_dir / "tmp.bin");
+    EXPECT_TRUE(poll_until_ready(watcher, 500).empty());
+}
+
+TEST_F(FileWatcherTest, ReportsRemovedFiles) {
+    // test that deleted and moved-away files are reported by take_removed
+    fs::create_directories(temp_dir / "gone");
+    std::ofstream(temp_dir / "gone" / "inner.bin") << "inner";
+    fs::path outside = fs::temp_directory_path() / "entropix_test_watch_moved";
+    fs::remove_all(outside);
+    FileWatcher watcher(temp_dir, false, 20ms);
+    ASSERT_TRUE(watcher.start());
+    fs::remove(temp_dir / "existing.txt");
+    fs::rename(temp_dir / "gone", outside);
+    std::vector<fs::path> removed;
+    auto deadline = std::chrono::steady_clock::now() + 2s;
+    while (removed.size() < 2 && std::chrono::steady_clock::now() < deadline) {
+        watcher.poll(100);
+        for (const fs::path& path : watcher.take_removed()) removed.push_back(path);
+    }
+    fs::remove_all(outside);
+    ASSERT_EQ(removed.size(), 2);
+    EXPECT_EQ(removed[0], temp_dir / "existing.txt");
+    EXPECT_EQ(removed[1], temp_dir / "gone");
+    EXPECT_TRUE(watcher.take_removed().empty());
+}
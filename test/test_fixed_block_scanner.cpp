@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include "fixed_block_scanner.hpp"
+#include "block_entropy_scanner.hpp"
+#include "entropy_calculator.hpp"
+#include "scan_context.hpp"
+#include <cmath>
+#include <vector>
+
+static std::vector<unsigned char> make_pattern(size_t size, unsigned seed) {
+    std::vector<unsigned char> data(size);
+    unsigned state = seed;
+    for (size_t i = 0; i < size; ++i) {
+        state = state * 1103515245u + 12345u;
+        // mix random and repeated regions so entropies vary between blocks
+        data[i] = ((i / 700) % 3 == 0) ? 'A' : static_cast<unsigned char>(state >> 16);
+    }
+    return data;
+}
+
+static double reference_entropy(const unsigned char* data, size_t size) {
+    std::vector<unsigned char> block(data, data + size);
+    return EntropyCalculator(block).get_entropy();
+}
+
+TEST(FixedBlockScannerTest, ConstexprLog2MatchesStdLog2) {
+    // test that the compile-time log2 agrees with std::log2
+    for (double x : {1.0, 2.0, 3.0, 7.0, 100.0, 511.0, 4096.0, 65535.0}) {
+        EXPECT_NEAR(fixed_block_detail::constexpr_log2(x), std::log2(x), 1e-12);
+    }
+    static_assert(fixed_block_detail::constexpr_log2(512.0) == 9.0);
+}
+
+TEST(FixedBlockScannerTest, UniformBlockIsZeroEntropy) {
+    // test that a block of identical bytes has exactly zero entropy
+    std::vector<unsigned char> data(4096, 'Z');
+    EXPECT_DOUBLE_EQ(FixedBlockEntropyScanner<4096>::block_entropy(data.data()), 0.0);
+}
+
+TEST(FixedBlockScannerTest, AllByteValuesIsMaxEntropy) {
+    // test that every byte value equally often gives 8 bits per byte
+    std::vector<unsigned char> data(512);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<unsigned char>(i);
+    EXPECT_NEAR(FixedBlockEntropyScanner<512>::block_entropy(data.data()), 8.0, 1e-12);
+}
+
+TEST(FixedBlockScannerTest, LargeCountsBeyondTable) {
+    // test that counts larger than the constexpr table fall back correctly
+    std::vector<unsigned char> data(65536, 'A');
+    for (size_t i = 0; i < 10000; ++i) data[i] = 'B';
+    EXPECT_NEAR(FixedBlockEntropyScanner<65536>::block_entropy(data.data()),
+                reference_entropy(data.data(), data.size()), 1e-9);
+}
+
+template <size_t N>
+static void expect_matches_reference(const std::vector<unsigned char>& data, double min_entropy) {
+    ScanContext ctx;
+    const std::vector<std::pair<size_t, double>>& results =
+        FixedBlockEntropyScanner<N>::scan_blocks(data.data(), data.size(), min_entropy, ctx);
+
+    size_t expected_count = 0;
+    for (size_t offset = 0; offset < data.size(); offset += N) {
+        size_t len = std::min(N, data.size() - offset);
+        double expected = reference_entropy(data.data() + offset, len);
+        if (expected < min_entropy) continue;
+        ASSERT_LT(expected_count, results.size());
+        EXPECT_EQ(results[expected_count].first, offset);
+        EXPECT_NEAR(results[expected_count].second, expected, 1e-9);
+        ++expected_count;
+    }
+    EXPECT_EQ(results.size(), expected_count);
+}
+
+TEST(FixedBlockScannerTest, SpecializationsMatchGenericEntropy) {
+    // test each specialization against per-block EntropyCalculator results,
+    // including a trailing partial block
+    std::vector<unsigned char> data = make_pattern(3 * 65536 + 1234, 7);
+    expect_matches_reference<512>(data, 0.0);
+    expect_matches_reference<4096>(data, 0.0);
+    expect_matches_reference<65536>(data, 0.0);
+    expect_matches_reference<512>(data, 5.0);
+}
+
+TEST(FixedBlockScannerTest, DispatchedScanMatchesGenericSize) {
+    // test that the dispatched 512 path agrees with the generic path when
+    // a larger, non-specialized block size covers the same single block
+    std::vector<unsigned char> data = make_pattern(512, 3);
+    std::vector<std::pair<size_t, double>> fixed = BlockEntropyScanner::scan(data, 512);
+    std::vector<std::pair<size_t, double>> generic = BlockEntropyScanner::scan(data, 1000);
+    ASSERT_EQ(fixed.size(), 1);
+    ASSERT_EQ(generic.size(), 1);
+    EXPECT_NEAR(fixed[0].second, generic[0].second, 1e-9);
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include "io_scheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <thread>
+#include <vector>
+
+class IoSchedulerTest : public ::testing::Test {
+protected:
+    fs::path dir;
+    std::vector<fs::path> files;
+
+    void SetUp() override {
+        dir = fs::temp_directory_path() / "entropix_test_io_scheduler";
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        for (int i = 0; i < 16; ++i) {
+            fs::path path = dir / ("file" + std::to_string(i) + ".bin");
+            std::ofstream(path) << "data " << i;
+            files.push_back(path);
+        }
+        // directory-iterator order is arbitrary; reverse to make it differ from inode order
+        std::reverse(files.begin(), files.end());
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir);
+    }
+
+    static uint64_t inode_of(const fs::path& path) {
+        struct stat st;
+        stat(path.c_str(), &st);
+        return st.st_ino;
+    }
+};
+
+TEST_F(IoSchedulerTest, InodeOrderSortsByInode) {
+    // test that the inode order visits files by ascending inode number
+    IoSchedulerOptions options;
+    options.order = IoOrder::Inode;
+    IoScheduler scheduler(options);
+
+    std::vector<ScheduledFile> order = scheduler.plan(files);
+    ASSERT_EQ(order.size(), files.size());
+    for (size_t i = 1; i < order.size(); ++i) {
+        EXPECT_LE(inode_of(files[order[i - 1].index]), inode_of(files[order[i].index]));
+    }
+}
+
+TEST_F(IoSchedulerTest, DirectoryOrderKeepsInputAndPutsMissingFilesLast) {
+    // test that directory order is preserved and unreadable files are scheduled last
+    files.insert(files.begin(), dir / "missing.bin");
+    IoSchedulerOptions options;
+    options.order = IoOrder::Directory;
+    IoScheduler scheduler(options);
+
+    std::vector<ScheduledFile> order = scheduler.plan(files);
+    ASSERT_EQ(order.size(), files.size());
+    for (size_t i = 0; i + 1 < order.size(); ++i) {
+        EXPECT_EQ(order[i].index, i + 1);
+    }
+    EXPECT_EQ(order.back().index, 0u);
+    EXPECT_EQ(order.back().device, IoScheduler::kUnknownDevice);
+}
+
+TEST_F(IoSchedulerTest, ExtentOrderSchedulesEveryFile) {
+    // test that the extent order falls back cleanly where FIEMAP is unsupported
+    IoSchedulerOptions options;
+    options.order = IoOrder::Extent;
+    IoScheduler scheduler(options);
+
+    std::vector<ScheduledFile> order = scheduler.plan(files);
+    std::vector<size_t> indices;
+    for (const ScheduledFile& file : order) indices.push_back(file.index);
+    std::sort(indices.begin(), indices.end());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        EXPECT_EQ(indices[i], i);
+    }
+}
+
+TEST_F(IoSchedulerTest, ExtentOrderPutsUnmappedFilesAfterMappedOnes) {
+    // test that files without an extent are ordered by inode after the mapped files
+    for (int i = 0; i < 8; ++i) {
+        fs::path path = dir / ("empty" + std::to_string(i) + ".bin");
+        std::ofstream(path).flush();  // empty files have no extent
+        files.push_back(path);
+    }
+    std::ofstream(files[0], std::ios::binary) << std::string(8192, 'x') << std::flush;
+    IoSchedulerOptions options;
+    options.order = IoOrder::Extent;
+    IoScheduler scheduler(options);
+
+    std::vector<ScheduledFile> order = scheduler.plan(files);
+    ASSERT_EQ(order.size(), files.size());
+    for (size_t i = 1; i < order.size(); ++i) {
+        const ScheduledFile& a = order[i - 1];
+        const ScheduledFile& b = order[i];
+        EXPECT_FALSE(!a.mapped && b.mapped);
+        if (a.mapped == b.mapped) {
+            EXPECT_LE(a.location, b.location);
+        }
+        if (!b.mapped) {
+            EXPECT_EQ(b.location, inode_of(files[b.index]));
+        }
+    }
+}
+
+TEST_F(IoSchedulerTest, RunVisitsEveryFileOnce) {
+    // test that run() calls the work once per file with a valid worker index
+    IoSchedulerOptions options;
+    options.jobs = 4;
+    IoScheduler scheduler(options);
+
+    std::mutex mutex;
+    std::vector<int> visits(files.size(), 0);
+    scheduler.run(files, [&](size_t worker, size_t index) {
+        EXPECT_LT(worker, 4u);
+        std::lock_guard<std::mutex> lock(mutex);
+        visits[index]++;
+    });
+    for (int count : visits) {
+        EXPECT_EQ(count, 1);
+    }
+}
+
+TEST_F(IoSchedulerTest, DeviceDepthLimitsConcurrentWork) {
+    // test that no more than the device depth of calls run at once on one device
+    IoSchedulerOptions options;
+    options.jobs = 4;
+    options.rotational_depth = 1;
+    options.solid_state_depth = 1;
+    IoScheduler scheduler(options);
+
+    std::atomic<int> active{0};
+    std::atomic<int> peak{0};
+    scheduler.run(files, [&](size_t, size_t) {
+        int now = ++active;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        --active;
+    });
+    EXPECT_EQ(peak.load(), 1);
+}
+
+TEST_F(IoSchedulerTest, DevicesWithoutQueueAreNotRotational) {
+    // test that filesystems without a block queue get the solid-state depth
+    IoSchedulerOptions options;
+    options.jobs = 8;
+    IoScheduler scheduler(options);
+
+    uint64_t anonymous = makedev(0, 4242);
+    EXPECT_FALSE(IoScheduler::is_rotational(anonymous).has_value());
+    EXPECT_EQ(scheduler.get_device_depth(anonymous), 8u);
+}
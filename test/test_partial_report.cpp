@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include "partial_report.hpp"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class PartialReportTest : public ::testing::Test {
+protected:
+    fs::path dir;
+    std::vector<fs::path> files;
+
+    void SetUp() override {
+        dir = fs::temp_directory_path() / "entropix_test_partial";
+        fs::remove_all(dir);
+        fs::create_directories(dir);
+        // a large file with alternating text and noisy regions, and a few small ones
+        std::ofstream big(dir / "big.img", std::ios::binary);
+        for (int i = 0; i < 41000; ++i) {
+            big.put(static_cast<char>((i / 3000) % 2 ? (i * 131) ^ (i >> 5) : 'a' + i % 3));
+        }
+        big.close();
+        files.push_back(dir / "big.img");
+        for (int f = 0; f < 6; ++f) {
+            fs::path path = dir / ("small" + std::to_string(f) + ".bin");
+            std::ofstream out(path, std::ios::binary);
+            for (int i = 0; i < 700 + f * 100; ++i) out.put(static_cast<char>(f % 2 ? i * 7 : 'z'));
+            files.push_back(path);
+        }
+    }
+
+    void TearDown() override {
+        fs::remove_all(dir);
+    }
+
+    nlohmann::json single_node(const ScanOptions& options) {
+        nlohmann::json report = nlohmann::json::array();
+        FileAnalyzer analyzer;
+        for (const fs::path& path : files) {
+            EXPECT_TRUE(analyzer.analyze(path.string(), options));
+            if (analyzer.has_entry()) report.push_back(analyzer.get_entry());
+        }
+        return report;
+    }
+
+    nlohmann::json shard_report(const ShardSpec& spec, const ScanOptions& options, uint64_t split) {
+        ShardPlanner planner(spec, split, options.block_size);
+        PartialReport report(spec, options, planner.get_split_bytes());
+        PartialScanner scanner;
+        for (size_t i = 0; i < files.size(); ++i) {
+            std::string key = files[i].filename().string();
+            uint64_t size = fs::file_size(files[i]);
+            std::vector<ShardRange> ranges = planner.assign(key, size);
+            if (ranges.empty()) continue;
+            nlohmann::json jranges;
+            EXPECT_TRUE(scanner.scan(files[i].string(), ranges, options, jranges));
+            report.add_file(key, files[i].string(), i, size, jranges);
+        }
+        // round-trip through text, as a real merge would
+        return nlohmann::json::parse(report.to_json().dump());
+    }
+};
+
+TEST_F(PartialReportTest, MergedBlockScanMatchesSingleNode) {
+    // test that merging all shards of a block scan gives the single-node report
+    ScanOptions options;
+    options.block_size = 512;
+    options.entropy_threshold = 5.0;
+    PartialReportMerger merger;
+    for (size_t s = 0; s < 3; ++s) {
+        ASSERT_TRUE(merger.add(shard_report(ShardSpec{s, 3}, options, 4096)));
+    }
+    nlohmann::json merged;
+    ASSERT_TRUE(merger.finish(merged));
+    EXPECT_EQ(merged.dump(2), single_node(options).dump(2));
+}
+
+TEST_F(PartialReportTest, MergedGlobalScanMatchesSingleNode) {
+    // test that file entropy recomputed from summed histograms is exact
+    ScanOptions options;
+    options.entropy_threshold = 1.0;
+    PartialReportMerger merger;
+    for (size_t s = 0; s < 4; ++s) {
+        ASSERT_TRUE(merger.add(shard_report(ShardSpec{s, 4}, options, 5000)));
+    }
+    nlohmann::json merged;
+    ASSERT_TRUE(merger.finish(merged));
+    EXPECT_EQ(merged.dump(2), single_node(options).dump(2));
+}
+
+TEST_F(PartialReportTest, MissingShardFailsMerge) {
+    // test that a merge without every shard is rejected
+    ScanOptions options;
+    PartialReportMerger merger;
+    ASSERT_TRUE(merger.add(shard_report(ShardSpec{0, 2}, options, 4096)));
+    nlohmann::json merged;
+    EXPECT_FALSE(merger.finish(merged));
+    EXPECT_NE(merger.get_error_message().find("shard 1"), std::string::npos);
+}
+
+TEST_F(PartialReportTest, MismatchedOptionsOrDuplicateShardFail) {
+    // test that parts from a different scan or a repeated shard are rejected
+    ScanOptions options;
+    ScanOptions other;
+    other.entropy_threshold = 3.0;
+    PartialReportMerger merger;
+    ASSERT_TRUE(merger.add(shard_report(ShardSpec{0, 2}, options, 4096)));
+    EXPECT_FALSE(merger.add(shard_report(ShardSpec{1, 2}, other, 4096)));
+    EXPECT_FALSE(merger.add(shard_report(ShardSpec{0, 2}, options, 4096)));
+    EXPECT_FALSE(merger.add(nlohmann::json::object()));
+}
+
+TEST_F(PartialReportTest, ShardErrorsAreSkippedAndReported) {
+    // test that a file a shard could not read is left out of the merged report
+    ScanOptions options;
+    PartialReport report(ShardSpec{0, 1}, options, 4096);
+    report.add_error("gone.bin", "/x/gone.bin", 0, "Failed to open file: /x/gone.bin");
+    PartialReportMerger merger;
+    ASSERT_TRUE(merger.add(report.to_json()));
+    nlohmann::json merged;
+    ASSERT_TRUE(merger.finish(merged));
+    EXPECT_TRUE(merged.empty());
+    ASSERT_EQ(merger.get_file_errors().size(), 1u);
+}
@@ -0,0 +1,54 @@
+#include <gtest/gtest.h>
+#include "result_cache.hpp"
+
+static CachedResult make_result(const std::string& path) {
+    CachedResult result;
+    result.has_entry = true;
+    result.entry["path"] = path;
+    return result;
+}
+
+TEST(ResultCacheTest, MissThenHit) {
+    // test that a stored result is returned for the same key
+    ResultCache cache(4);
+    std::string key = ResultCache::make_key("a.bin", 10, 100, ScanOptions{});
+    EXPECT_FALSE(cache.get(key).has_value());
+    cache.put(key, make_result("a.bin"));
+    std::optional<CachedResult> hit = cache.get(key);
+    ASSERT_TRUE(hit.has_value());
+    EXPECT_EQ(hit->entry["path"], "a.bin");
+}
+
+TEST(ResultCacheTest, KeyChangesWithFileVersionAndOptions) {
+    // test that size, mtime and options all distinguish keys
+    ScanOptions options;
+    std::string base = ResultCache::make_key("a.bin", 10, 100, options);
+    EXPECT_NE(base, ResultCache::make_key("a.bin", 11, 100, options));
+    EXPECT_NE(base, ResultCache::make_key("a.bin", 10, 101, options));
+    options.block_size = 512;
+    EXPECT_NE(base, ResultCache::make_key("a.bin", 10, 100, options));
+    ScanOptions close_threshold;
+    close_threshold.entropy_threshold = 1e-9;
+    EXPECT_NE(base, ResultCache::make_key("a.bin", 10, 100, close_threshold));
+}
+
+TEST(ResultCacheTest, EvictsLeastRecentlyUsed) {
+    // test that the least recently used entry is evicted at capacity
+    ResultCache cache(2);
+    cache.put("a", make_result("a"));
+    cache.put("b", make_result("b"));
+    cache.get("a");                   // b is now least recently used
+    cache.put("c", make_result("c"));
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_TRUE(cache.get("a").has_value());
+    EXPECT_FALSE(cache.get("b").has_value());
+    EXPECT_TRUE(cache.get("c").has_value());
+}
+
+TEST(ResultCacheTest, ZeroCapacityDisablesCaching) {
+    // test that a zero-capacity cache stores nothing
+    ResultCache cache(0);
+    cache.put("a", make_result("a"));
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_FALSE(cache.get("a").has_value());
+}
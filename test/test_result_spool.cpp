@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include "result_spool.hpp"
+#include <utils.hpp>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+    nlohmann::json make_entry(int i) {
+        nlohmann::json entry;
+        entry["path"] = "dir/file" + std::to_string(i) + ".bin";
+        entry["entropy"] = 7.0 + i / 1000.0;
+        entry["blocks"] = nlohmann::json::array({{{"offset", i * 512}, {"entropy", 7.5}}});
+        return entry;
+    }
+
+    std::string expected_array(int count) {
+        nlohmann::json array = nlohmann::json::array();
+        for (int i = 0; i < count; ++i) array.push_back(make_entry(i));
+        std::ostringstream out;
+        utils::write_json_output(out, array);
+        return out.str();
+    }
+
+} // namespace
+
+TEST(ResultSpoolTest, InMemoryOutputMatchesJsonArray) {
+    // test that entries added out of order are written in position order, formatted like the report
+    ResultSpool spool(nullptr, 0);
+    std::vector<int> order(50);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937(7));
+    for (int i : order) ASSERT_TRUE(spool.add(i, make_entry(i)));
+
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out));
+    EXPECT_EQ(out.str(), expected_array(50));
+    EXPECT_EQ(spool.get_spill_count(), 0u);
+}
+
+TEST(ResultSpoolTest, SpilledOutputMatchesJsonArray) {
+    // test that a small memory limit spills runs and the merge restores the order
+    ResultSpool spool(nullptr, 2048);
+    std::vector<int> order(300);
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937(11));
+    for (int i : order) ASSERT_TRUE(spool.add(i, make_entry(i)));
+
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out));
+    EXPECT_GT(spool.get_spill_count(), 1u);
+    EXPECT_EQ(out.str(), expected_array(300));
+}
+
+TEST(ResultSpoolTest, SpillsWhenPoolRefuses) {
+    // test that the shared pool's budget also triggers spilling
+    BufferPool pool(4096);
+    ResultSpool spool(&pool, 0);
+    for (int i = 0; i < 100; ++i) ASSERT_TRUE(spool.add(i, make_entry(i)));
+    EXPECT_GT(spool.get_spill_count(), 0u);
+    EXPECT_LE(pool.get_peak(), 4096u);
+
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out));
+    EXPECT_EQ(out.str(), expected_array(100));
+}
+
+TEST(ResultSpoolTest, EmptySpoolWritesEmptyArray) {
+    // test that no entries produce the same "[]" as an empty report
+    ResultSpool spool(nullptr, 0);
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out));
+    EXPECT_EQ(out.str(), expected_array(0));
+}
+
+TEST(ResultSpoolTest, EntriesOfOnePositionKeepTheirOrder) {
+    // test that several entries under one position (archive members) stay in add order, also across spills
+    ResultSpool spool(nullptr, 300);  // a few entries per run
+    for (int i = 0; i < 30; ++i) ASSERT_TRUE(spool.add(i < 10 ? 2 : (i < 20 ? 0 : 1), make_entry(i)));
+    EXPECT_GT(spool.get_spill_count(), 1u);
+
+    nlohmann::json expected = nlohmann::json::array();
+    for (int i : {10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29,
+                  0, 1, 2, 3, 4, 5, 6, 7, 8, 9}) {
+        expected.push_back(make_entry(i));
+    }
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out)) << spool.get_error_message();
+    std::ostringstream want;
+    utils::write_json_output(want, expected);
+    EXPECT_EQ(out.str(), want.str());
+}
+
+TEST(ResultSpoolTest, StreamedEntriesMatchWholeEntries) {
+    // test that entries streamed run by run, interleaved with others and spilled, read like whole entries
+    auto block_entry = [](int i) {
+        nlohmann::json entry;
+        entry["path"] = "dir/large" + std::to_string(i) + ".bin";
+        entry["threshold"] = 7.0;
+        entry["type"] = "block";
+        entry["file_entropy"] = 7.25 + i / 100.0;
+        entry["blocks"] = nlohmann::json::array();
+        return entry;
+    };
+    auto blocks_of = [](int i, int run) {
+        std::vector<std::pair<size_t, double>> blocks;
+        for (int b = 0; b < 5; ++b) blocks.emplace_back((run * 5 + b) * 512u, 7.5 + i / 10.0 + b / 100.0);
+        return blocks;
+    };
+
+    ResultSpool spool(nullptr, 700);  // a few runs per spill
+    for (int run = 0; run < 4; ++run) {
+        for (int i : {3, 1}) ASSERT_TRUE(spool.add_blocks(i, blocks_of(i, run), run == 0));
+        ASSERT_TRUE(spool.add(run == 3 ? 4 : 0, make_entry(run)));
+    }
+    for (int i : {1, 3}) ASSERT_TRUE(spool.end_blocks(i, block_entry(i)));
+    ASSERT_TRUE(spool.add(2, make_entry(9)));
+    EXPECT_GT(spool.get_spill_count(), 1u);
+    EXPECT_EQ(spool.size(), 7u);
+
+    nlohmann::json expected = nlohmann::json::array();
+    for (int i : {0, 1, 2}) expected.push_back(make_entry(i));
+    for (int i : {1, 9, 3}) {
+        if (i == 9) {
+            expected.push_back(make_entry(9));
+            continue;
+        }
+        nlohmann::json entry = block_entry(i);
+        for (int run = 0; run < 4; ++run) {
+            for (const auto& [offset, entropy] : blocks_of(i, run)) {
+                entry["blocks"].push_back({{"offset", offset}, {"entropy", entropy}});
+            }
+        }
+        expected.push_back(entry);
+    }
+    expected.push_back(make_entry(3));
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out)) << spool.get_error_message();
+    std::ostringstream want;
+    utils::write_json_output(want, expected);
+    EXPECT_EQ(out.str(), want.str());
+}
+
+TEST(ResultSpoolTest, UnfinishedStreamIsLeftOut) {
+    // test that the runs of a file that failed mid-stream do not reach the report
+    ResultSpool spool(nullptr, 0);
+    std::vector<std::pair<size_t, double>> blocks = {{0, 7.9}, {512, 7.8}};
+    ASSERT_TRUE(spool.add_blocks(0, blocks, true));
+    ASSERT_TRUE(spool.add(0, make_entry(0)));  // the next member of the same archive
+    ASSERT_TRUE(spool.add_blocks(1, blocks, true));
+    ASSERT_TRUE(spool.add(2, make_entry(2)));
+    EXPECT_FALSE(spool.end_blocks(5, make_entry(5)));
+
+    nlohmann::json expected = nlohmann::json::array({make_entry(0), make_entry(2)});
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out));
+    std::ostringstream want;
+    utils::write_json_output(want, expected);
+    EXPECT_EQ(out.str(), want.str());
+}
@@ -0,0 +1,245 @@
+#include <gtest/gtest.h>
+#include "scan_checkpoint.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+class ScanCheckpointTest : public ::testing::Test {
+protected:
+    fs::path temp_dir;
+    fs::path state;
+    std::vector<fs::path> files;
+    json scan = {{"root", "/evidence"}, {"threshold", 7.5}, {"block_size", 512}};
+
+    void SetUp() override {
+        temp_dir = fs::temp_directory_path() / "entropix_test_checkpoint";
+        fs::create_directories(temp_dir);
+        state = temp_dir / "scan.ckpt";
+        for (int i = 0; i < 4; ++i) {
+            files.push_back(temp_dir / ("f" + std::to_string(i) + ".bin"));
+            std::ofstream(files.back(), std::ios::binary) << std::string(4096, static_cast<char>('a' + i));
+        }
+    }
+
+    void TearDown() override {
+        fs::remove_all(temp_dir);
+    }
+
+    static json entry(int i) {
+        return {{"path", "f" + std::to_string(i) + ".bin"}, {"entropy", 7.75}};
+    }
+};
+
+TEST_F(ScanCheckpointTest, ResumeRestoresCompletedFilesProgressAndEntries) {
+    // test that a written checkpoint brings back completed files, journaled entries and file progress
+    {
+        ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+        ASSERT_TRUE(checkpoint.begin(scan, files)) << checkpoint.get_error_message();
+        json e2 = entry(2);
+        ASSERT_TRUE(checkpoint.complete(2, &e2));
+        ASSERT_TRUE(checkpoint.complete(0, nullptr));
+        FileProgress progress;
+        progress.offset = 1024;
+        progress.histogram['d'] = 1024;
+        progress.blocks = {{0, 7.9}, {512, 7.8}};
+        ASSERT_TRUE(checkpoint.update_progress(3, files[3], progress));
+        ASSERT_TRUE(checkpoint.write()) << checkpoint.get_error_message();
+    }
+
+    ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+    ResultSpool spool(nullptr, 0);
+    bool found = false;
+    ASSERT_TRUE(checkpoint.resume(scan, files, spool, found)) << checkpoint.get_error_message();
+    EXPECT_TRUE(found);
+    EXPECT_EQ(checkpoint.get_completed_count(), 2u);
+    EXPECT_TRUE(checkpoint.is_complete(0));
+    EXPECT_FALSE(checkpoint.is_complete(1));
+    EXPECT_TRUE(checkpoint.is_complete(2));
+
+    FileProgress progress;
+    ASSERT_TRUE(checkpoint.get_progress(3, files[3], progress));
+    EXPECT_EQ(progress.offset, 1024u);
+    EXPECT_EQ(progress.histogram['d'], 1024u);
+    ASSERT_EQ(progress.blocks.size(), 2u);
+    EXPECT_EQ(progress.blocks[1].first, 512u);
+    EXPECT_FALSE(checkpoint.get_progress(1, files[1], progress));
+
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out));
+    EXPECT_EQ(json::parse(out.str()), json::array({entry(2)}));
+}
+
+TEST_F(ScanCheckpointTest, WorkAfterLastCheckpointIsRedone) {
+    // test that journal lines written after the last checkpoint are dropped on resume
+    {
+        ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+        ASSERT_TRUE(checkpoint.begin(scan, files));
+        json e1 = entry(1);
+        ASSERT_TRUE(checkpoint.complete(1, &e1));
+        ASSERT_TRUE(checkpoint.write());
+        json e3 = entry(3);
+        ASSERT_TRUE(checkpoint.complete(3, &e3));  // interval not reached: journal only
+    }
+
+    ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+    ResultSpool spool(nullptr, 0);
+    bool found = false;
+    ASSERT_TRUE(checkpoint.resume(scan, files, spool, found)) << checkpoint.get_error_message();
+    EXPECT_TRUE(checkpoint.is_complete(1));
+    EXPECT_FALSE(checkpoint.is_complete(3));
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out));
+    EXPECT_EQ(json::parse(out.str()), json::array({entry(1)}));
+}
+
+TEST_F(ScanCheckpointTest, ChangedFileRestartsFromZero) {
+    // test that progress of a file modified since the checkpoint is not reused
+    {
+        ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+        ASSERT_TRUE(checkpoint.begin(scan, files));
+        FileProgress progress;
+        progress.offset = 2048;
+        ASSERT_TRUE(checkpoint.update_progress(0, files[0], progress));
+        ASSERT_TRUE(checkpoint.write());
+    }
+    std::ofstream(files[0], std::ios::app) << "appended";
+
+    ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+    ResultSpool spool(nullptr, 0);
+    bool found = false;
+    ASSERT_TRUE(checkpoint.resume(scan, files, spool, found));
+    FileProgress progress;
+    EXPECT_FALSE(checkpoint.get_progress(0, files[0], progress));
+}
+
+TEST_F(ScanCheckpointTest, RejectsDifferentScanOrFileList) {
+    // test that a checkpoint only resumes the scan and file list it was taken from
+    {
+        ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+        ASSERT_TRUE(checkpoint.begin(scan, files));
+    }
+    ResultSpool spool(nullptr, 0);
+    bool found = false;
+
+    json other = scan;
+    other["block_size"] = 4096;
+    ScanCheckpoint different_options(state.string(), std::chrono::hours(1));
+    EXPECT_FALSE(different_options.resume(other, files, spool, found));
+
+    std::vector<fs::path> fewer(files.begin(), files.end() - 1);
+    ScanCheckpoint different_files(state.string(), std::chrono::hours(1));
+    EXPECT_FALSE(different_files.resume(scan, fewer, spool, found));
+    EXPECT_NE(ScanCheckpoint::hash_files(files), ScanCheckpoint::hash_files(fewer));
+
+    std::ofstream(state) << "{ not json";
+    ScanCheckpoint corrupt(state.string(), std::chrono::hours(1));
+    EXPECT_FALSE(corrupt.resume(scan, files, spool, found));
+}
+
+TEST_F(ScanCheckpointTest, MissingCheckpointStartsFreshAndRemoveCleansUp) {
+    // test that resuming without a checkpoint begins a new one, and remove() deletes both files
+    ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+    ResultSpool spool(nullptr, 0);
+    bool found = true;
+    ASSERT_TRUE(checkpoint.resume(scan, files, spool, found));
+    EXPECT_FALSE(found);
+    EXPECT_EQ(checkpoint.get_completed_count(), 0u);
+    EXPECT_TRUE(fs::exists(state));
+    EXPECT_TRUE(fs::exists(state.string() + ".journal"));
+
+    checkpoint.remove();
+    EXPECT_FALSE(fs::exists(state));
+    EXPECT_FALSE(fs::exists(state.string() + ".journal"));
+}
+
+TEST_F(ScanCheckpointTest, SeveralEntriesOfOneFileReplayInOrder) {
+    // test that the entries of an archive's members come back in their original order
+    {
+        ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+        ASSERT_TRUE(checkpoint.begin(scan, files));
+        json e3 = entry(3);
+        json e1 = entry(1);
+        json e2 = entry(2);
+        ASSERT_TRUE(checkpoint.complete_member(1, files[1], &e3));
+        ASSERT_TRUE(checkpoint.complete_member(1, files[1], &e1));
+        ASSERT_TRUE(checkpoint.complete_member(1, files[1], &e2));
+        ASSERT_TRUE(checkpoint.complete(1, nullptr));
+        ASSERT_TRUE(checkpoint.write());
+    }
+    ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+    ResultSpool spool(nullptr, 0);
+    bool found = false;
+    ASSERT_TRUE(checkpoint.resume(scan, files, spool, found));
+    EXPECT_TRUE(checkpoint.is_complete(1));
+    EXPECT_EQ(checkpoint.get_member_count(1), 0u);
+    std::ostringstream out;
+    ASSERT_TRUE(spool.write_array(out));
+    EXPECT_EQ(json::parse(out.str()), json::array({entry(3), entry(1), entry(2)}));
+}
+
+TEST_F(ScanCheckpointTest, ArchiveInProgressKeepsItsMembers) {
+    // test that an unfinished archive resumes after its journaled members, and refuses to if it changed
+    {
+        ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+        ASSERT_TRUE(checkpoint.begin(scan, files));
+        json e0 = entry(0);
+        ASSERT_TRUE(checkpoint.complete_member(2, files[2], &e0));
+        ASSERT_TRUE(checkpoint.complete_member(2, files[2], nullptr));
+        ASSERT_TRUE(checkpoint.write());
+    }
+    {
+        ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+        ResultSpool spool(nullptr, 0);
+        bool found = false;
+        ASSERT_TRUE(checkpoint.resume(scan, files, spool, found)) << checkpoint.get_error_message();
+        EXPECT_FALSE(checkpoint.is_complete(2));
+        EXPECT_EQ(checkpoint.get_member_count(2), 2u);
+        FileProgress progress;
+        EXPECT_FALSE(checkpoint.get_progress(2, files[2], progress));
+        std::ostringstream out;
+        ASSERT_TRUE(spool.write_array(out));
+        EXPECT_EQ(json::parse(out.str()), json::array({entry(0)}));
+    }
+
+    std::ofstream(files[2], std::ios::binary | std::ios::app) << "more";
+    ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+    ResultSpool spool(nullptr, 0);
+    bool found = false;
+    EXPECT_FALSE(checkpoint.resume(scan, files, spool, found));
+    EXPECT_NE(checkpoint.get_error_message().find("changed"), std::string::npos);
+}
+
+TEST_F(ScanCheckpointTest, StreamedPrefixRoundTrips) {
+    // test that a streamed scan's completed prefix and aggregates come back on resume
+    json aggregates = json::array({{{"files", 3}}, {{"files", 5}}});
+    uint64_t hash = ScanCheckpoint::hash_files({files[0], files[1]});
+    EXPECT_EQ(ScanCheckpoint::hash_files({files[1]}, ScanCheckpoint::hash_files({files[0]})), hash);
+    {
+        ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+        ASSERT_TRUE(checkpoint.begin(scan, {}));
+        uint64_t count = 0;
+        uint64_t list_hash = 0;
+        json restored;
+        EXPECT_FALSE(checkpoint.get_prefix(count, list_hash, restored));
+        ASSERT_TRUE(checkpoint.complete_prefix(2, hash, aggregates));
+        ASSERT_TRUE(checkpoint.write());
+    }
+
+    ScanCheckpoint checkpoint(state.string(), std::chrono::hours(1));
+    ResultSpool spool(nullptr, 0);
+    bool found = false;
+    ASSERT_TRUE(checkpoint.resume(scan, {}, spool, found)) << checkpoint.get_error_message();
+    EXPECT_EQ(checkpoint.get_completed_count(), 2u);
+    uint64_t count = 0;
+    uint64_t list_hash = 0;
+    json restored;
+    ASSERT_TRUE(checkpoint.get_prefix(count, list_hash, restored));
+    EXPECT_EQ(count, 2u);
+    EXPECT_EQ(list_hash, hash);
+    EXPECT_EQ(restored, aggregates);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "scan_context.hpp"
+#include "block_entropy_scanner.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Count every global allocation so tests can assert steady-state scans are
+// allocation-free. Replacing operator new here applies to the whole test binary.
+static std::atomic<size_t> g_allocations{0};
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+static std::vector<unsigned char> make_mixed_data(size_t size) {
+    std::vector<unsigned char> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<unsigned char>((i * 131) ^ (i >> 3));
+    }
+    return data;
+}
+
+TEST(ScanContextTest, MatchesVectorOverload) {
+    // test that the context overload produces the same results as the vector overload
+    std::vector<unsigned char> data = make_mixed_data(5000);
+    ScanContext ctx;
+    std::vector<std::pair<size_t, double>> expected = BlockEntropyScanner::scan(data, 512, 1.0);
+    const std::vector<std::pair<size_t, double>>& results =
+        BlockEntropyScanner::scan(data.data(), data.size(), 512, 1.0, ctx);
+    ASSERT_EQ(results.size(), expected.size());
+    for (size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].first, expected[i].first);
+        EXPECT_DOUBLE_EQ(results[i].second, expected[i].second);
+    }
+}
+
+TEST(ScanContextTest, ResultsAreResetBetweenScans) {
+    // test that a second scan does not append to the first scan's results
+    std::vector<unsigned char> data = make_mixed_data(2048);
+    ScanContext ctx;
+    BlockEntropyScanner::scan(data.data(), data.size(), 512, 0.0, ctx);
+    const std::vector<std::pair<size_t, double>>& results =
+        BlockEntropyScanner::scan(data.data(), 1024, 512, 0.0, ctx);
+    EXPECT_EQ(results.size(), 2);
+}
+
+TEST(ScanContextTest, SteadyStateScanDoesNotAllocate) {
+    // test that once warmed up, scanning through a context allocates nothing
+    std::vector<unsigned char> first = make_mixed_data(64 * 1024);
+    std::vector<unsigned char> second = make_mixed_data(32 * 1024);
+    ScanContext ctx;
+    BlockEntropyScanner::scan(first.data(), first.size(), 512, 0.0, ctx);  // warm-up
+
+    size_t before = g_allocations.load();
+    for (int i = 0; i < 10; ++i) {
+        BlockEntropyScanner::scan(first.data(), first.size(), 512, 0.0, ctx);
+        BlockEntropyScanner::scan(second.data(), second.size(), 4096, 0.0, ctx);
+    }
+    EXPECT_EQ(g_allocations.load(), before);
+}
+
+TEST(ScanContextTest, PreallocatedContextDoesNotAllocate) {
+    // test that a context sized up front never allocates, even on the first scan
+    std::vector<unsigned char> data = make_mixed_data(8192);
+    ScanContext ctx(16);
+    size_t before = g_allocations.load();
+    BlockEntropyScanner::scan(data.data(), data.size(), 512, 0.0, ctx);
+    EXPECT_EQ(g_allocations.load(), before);
+}
+
+TEST(ScanContextTest, ScratchOnlyGrows) {
+    // test that the scratch buffer keeps its size when smaller requests follow
+    ScanContext ctx(0, 128);
+    EXPECT_GE(ctx.scratch(64).size(), 128);
+    EXPECT_GE(ctx.scratch(1024).size(), 1024);
+    size_t before = g_allocations.load();
+    EXPECT_GE(ctx.scratch(512).size(), 1024);
+    EXPECT_EQ(g_allocations.load(), before);
+}
+
+TEST(ScanContextTest, RejectsEmptyRange) {
+    // test that an empty range is rejected like the vector overload
+    ScanContext ctx;
+    std::vector<unsigned char> data(16, 'A');
+    EXPECT_THROW(BlockEntropyScanner::scan(data.data(), 0, 512, 0.0, ctx), std::invalid_argument);
+}
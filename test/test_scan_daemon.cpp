@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include "scan_daemon.hpp"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+class ScanDaemonTest : public ::testing::Test {
+protected:
+    fs::path temp_dir;
+    std::string socket_path;
+    std::unique_ptr<ScanDaemon> daemon;
+    std::thread server;
+
+    void SetUp() override {
+        temp_dir = fs::temp_directory_path() / "entropix_test_daemon";
+        fs::create_directories(temp_dir / "sub");
+        std::ofstream(temp_dir / "low.txt") << std::string(2048, 'A');
+        std::ofstream out(temp_dir / "sub" / "high.bin", std::ios::binary);
+        for (int i = 0; i < 2048; ++i) out.put(static_cast<char>((i * 7) % 256));
+        out.close();
+
+        socket_path = (temp_dir / "entropix.sock").string();
+        DaemonOptions options;
+        options.socket_path = socket_path;
+        options.workers = 2;
+        daemon = std::make_unique<ScanDaemon>(options);
+        ASSERT_TRUE(daemon->start()) << daemon->get_error_message();
+        server = std::thread([this] { daemon->run(); });
+    }
+
+    void TearDown() override {
+        daemon->stop();
+        server.join();
+        daemon.reset();
+        fs::remove_all(temp_dir);
+    }
+
+    int connect_client() {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+        EXPECT_EQ(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0);
+        return fd;
+    }
+
+    // sends one request line and collects replies up to and including "done"
+    std::vector<json> request(int fd, const json& req) {
+        std::string line = req.dump() + "\n";
+        EXPECT_EQ(::write(fd, line.data(), line.size()), static_cast<ssize_t>(line.size()));
+        std::vector<json> replies;
+        std::string buffer;
+        char chunk[4096];
+        for (;;) {
+            size_t newline;
+            while ((newline = buffer.find('\n')) != std::string::npos) {
+                json reply = json::parse(buffer.substr(0, newline));
+                buffer.erase(0, newline + 1);
+                replies.push_back(reply);
+                if (reply.value("done", false)) return replies;
+            }
+            ssize_t n = ::read(fd, chunk, sizeof(chunk));
+            if (n <= 0) return replies;
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+    }
+};
+
+TEST_F(ScanDaemonTest, StreamsEntriesAndSummary) {
+    // test that a recursive request streams matching entries then a done line
+    int fd = connect_client();
+    json req = {{"id", 7}, {"path", temp_dir.string()}, {"recursive", true}, {"threshold", 5.0}};
+    std::vector<json> replies = request(fd, req);
+    ::close(fd);
+
+    ASSERT_EQ(replies.size(), 2);
+    EXPECT_EQ(replies[0]["id"], 7);
+    EXPECT_EQ(replies[0]["entry"]["path"], (temp_dir / "sub" / "high.bin").string());
+    EXPECT_TRUE(replies[1]["done"].get<bool>());
+    EXPECT_EQ(replies[1]["files"], 2);
+    EXPECT_EQ(replies[1]["reported"], 1);
+}
+
+TEST_F(ScanDaemonTest, RepeatedRequestIsServedFromCache) {
+    // test that unchanged files are answered from the result cache
+    int fd = connect_client();
+    json req = {{"id", 1}, {"path", temp_dir.string()}, {"recursive", true}, {"block_size", 512}};
+    std::vector<json> first = request(fd, req);
+    std::vector<json> second = request(fd, req);
+    ::close(fd);
+
+    ASSERT_FALSE(first.empty());
+    ASSERT_EQ(first.size(), second.size());
+    EXPECT_EQ(first.back()["cached"], 0);
+    EXPECT_EQ(second.back()["cached"], 2);
+}
+
+TEST_F(ScanDaemonTest, MalformedRequestGetsError) {
+    // test that invalid JSON and bad options are rejected without closing the connection
+    int fd = connect_client();
+    std::vector<json> bad = request(fd, json("not an object"));
+    ASSERT_EQ(bad.size(), 1);
+    EXPECT_TRUE(bad[0].contains("error"));
+
+    std::vector<json> bad_threshold = request(fd, {{"id", 2}, {"path", temp_dir.string()}, {"threshold", 9.0}});
+    ASSERT_EQ(bad_threshold.size(), 1);
+    EXPECT_EQ(bad_threshold[0]["id"], 2);
+    EXPECT_TRUE(bad_threshold[0].contains("error"));
+
+    std::vector<json> missing = request(fd, {{"id", 3}, {"path", (temp_dir / "nope").string()}});
+    ASSERT_EQ(missing.size(), 1);
+    EXPECT_TRUE(missing[0].contains("error"));
+    ::close(fd);
+}
+
+TEST_F(ScanDaemonTest, ServesConcurrentClients) {
+    // test that several connections can be served at the same time
+    std::vector<std::thread> clients;
+    std::atomic<int> ok{0};
+    for (int i = 0; i < 4; ++i) {
+        clients.emplace_back([&, i] {
+            int fd = connect_client();
+            std::vector<json> replies = request(fd, {{"id", i}, {"path", temp_dir.string()}, {"recursive", true}});
+            ::close(fd);
+            if (!replies.empty() && replies.back().value("done", false) && replies.back()["id"] == i) ++ok;
+        });
+    }
+    for (std::thread& t : clients) t.join();
+    EXPECT_EQ(ok.load(), 4);
+}
+
+TEST_F(ScanDaemonTest, NonUtf8PathDoesNotStopTheDaemon) {
+    // test that a file name that is not valid UTF-8 is reported and the daemon keeps serving
+    {
+        std::ofstream out(temp_dir / "bad\xff.bin", std::ios::binary);
+        for (int i = 0; i < 2048; ++i) out.put(static_cast<char>((i * 7) % 256));
+    }
+    int fd = connect_client();
+    std::vector<json> replies = request(fd, {{"id", 1}, {"path", temp_dir.string()},
+                                             {"recursive", true}, {"threshold", 5.0}});
+    ASSERT_FALSE(replies.empty());
+    EXPECT_TRUE(replies.back().value("done", false));
+    EXPECT_EQ(replies.back()["files"], 3);
+    EXPECT_EQ(replies.back()["reported"], 2);
+
+    std::vector<json> again = request(fd, {{"id", 2}, {"path", temp_dir.string()}, {"recursive", true}});
+    ASSERT_FALSE(again.empty());
+    EXPECT_EQ(again.back()["id"], 2);
+    ::close(fd);
+}
+
+TEST_F(ScanDaemonTest, RefusesConnectionsBeyondTheLimit) {
+    // test that a client over max_connections gets an error line instead of a thread
+    DaemonOptions options;
+    options.socket_path = (temp_dir / "limited.sock").string();
+    options.workers = 1;
+    options.max_connections = 1;
+    ScanDaemon limited(options);
+    ASSERT_TRUE(limited.start()) << limited.get_error_message();
+    std::thread limited_server([&] { limited.run(); });
+
+    std::string saved = socket_path;
+    socket_path = options.socket_path;
+    int first = connect_client();
+    std::vector<json> served = request(first, {{"id", 1}, {"path", temp_dir.string()}});
+    ASSERT_FALSE(served.empty());
+    EXPECT_FALSE(served.back().contains("error"));
+
+    int second = connect_client();
+    std::string reply;
+    char chunk[256];
+    ssize_t n;
+    while ((n = ::read(second, chunk, sizeof(chunk))) > 0) reply.append(chunk, static_cast<size_t>(n));
+    socket_path = saved;
+    ::close(second);
+    ::close(first);
+    limited.stop();
+    limited_server.join();
+
+    ASSERT_FALSE(reply.empty());
+    json refused = json::parse(reply.substr(0, reply.find('\n')));
+    EXPECT_EQ(refused["error"], "Too many connections.");
+    EXPECT_TRUE(refused["done"].get<bool>());
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include "shard_planner.hpp"
+#include <string>
+#include <vector>
+
+TEST(ShardPlannerTest, ParsesShardSpec) {
+    // test that i/N is accepted only for 0 <= i < N
+    ShardSpec spec;
+    EXPECT_TRUE(ShardSpec::parse("2/5", spec));
+    EXPECT_EQ(spec.index, 2u);
+    EXPECT_EQ(spec.count, 5u);
+    EXPECT_FALSE(ShardSpec::parse("5/5", spec));
+    EXPECT_FALSE(ShardSpec::parse("1/0", spec));
+    EXPECT_FALSE(ShardSpec::parse("1", spec));
+    EXPECT_FALSE(ShardSpec::parse("a/3", spec));
+    EXPECT_FALSE(ShardSpec::parse("1/3x", spec));
+    EXPECT_EQ(spec.index, 2u);
+}
+
+TEST(ShardPlannerTest, SmallFilesBelongToExactlyOneShard) {
+    // test that every small file is owned whole by exactly one shard
+    const size_t shards = 4;
+    std::vector<size_t> per_shard(shards, 0);
+    for (int f = 0; f < 200; ++f) {
+        std::string key = "dir/file" + std::to_string(f) + ".bin";
+        size_t owners = 0;
+        for (size_t s = 0; s < shards; ++s) {
+            ShardPlanner planner(ShardSpec{s, shards}, 1 << 20, 512);
+            std::vector<ShardRange> ranges = planner.assign(key, 1000);
+            if (!ranges.empty()) {
+                ++owners;
+                ++per_shard[s];
+                ASSERT_EQ(ranges.size(), 1u);
+                EXPECT_EQ(ranges[0].offset, 0u);
+                EXPECT_EQ(ranges[0].length, 1000u);
+            }
+        }
+        EXPECT_EQ(owners, 1u);
+    }
+    for (size_t count : per_shard) {
+        EXPECT_GT(count, 0u);  // the hash spreads files over all shards
+    }
+}
+
+TEST(ShardPlannerTest, LargeFilesSplitIntoAlignedRangesCoveredOnce) {
+    // test that a large file's ranges are block-aligned and cover it exactly once
+    const size_t shards = 3;
+    const uint64_t size = 10000;
+    std::vector<int> covered(size, 0);
+    for (size_t s = 0; s < shards; ++s) {
+        ShardPlanner planner(ShardSpec{s, shards}, 1500, 512);
+        EXPECT_EQ(planner.get_split_bytes(), 1024u);
+        for (const ShardRange& range : planner.assign("big.img", size)) {
+            EXPECT_EQ(range.offset % 512, 0u);
+            for (uint64_t i = range.offset; i < range.offset + range.length; ++i) {
+                covered[i]++;
+            }
+        }
+    }
+    for (int count : covered) {
+        ASSERT_EQ(count, 1);
+    }
+}
+
+TEST(ShardPlannerTest, EmptyFilesAreNotAssigned) {
+    // test that empty files produce no work on any shard
+    ShardPlanner planner(ShardSpec{0, 1}, 1024, 0);
+    EXPECT_TRUE(planner.assign("empty.txt", 0).empty());
+}
@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "summary_aggregate.hpp"
+#include <string>
+
+TEST(SummaryAggregateTest, CountsFilesBytesAndHistogram) {
+    // test totals and entropy histogram placement, including entropy 8.0
+    SummaryAggregate summary("/scan");
+    summary.add("/scan/a.bin", 100, 7.99, true);
+    summary.add("/scan/b.txt", 50, 8.0, true);
+    summary.add("/scan/c.txt", 10, 0.0, false);
+    nlohmann::json report = summary.to_json(7.5);
+
+    EXPECT_EQ(report["files"], 3);
+    EXPECT_EQ(report["bytes"], 160);
+    EXPECT_EQ(report["flagged"], 2);
+    const nlohmann::json& counts = report["entropy_histogram"]["counts"];
+    ASSERT_EQ(counts.size(), SummaryAggregate::kEntropyBins);
+    EXPECT_EQ(counts[0], 1);
+    EXPECT_EQ(counts[SummaryAggregate::kEntropyBins - 1], 2);
+}
+
+TEST(SummaryAggregateTest, RollsUpByExtensionAndDirectory) {
+    // test per-extension and first-level directory rollups
+    SummaryAggregate summary("/scan");
+    summary.add("/scan/docs/a.txt", 10, 4.0, false);
+    summary.add("/scan/docs/deep/b.txt", 10, 6.0, false);
+    summary.add("/scan/top.bin", 10, 7.0, true);
+    nlohmann::json report = summary.to_json(6.5);
+
+    EXPECT_EQ(report["extensions"][".txt"]["files"], 2);
+    EXPECT_DOUBLE_EQ(report["extensions"][".txt"]["mean_entropy"].get<double>(), 5.0);
+    EXPECT_EQ(report["extensions"][".bin"]["flagged"], 1);
+    EXPECT_EQ(report["directories"]["docs"]["files"], 2);
+    EXPECT_DOUBLE_EQ(report["directories"]["docs"]["max_entropy"].get<double>(), 6.0);
+    EXPECT_EQ(report["directories"]["."]["files"], 1);
+}
+
+TEST(SummaryAggregateTest, TopKKeepsHighestEntropyFiles) {
+    // test that only the K highest-entropy files are kept, highest first
+    SummaryAggregate summary("/scan", 3);
+    for (int i = 0; i < 100; ++i) {
+        summary.add("/scan/f" + std::to_string(i), 1, i * 0.08, false);
+    }
+    nlohmann::json top = summary.to_json(0.0)["top_files"];
+    ASSERT_EQ(top.size(), 3);
+    EXPECT_EQ(top[0]["path"], "/scan/f99");
+    EXPECT_EQ(top[1]["path"], "/scan/f98");
+    EXPECT_EQ(top[2]["path"], "/scan/f97");
+}
+
+TEST(SummaryAggregateTest, GroupsAreBounded) {
+    // test that distinct extensions beyond the limit fold into "(other)"
+    SummaryAggregate summary("/scan", 10, 4);
+    for (int i = 0; i < 50; ++i) {
+        summary.add("/scan/file.e" + std::to_string(i), 1, 1.0, false);
+    }
+    nlohmann::json extensions = summary.to_json(0.0)["extensions"];
+    EXPECT_EQ(extensions.size(), 4);
+    EXPECT_EQ(extensions[SummaryAggregate::kOtherGroup]["files"], 47);
+}
+
+TEST(SummaryAggregateTest, MergeMatchesSingleAggregate) {
+    // test that merging per-worker aggregates equals aggregating everything at once
+    SummaryAggregate all("/scan", 5);
+    SummaryAggregate left("/scan", 5);
+    SummaryAggregate right("/scan", 5);
+    for (int i = 0; i < 40; ++i) {
+        std::string path = "/scan/d" + std::to_string(i % 3) + "/f" + std::to_string(i) + (i % 2 ? ".bin" : ".txt");
+        double entropy = (i * 37 % 80) / 10.0;
+        all.add(path, i, entropy, entropy > 6.0);
+        (i % 2 ? left : right).add(path, i, entropy, entropy > 6.0);
+    }
+    left.add_error();
+    all.add_error();
+    left.merge(right);
+
+    nlohmann::json merged = left.to_json(6.0);
+    nlohmann::json expected = all.to_json(6.0);
+    EXPECT_EQ(merged["files"], expected["files"]);
+    EXPECT_EQ(merged["errors"], expected["errors"]);
+    EXPECT_EQ(merged["entropy_histogram"], expected["entropy_histogram"]);
+    EXPECT_EQ(merged["directories"], expected["directories"]);
+    EXPECT_EQ(merged["top_files"], expected["top_files"]);
+}
+
+TEST(SummaryAggregateTest, StateRoundTripContinuesExactly) {
+    // test that an aggregate restored from its state, through text, ends exactly like one that never stopped
+    SummaryAggregate whole("/scan", 5, 4);
+    SummaryAggregate first("/scan", 5, 4);
+    for (int i = 0; i < 20; ++i) {
+        std::string path = "/scan/d" + std::to_string(i % 6) + "/f" + std::to_string(i) + ".e" + std::to_string(i % 5);
+        double entropy = (i * 37 % 80) / 10.0 + 1.0 / 3.0;
+        whole.add(path, i, entropy, entropy > 6.0);
+        if (i < 10) first.add(path, i, entropy, entropy > 6.0);
+    }
+    first.add_error();
+    whole.add_error();
+
+    SummaryAggregate restored("/scan", 5, 4);
+    restored.load_state(nlohmann::json::parse(first.to_state().dump()));
+    for (int i = 10; i < 20; ++i) {
+        std::string path = "/scan/d" + std::to_string(i % 6) + "/f" + std::to_string(i) + ".e" + std::to_string(i % 5);
+        double entropy = (i * 37 % 80) / 10.0 + 1.0 / 3.0;
+        restored.add(path, i, entropy, entropy > 6.0);
+    }
+    EXPECT_EQ(restored.to_json(6.0).dump(), whole.to_json(6.0).dump());
+    EXPECT_EQ(restored.to_state(), whole.to_state());
+}
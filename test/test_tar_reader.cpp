@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include "tar_reader.hpp"
+#include "tar_builder.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace tar_builder;
+
+namespace {
+
+    // a ByteSource over bytes in memory
+    class MemorySource : public ByteSource {
+    public:
+        explicit MemorySource(std::string bytes) : bytes_(std::move(bytes)) {}
+
+        bool read(unsigned char* buffer, size_t length, size_t& bytes_read) override {
+            bytes_read = std::min(length, bytes_.size() - position_);
+            std::memcpy(buffer, bytes_.data() + position_, bytes_read);
+            position_ += bytes_read;
+            return true;
+        }
+
+        const std::string& get_error_message() const override { return error_message_; }
+
+    private:
+        std::string bytes_;
+        size_t position_ = 0;
+        std::string error_message_;
+    };
+
+    std::string read_all(TarReader& tar) {
+        std::string out;
+        unsigned char buffer[100];
+        size_t got = 0;
+        while (tar.read(buffer, sizeof(buffer), got) && got > 0) {
+            out.append(reinterpret_cast<char*>(buffer), got);
+        }
+        return out;
+    }
+
+} // namespace
+
+TEST(TarReaderTest, ReadsUstarMembersAndSkipsOtherEntries) {
+    // test that regular members are returned with their data while directories and links are skipped
+    std::string first(700, 'x');
+    MemorySource source(header("dir/", 0, '5') + entry("./dir/a.bin", first)
+                        + header("dir/link", 0, '2') + header("b.txt", 5, '0', "deep/prefix")
+                        + padded("hello") + end_marker());
+    TarReader tar(source);
+    TarMember member;
+    ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+    EXPECT_EQ(member.path, "dir/a.bin");
+    EXPECT_EQ(member.size, 700u);
+    EXPECT_EQ(read_all(tar), first);
+    ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+    EXPECT_EQ(member.path, "deep/prefix/b.txt");
+    // not reading a member is fine; next() skips what is left of it
+    EXPECT_FALSE(tar.next(member));
+    EXPECT_EQ(tar.get_error_message(), "");
+}
+
+TEST(TarReaderTest, GnuLongNamesAndPaxHeaders) {
+    // test that GNU 'L' names and pax path/size records override the header fields
+    std::string long_name(150, 'n');
+    std::string pax = "28 path=pax/with spaces.bin\n" "10 size=3\n";
+    MemorySource source(entry("././@LongLink", long_name + '\0', 'L') + entry("truncated", "data")
+                        + entry("PaxHeaders/x", pax, 'x') + header("short", 99) + padded("abc")
+                        + end_marker());
+    TarReader tar(source);
+    TarMember member;
+    ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+    EXPECT_EQ(member.path, long_name);
+    EXPECT_EQ(read_all(tar), "data");
+    ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+    EXPECT_EQ(member.path, "pax/with spaces.bin");
+    EXPECT_EQ(member.size, 3u);
+    EXPECT_EQ(read_all(tar), "abc");
+    EXPECT_FALSE(tar.next(member));
+    EXPECT_EQ(tar.get_error_message(), "");
+}
+
+TEST(TarReaderTest, HardLinksAndSparseFilesAreReturnedWithoutData) {
+    // test that hard links carry their target (header, GNU 'K' or pax linkpath) and sparse files are marked
+    std::string long_target(130, 't');
+    auto pax_record = [](const std::string& key, const std::string& value) {
+        std::string body = " " + key + "=" + value + "\n";
+        size_t length = body.size() + 1;
+        while (std::to_string(length).size() + body.size() != length) ++length;
+        return std::to_string(length) + body;
+    };
+    MemorySource source(entry("a.bin", "aaaa") + hard_link("b.bin", "./a.bin")
+                        + entry("././@LongLink", long_target + '\0', 'K') + hard_link("c.bin", "ignored")
+                        + entry("PaxHeaders/d", pax_record("linkpath", "pax/target"), 'x')
+                        + hard_link("d.bin", "ignored")
+                        + entry("old.sparse", "stored", 'S')
+                        + entry("PaxHeaders/e", pax_record("GNU.sparse.name", "real.bin")
+                                + pax_record("GNU.sparse.realsize", "100000"), 'x')
+                        + entry("GNUSparseFile.0/real.bin", "map and data")
+                        + entry("last.bin", "zz") + end_marker());
+    TarReader tar(source);
+    TarMember member;
+    ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+    EXPECT_EQ(member.kind, TarMember::Kind::File);
+    std::vector<std::pair<std::string, std::string>> links;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+        EXPECT_EQ(member.kind, TarMember::Kind::HardLink);
+        EXPECT_EQ(read_all(tar), "");
+        links.emplace_back(member.path, member.link_target);
+    }
+    EXPECT_EQ(links, (std::vector<std::pair<std::string, std::string>>{
+        {"b.bin", "a.bin"}, {"c.bin", long_target}, {"d.bin", "pax/target"}}));
+    ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+    EXPECT_EQ(member.kind, TarMember::Kind::Sparse);
+    EXPECT_EQ(member.path, "old.sparse");
+    EXPECT_EQ(read_all(tar), "");
+    ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+    EXPECT_EQ(member.kind, TarMember::Kind::Sparse);
+    EXPECT_EQ(member.path, "real.bin");
+    ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+    EXPECT_EQ(member.kind, TarMember::Kind::File);
+    EXPECT_EQ(member.path, "last.bin");
+    EXPECT_EQ(read_all(tar), "zz");
+    EXPECT_FALSE(tar.next(member));
+    EXPECT_EQ(tar.get_error_message(), "");
+}
+
+TEST(TarReaderTest, Base256SizeField) {
+    // test that GNU binary size fields (used from 8 GiB on) are decoded
+    std::string block = header("big.bin", 0, '0', "", true);
+    block.replace(124, 12, std::string("\x80\0\0\0\0\0\0\0\0\0\0\x06", 12));
+    block.replace(148, 8, "        ");
+    unsigned sum = 0;
+    for (unsigned char c : block) sum += c;
+    char octal[8];
+    std::snprintf(octal, sizeof(octal), "%06o", sum);
+    block.replace(148, 7, std::string(octal, 6) + '\0');
+
+    MemorySource source(block + padded("sixsix") + end_marker());
+    TarReader tar(source);
+    TarMember member;
+    ASSERT_TRUE(tar.next(member)) << tar.get_error_message();
+    EXPECT_EQ(member.size, 6u);
+    EXPECT_EQ(read_all(tar), "sixsix");
+}
+
+TEST(TarReaderTest, ReportsCorruptAndTruncatedArchives) {
+    // test that a bad checksum and data cut short are errors, not a clean end
+    std::string bad = entry("a.bin", "payload");
+    bad[10] ^= 0x20;
+    MemorySource corrupt(bad + end_marker());
+    TarReader corrupt_tar(corrupt);
+    TarMember member;
+    EXPECT_FALSE(corrupt_tar.next(member));
+    EXPECT_NE(corrupt_tar.get_error_message().find("Bad tar header"), std::string::npos);
+
+    MemorySource truncated(header("a.bin", 2000) + std::string(1000, 'q'));
+    TarReader truncated_tar(truncated);
+    ASSERT_TRUE(truncated_tar.next(member));
+    read_all(truncated_tar);
+    EXPECT_NE(truncated_tar.get_error_message().find("Truncated"), std::string::npos);
+    EXPECT_FALSE(truncated_tar.next(member));
+}
+
+TEST(TarReaderTest, SkippingPastTheEndIsTruncation) {
+    // test that a file cut inside a member that is skipped, not read, is an error rather than the end
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "entropix_test_tar_skip.tar";
+    std::string full = entry("a.bin", std::string(5000, 'a')) + entry("b.bin", "b") + end_marker();
+    std::ofstream(path, std::ios::binary) << full.substr(0, 512 + 3000);
+    FileSource file(path.string());
+    TarReader tar(file);
+    TarMember member;
+    ASSERT_TRUE(tar.next(member));
+    EXPECT_FALSE(tar.next(member));
+    EXPECT_NE(tar.get_error_message().find("Truncated"), std::string::npos);
+    std::filesystem::remove(path);
+
+    // a nested reader asking for more than its member holds fails on its own
+    MemorySource source(entry("inner.tar", header("big.bin", 4096)) + end_marker());
+    TarReader outer(source);
+    ASSERT_TRUE(outer.next(member));
+    ByteSource& member_data = outer;  // not the copy constructor
+    TarReader inner(member_data);
+    ASSERT_TRUE(inner.next(member));
+    EXPECT_FALSE(inner.next(member));
+    EXPECT_NE(inner.get_error_message().find("Truncated"), std::string::npos);
+    EXPECT_EQ(outer.get_error_message(), "");
+    EXPECT_FALSE(outer.next(member));
+    EXPECT_EQ(outer.get_error_message(), "");
+}
+
+TEST(TarReaderTest, IsHeaderNeedsMagicAndChecksum) {
+    // test that only genuine ustar/GNU headers are recognized
+    std::string block = header("a.bin", 1);
+    EXPECT_TRUE(TarReader::is_header(reinterpret_cast<const unsigned char*>(block.data())));
+    EXPECT_TRUE(TarReader::is_header(
+        reinterpret_cast<const unsigned char*>(header("a.bin", 1, '0', "", true).data())));
+    block[0] = 'b';
+    EXPECT_FALSE(TarReader::is_header(reinterpret_cast<const unsigned char*>(block.data())));
+    std::string data(512, 'u');
+    EXPECT_FALSE(TarReader::is_header(reinterpret_cast<const unsigned char*>(data.data())));
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <mutex>
+#include <thread>
+
+TEST(ThreadPoolTest, RunsAllTasks) {
+    // test that every submitted task runs exactly once
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool(4, 2);
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&count](size_t) { ++count; });
+        }
+        pool.wait_idle();
+        EXPECT_EQ(count.load(), 100);
+    }
+}
+
+TEST(ThreadPoolTest, WorkerIndicesAreInRange) {
+    // test that tasks receive valid, per-thread worker indices
+    ThreadPool pool(3, 8);
+    std::mutex mutex;
+    std::set<size_t> seen;
+    for (int i = 0; i < 50; ++i) {
+        pool.submit([&](size_t worker) {
+            std::lock_guard<std::mutex> lock(mutex);
+            seen.insert(worker);
+        });
+    }
+    pool.wait_idle();
+    for (size_t worker : seen) {
+        EXPECT_LT(worker, pool.size());
+    }
+}
+
+TEST(ThreadPoolTest, SubmitBlocksWhenQueueIsFull) {
+    // test that a full queue applies backpressure to the submitter
+    ThreadPool pool(1, 1);
+    std::atomic<bool> release{false};
+    pool.submit([&](size_t) { while (!release) std::this_thread::yield(); });  // occupies the worker
+    pool.submit([](size_t) {});                                                 // fills the queue
+
+    std::atomic<bool> submitted{false};
+    std::thread producer([&] {
+        pool.submit([](size_t) {});
+        submitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(submitted.load());
+
+    release = true;
+    producer.join();
+    EXPECT_TRUE(submitted.load());
+    pool.wait_idle();
+}
+
+TEST(ThreadPoolTest, DestructorDrainsQueue) {
+    // test that queued tasks still run when the pool is destroyed
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool(1, 16);
+        for (int i = 0; i < 10; ++i) {
+            pool.submit([&count](size_t) { ++count; });
+        }
+    }
+    EXPECT_EQ(count.load(), 10);
+}
@@ -2,6 +2,7 @@
 #include "utils.hpp"
 #include <filesystem>
 #include <fstream>
+#include <algorithm>
 
 namespace fs = std::filesystem;
 
@@ -67,3 +68,48 @@ TEST_F(CollectFilesTest, FiltersByExtensionCorrectly) {
         EXPECT_EQ(path.extension(), ".bin");
     }
 }
+
+TEST_F(CollectFilesTest, ForEachFileVisitsSameFilesAsCollect) {
+    std::vector<fs::path> visited;
+    utils::for_each_file(temp_dir, false, ".bin", [&](const fs::path& path) {
+        visited.push_back(path);
+    });
+    std::vector<fs::path> collected = utils::collect_files(temp_dir, false, ".bin");
+    std::sort(visited.begin(), visited.end());
+    std::sort(collected.begin(), collected.end());
+    EXPECT_EQ(visited, collected);
+}
+
+TEST(ParseSizeTest, AcceptsPlainAndSuffixedSizes) {
+    uint64_t bytes = 0;
+    EXPECT_TRUE(utils::parse_size("4096", bytes));
+    EXPECT_EQ(bytes, 4096u);
+    EXPECT_TRUE(utils::parse_size("64k", bytes));
+    EXPECT_EQ(bytes, 64u << 10);
+    EXPECT_TRUE(utils::parse_size("512M", bytes));
+    EXPECT_EQ(bytes, 512ull << 20);
+    EXPECT_TRUE(utils::parse_size("2G", bytes));
+    EXPECT_EQ(bytes, 2ull << 30);
+}
+
+TEST(ParseSizeTest, RejectsMalformedSizes) {
+    uint64_t bytes = 7;
+    EXPECT_FALSE(utils::parse_size("", bytes));
+    EXPECT_FALSE(utils::parse_size("M", bytes));
+    EXPECT_FALSE(utils::parse_size("12X", bytes));
+    EXPECT_FALSE(utils::parse_size("1GB", bytes));
+    EXPECT_FALSE(utils::parse_size("99999999999T", bytes));
+    EXPECT_EQ(bytes, 7u);
+}
+
+TEST_F(CollectFilesTest, ReturnsFilesSortedByPath) {
+    // test that the list does not follow the filesystem's directory order
+    fs::create_directories(temp_dir / "sub");
+    std::ofstream(temp_dir / "sub" / "e.bin") << "nested";
+    std::ofstream(temp_dir / "0.bin") << "first";
+    std::vector<fs::path> files = utils::collect_files(temp_dir, true);
+    ASSERT_EQ(files.size(), 6);
+    EXPECT_TRUE(std::is_sorted(files.begin(), files.end()));
+    EXPECT_EQ(files.front(), temp_dir / "0.bin");
+    EXPECT_EQ(files.back(), temp_dir / "sub" / "e.bin");
+}